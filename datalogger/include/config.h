@@ -8,11 +8,60 @@
 // Cantidad de lecturas para los sensores
 #define NUM_READINGS 10
 
+// Referencia nominal del ADC (12 bits, atenuación 11dB). Solo se usa antes
+// de AdcCalibration::begin(); luego manda la tabla caracterizada por eFuse
+#define ADC_VREF 3.3f
+#define ADC_MAX_COUNT 4095.0f
+#define ADC_DEFAULT_VREF 1100           // mV, solo si el chip no tiene calibración en eFuse
+
 // Pines para los sensores analógicos
 #define ANALOG_SENSOR_PH 4
 #define ANALOG_SENSOR_DO 5
 #define ANALOG_SENSOR_EC 6
 
+// Muestreo continuo por DMA (0 = analogRead() bloqueante en cada update)
+#ifndef ANALOG_USE_DMA
+#define ANALOG_USE_DMA 1
+#endif
+#define ADC_DMA_SAMPLE_RATE 2000        // Conversiones/s totales (ESP32-S3: 611-83333)
+#define ADC_DMA_FRAME_SIZE 256          // Bytes por frame DMA (4 bytes por conversión)
+#define ADC_RING_SIZE 64                // Muestras guardadas por canal (potencia de 2)
+#define ADC_TASK_PRIORITY 5
+#define ADC_TASK_STACK 4096
+#define ADC_TASK_CORE 1
+
+// Filtro de ventana deslizante por canal (tamaños en muestras)
+#define ANALOG_FILTER_MAX_WINDOW 64
+#define ANALOG_PH_WINDOW 32
+#define ANALOG_DO_WINDOW 32
+#define ANALOG_EC_WINDOW 64
+#ifndef ANALOG_FILTER_MODE
+#define ANALOG_FILTER_MODE 2            // 0 = media, 1 = mediana, 2 = media recortada
+#endif
+#define ANALOG_FILTER_TRIM 4            // Muestras descartadas en cada extremo (media recortada)
+
+// Sobremuestreo: 4^n muestras por salida, diezmadas a 12+n bits (n = 0..3).
+// Los filtros trabajan sobre las salidas diezmadas
+#define ANALOG_MAX_OVERSAMPLE 3
+#if ANALOG_USE_DMA
+#define ANALOG_DEFAULT_OVERSAMPLE 2     // 500 Hz/canal → ~31 salidas/s de 14 bits
+#else
+#define ANALOG_DEFAULT_OVERSAMPLE 0     // Con analogRead() solo hay NUM_READINGS por update
+#endif
+
+// Compensación por temperatura (temperatura del agua del sonar)
+#define TEMP_COMP_EC_ALPHA 0.02f        // Coeficiente lineal de EC (1/°C), referencia 25°C
+#define TEMP_COMP_MIN_C -5              // Rango de las tablas por grado
+#define TEMP_COMP_MAX_C 45
+#define TEMP_COMP_MAX_AGE_MS 10000      // Temperatura más vieja que esto no se usa
+
+// Calibración multipunto: un cal_* con la misma referencia que un punto
+// guardado (dentro de esta diferencia, en unidades del sensor) lo reemplaza.
+// Soluciones distintas, como 1413 y 1400 µS/cm, quedan como puntos separados
+#define CAL_PH_SAME_POINT 0.005f
+#define CAL_DO_SAME_POINT 0.005f        // mg/L
+#define CAL_EC_SAME_POINT 0.5f          // µS/cm
+
 /*
  * SD LOGGER
  */
@@ -21,6 +70,124 @@
 #define SD_MOSI_PIN 12
 #define SD_MISO_PIN 14
 #define SD_SCK_PIN 13
+#define SD_SPI_FREQ_HZ 4000000
+#define SD_MOUNT_POINT "/sd"                // Punto de montaje VFS (para truncate())
+
+// Bus de la tarjeta: SPI o el host SDMMC del S3 con 1 o 4 líneas de datos.
+// SDMMC usa el mismo zócalo (CS = DAT3, MOSI = CMD, SCK = CLK, MISO = DAT0);
+// el modo 4-bit agrega DAT1 y DAT2. Todas las líneas llevan pull-up de 10k
+#define SD_BUS_SPI 0
+#define SD_BUS_SDMMC_1BIT 1
+#define SD_BUS_SDMMC_4BIT 2
+#ifndef SD_BUS_MODE
+#define SD_BUS_MODE SD_BUS_SPI
+#endif
+#define SD_MMC_CLK_PIN SD_SCK_PIN
+#define SD_MMC_CMD_PIN SD_MOSI_PIN
+#define SD_MMC_D0_PIN SD_MISO_PIN
+#define SD_MMC_D1_PIN 9
+#define SD_MMC_D2_PIN 10
+#define SD_MMC_D3_PIN SD_CS_PIN
+#define SD_MMC_FREQ_KHZ 40000               // High speed; 20000 si la tarjeta o el cableado no lo soportan
+
+// Formato del archivo: 0 = CSV, 1 = binario con esquema y CRC por registro
+// (convertir a CSV en la PC con tools/usvlog)
+#ifndef SD_LOG_BINARY
+#define SD_LOG_BINARY 0
+#endif
+
+// Binario comprimido: cada campo en punto fijo como delta zig-zag/varint
+// contra el registro anterior (ver delta_codec.h). Requiere SD_LOG_BINARY
+#ifndef SD_LOG_COMPRESSED
+#define SD_LOG_COMPRESSED 0
+#endif
+#define SD_DELTA_KEYFRAME_INTERVAL 30       // Registro absoluto cada N (1 min a 2 s por muestra)
+
+#if SD_LOG_COMPRESSED && !SD_LOG_BINARY
+#error "SD_LOG_COMPRESSED requiere SD_LOG_BINARY=1"
+#endif
+
+// Journal: cada registro en un frame con largo, secuencia y CRC-32, para
+// recuperar el archivo tras un corte de energía (ver log_journal.h)
+#ifndef SD_LOG_JOURNAL
+#define SD_LOG_JOURNAL 0
+#endif
+
+#if SD_LOG_JOURNAL
+#define SD_LOG_EXTENSION ".jnl"
+#elif SD_LOG_BINARY
+#define SD_LOG_EXTENSION ".bin"
+#else
+#define SD_LOG_EXTENSION ".csv"
+#endif
+
+// Escritura por lotes con el archivo abierto: solo se escriben sectores
+// completos y el flush (actualización de FAT y directorio) va por política
+#define SD_SECTOR_SIZE 512
+#define SD_BATCH_BUFFER_SIZE (8 * SD_SECTOR_SIZE)   // Tamaño de cada buffer de escritura
+#define SD_FLUSH_RECORDS 30                 // Flush cada N registros...
+#define SD_FLUSH_INTERVAL_MS 60000          // ...o cada T ms (lo que ocurra primero)
+
+// Escritura diferida: los productores llenan un buffer mientras una tarea
+// propia escribe los llenos en la SD
+#define SD_BUFFER_COUNT 3                   // Buffers de SD_BATCH_BUFFER_SIZE bytes
+#define SD_WRITER_TASK_CORE 0
+#define SD_WRITER_TASK_PRIORITY 1           // Por debajo de adquisición y almacenamiento
+#define SD_WRITER_TASK_STACK 4096
+#define SD_WRITER_POLL_MS 100               // Periodo para revisar la política de flush
+#define SD_WRITER_RETRY_MS 1000             // Espera tras un error de apertura o escritura
+#define SD_CLOSE_TIMEOUT_MS 5000            // Espera máxima de close() a la tarea
+
+// Tarjeta ausente o con errores: la tarea la da por perdida tras N ciclos
+// fallidos seguidos y reintenta montarla cada SD_WRITER_RETRY_MS. Mientras
+// tanto, con los buffers llenos, los registros esperan en un spool en PSRAM
+// o, en módulos sin PSRAM (los entornos de platformio.ini), en uno más chico
+// en la RAM interna
+#define SD_REMOUNT_AFTER_ERRORS 3
+#define SD_SPOOL_RECORDS 32768              // ~2 MB de SampleRecord (~18 h a 2 s por muestra)
+#define SD_SPOOL_INTERNAL_RECORDS 512       // ~32 KB de RAM interna (~17 min a 2 s por muestra)
+#define SD_SPOOL_DRAIN_BATCH 64             // Registros del spool pasados a los buffers por registro nuevo
+
+// Respaldo en la flash interna: sin tarjeta por más de
+// SD_FLASH_FALLBACK_AFTER_MS el log sigue en un archivo nuevo (mismo formato)
+// en la partición LittleFS, y vuelve a la SD en cuanto se monta. Comando dump_flash
+#ifndef SD_FLASH_FALLBACK
+#define SD_FLASH_FALLBACK 1
+#endif
+#define SD_FLASH_FALLBACK_AFTER_MS 10000
+#define FLASH_LOG_MOUNT_POINT "/flash"
+#define FLASH_LOG_PARTITION "spiffs"        // Partición de datos de la tabla por defecto
+#define FLASH_LOG_FLUSH_INTERVAL_MS 60000   // En la flash solo flush por tiempo: cada uno reescribe un bloque
+#define FLASH_DUMP_CHUNK 512                // Bytes por lectura al volcar un archivo
+
+// Preasignación: cada archivo nuevo reserva de una vez los clusters de toda
+// la misión, así FatFs no asigna clusters durante el registro. Se trunca al
+// largo real al cerrar o, tras un corte de energía, en el siguiente arranque
+#ifndef SD_PREALLOCATE
+#define SD_PREALLOCATE 1
+#endif
+#define SD_MISSION_DURATION_MIN 240         // Duración esperada de una misión
+#define SD_CSV_RECORD_ESTIMATE 140          // Bytes por fila CSV (con margen)
+#define SD_DELTA_RECORD_ESTIMATE 40         // Bytes por registro comprimido (con margen)
+#define SD_CHECKPOINT_INTERVAL_MS 10000     // Largo confirmado guardado en NVS como máximo cada T ms
+#define SD_RECOVERY_MAX_GAP_MS 60000        // Salto máximo de timestamp entre registros recuperados
+
+// Nombres log_NNNNNN: el próximo número se guarda en NVS y en un archivo de
+// la propia tarjeta, y se comprueba contra la tarjeta sin recorrer el
+// directorio en cada arranque
+#define SD_SEQUENCE_DIGITS 6
+#define SD_SEQUENCE_FILE "/usv_seq.txt"     // Próximo número libre en esta tarjeta
+#define SD_SEQUENCE_PROBE_LIMIT 16          // Nombres ocupados a saltar antes de recorrer el directorio
+
+// Rotación a un archivo nuevo durante misiones largas (0 = sin límite)
+#define SD_ROTATE_MAX_BYTES (64UL * 1024 * 1024)
+#define SD_ROTATE_INTERVAL_MIN SD_MISSION_DURATION_MIN  // Coincide con la preasignación
+
+// Prueba de la tarjeta (comando sd_bench): escritura secuencial en bloques
+// de SD_BATCH_BUFFER_SIZE con flush por bloque, el peor caso del logger
+#define SD_BENCH_FILENAME "/sd_bench.tmp"
+#define SD_BENCH_DEFAULT_KB 1024
+#define SD_BENCH_MAX_KB 8192                // Mientras corre los registros esperan en los buffers
 
 /* 
  * EMERGENCY SYSTEM 
@@ -36,6 +203,7 @@
 // Configuración de voltajes de emergencia
 #define EMERGENCY_VOLTAGE_THRESHOLD_REAL 12.20    // Voltaje mínimo antes de activar emergencia (en Volts)
 #define EMERGENCY_VOLTAGE_HYSTERESIS_REAL  0.5   // Histéresis para evitar oscilaciones (en Volts)
+#define EMERGENCY_VOLTAGE_WARNING_REAL 12.60      // Aviso de energía: la SD hace flush en cada escritura
 
 // Configuración de muestreo
 #define EMERGENCY_VOLTAGE_SAMPLES 5         // Número de muestras para promedio
@@ -62,6 +230,21 @@
 #define PIXHAWK_RX_PIN 15  // GPIO1 para recibir datos (solo RX) 16
 #define PIXHAWK_TX_PIN 16  // GPIO1 para recibir datos (solo RX) 15
 #define PIXHAWK_BAUD_RATE 57600 // Velocidad de comunicación MAVLink
+#ifndef PIXHAWK_RX_BUFFER_SIZE
+#define PIXHAWK_RX_BUFFER_SIZE 4096 // Buffer RX de Serial1 (~0.7s de telemetría a 57600)
+#endif
+
+/*
+ * HORA UTC (SYSTEM_TIME del Pixhawk)
+ */
+// Recta reloj local -> UTC ajustada sobre las últimas referencias: cada
+// registro recibe UTC en µs aunque no coincida con un SYSTEM_TIME
+#define TIME_SYNC_WINDOW 16                 // Puntos usados en el ajuste...
+#define TIME_SYNC_SLOT_MS 10000             // ...uno por intervalo: la referencia con menos demora
+#define TIME_SYNC_STEP_US 50000             // Error que se considera un salto de hora...
+#define TIME_SYNC_MAX_OUTLIERS 3            // ...si se repite en N referencias seguidas
+#define TIME_SYNC_MIN_SPAN_MS 60000         // Intervalo mínimo para estimar la deriva
+#define TIME_SYNC_MAX_DRIFT_PPM 500         // Deriva creíble del cristal (si no, 0)
 
 /*
  * COMUNICACIÓN CON ESP-WROOM32 - UART3 PERSONALIZADO
@@ -70,5 +253,66 @@
 #define WROOM_UART_TX_PIN 1        //  (aunque no lo uses)
 #define WROOM_BAUD_RATE 9600       // Velocidad de comunicación
 #define WROOM_UART_NUM 1           // Usar UART1 reasignado
+#ifndef WROOM_RX_BUFFER_SIZE
+#define WROOM_RX_BUFFER_SIZE 1024  // Buffer RX de Serial2
+#endif
+
+/*
+ * RECEPCIÓN UART
+ */
+// 1 = la tarea de eventos UART entrega los bytes a los parsers apenas llegan
+// (onReceive); 0 = los parsers vacían el UART desde su tarea periódica
+#ifndef UART_EVENT_DRAIN
+#define UART_EVENT_DRAIN 0
+#endif
+
+/*
+ * PLANIFICADOR DE TAREAS (periodo y deadline en milisegundos)
+ */
+// El orden de registro en main.cpp define la prioridad: emergencia primero
+#define TASK_EMERGENCY_DEADLINE 20          // Periodo = EMERGENCY_CHECK_RATE
+#define TASK_PIXHAWK_PERIOD 10              // 57600 baudios ≈ 5.8 bytes/ms
+#define TASK_PIXHAWK_DEADLINE 10
+#define TASK_SONAR_PERIOD 50                // 9600 baudios ≈ 1 byte/ms
+#define TASK_SONAR_DEADLINE 50
+#define TASK_COMMANDS_PERIOD 100
+#define TASK_COMMANDS_DEADLINE 100
+#if ANALOG_USE_DMA
+#define TASK_ANALOG_PERIOD 100              // Solo copia las muestras del DMA
+#define TASK_ANALOG_DEADLINE 10
+#else
+#define TASK_ANALOG_PERIOD 1000             // performReadings() bloquea ~100ms
+#define TASK_ANALOG_DEADLINE 200
+#endif
+#define TASK_DATA_LOG_DEADLINE 500          // Periodo = DATA_LOG_INTERVAL
+#define TASK_STATUS_DEADLINE 1000           // Periodo = STATUS_DISPLAY_INTERVAL
+
+/*
+ * DIAGNÓSTICO DE MEMORIA (env esp32-s3-devkitc-1-allocstats)
+ */
+// Cuenta reservas de heap por registro envolviendo malloc/calloc/realloc
+#ifndef ALLOC_STATS
+#define ALLOC_STATS 0
+#endif
+
+/*
+ * MODO DOBLE NÚCLEO (opcional, env esp32-s3-devkitc-1-dualcore)
+ */
+// Adquisición (UART + ADC + emergencia) en un núcleo, formato y SD en el otro
+#ifndef DATALOGGER_DUAL_CORE
+#define DATALOGGER_DUAL_CORE 0
+#endif
+
+#define ACQUISITION_TASK_CORE 1             // Mismo núcleo que loop() de Arduino
+#define ACQUISITION_TASK_PRIORITY 10        // Por encima de loopTask (1)
+#define ACQUISITION_TASK_STACK 8192
+#define STORAGE_TASK_CORE 0
+#define STORAGE_TASK_PRIORITY 2
+#define STORAGE_TASK_STACK 8192
+
+#define SAMPLE_QUEUE_SIZE 32                // Registros en cola (potencia de 2)
+#define TASK_STORAGE_PERIOD 100             // Vaciar cola y escribir SD
+#define TASK_STORAGE_DEADLINE 1000
+#define LOG_DEFERRED_BUFFER_SIZE 8192       // Buffer de mensajes de log diferidos
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include "modules/analog_sensors.h"
+#include "modules/sd_logger.h"
+#include "modules/pixhawk_interface.h"
 #include "eeprom_manager.h"
 #include "logger.h"
 
@@ -13,13 +15,34 @@ public:
     void begin();
     void update();
 
+    // Para el comando sd_stats
+    void setDataLogger(SDLogger* logger) { dataLogger = logger; }
+
+    // Para el comando mav_stats
+    void setPixhawk(PixhawkInterface* interface) { pixhawk = interface; }
+
 private:
     AnalogSensors& sensors;
+    SDLogger* dataLogger;
+    PixhawkInterface* pixhawk;
+
+    // sd_bench en curso: la tarea de la SD completa el resultado y update()
+    // lo muestra al terminar, sin frenar el resto del loop
+    bool benchPending;
+    SdBenchResult benchResult;
     
     void processCommand(String command);
     void displaySensorData();
     void displayCalibrationData();
     void displayHelp();
+    void printResolution(AdcChannelId channel);
+    void printCalibrationPoints(AdcChannelId channel);
+    String calibrationSummary(AdcChannelId channel);
+    void displaySdStats();
+    void runSdBenchmark(uint32_t kb);
+    void displaySdBenchmark();
+    void dumpFlash(String args);
+    void displayMavlinkStats();
     
 };
 
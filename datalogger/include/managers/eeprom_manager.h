@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <EEPROM.h>
+#include "utils/calibration_curve.h"
 
 // Estructura para almacenar todas las calibraciones
 struct CalibrationData {
@@ -16,8 +17,23 @@ struct CalibrationData {
     uint8_t magic;  // Para validar datos
 };
 
-#define EEPROM_SIZE sizeof(CalibrationData)
-#define MAGIC_NUMBER 0xAB
+// Puntos de calibración multipunto (se guardan después de CalibrationData,
+// así la estructura original conserva su posición y su número mágico)
+struct MultiPointCalibration {
+    CalPointSet ph;
+    CalPointSet dissolvedOxygen;
+    CalPointSet ec;
+    uint8_t magic;
+};
+
+#define EEPROM_POINTS_ADDRESS sizeof(CalibrationData)
+#define EEPROM_SIZE (sizeof(CalibrationData) + sizeof(MultiPointCalibration))
+// Los offsets y pendientes se ajustan sobre los mV linealizados con la
+// tabla eFuse (AdcCalibration). Los grabados con la escala ideal 3.3V/4095
+// (0xAB / 0xAC) ya no son válidos y se descartan para forzar recalibrar.
+#define MAGIC_NUMBER 0xAD
+#define POINTS_MAGIC_NUMBER 0xAE
+#define LEGACY_MAGIC_NUMBER 0xAB
 
 class EEPROMManager {
 public:
@@ -34,8 +50,15 @@ public:
                                 float& doOffset, float& doSlope,
                                 float& ecOffset, float& ecSlope, float& ecK);
     
+    // Guardar / cargar los puntos de calibración multipunto
+    static bool saveCalibrationPoints(const MultiPointCalibration& points);
+    static bool loadCalibrationPoints(MultiPointCalibration& points);
+
     // Verificar si hay datos válidos
     static bool hasValidData();
+
+    // Hay una calibración grabada con la escala ADC anterior (descartada)
+    static bool hasLegacyData();
     
     // Borrar todos los datos
     static void clearAll();
@@ -0,0 +1,53 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Función que ejecuta una tarea periódica
+typedef void (*TaskCallback)();
+
+class TaskScheduler {
+public:
+    TaskScheduler();
+
+    // Registrar tarea periódica. El orden de registro define la prioridad
+    // (la primera registrada se ejecuta primero si varias vencen a la vez).
+    // Devuelve el índice de la tarea o -1 si no hay espacio.
+    int addTask(const char* name, TaskCallback callback,
+                unsigned long periodMs, unsigned long deadlineMs);
+
+    // Ejecutar las tareas vencidas. Devuelve los µs hasta la próxima liberación
+    unsigned long run();
+
+    // Ejecutar las tareas vencidas y dormir hasta la próxima liberación
+    void runAndSleep();
+
+    // Estadísticas de planificación
+    void resetStats();
+    void showStats() const;
+    unsigned long getDeadlineMisses() const;
+
+private:
+    static const int MAX_TASKS = 12;
+
+    struct Task {
+        const char* name;
+        TaskCallback callback;
+        unsigned long periodUs;
+        unsigned long deadlineUs;
+        unsigned long nextRelease;      // Próxima liberación (micros)
+
+        // Estadísticas
+        unsigned long runs;
+        unsigned long deadlineMisses;   // Terminó después de liberación + deadline
+        unsigned long skippedReleases;  // Liberaciones perdidas por retraso
+        unsigned long maxJitterUs;      // Retraso máximo del inicio respecto a la liberación
+        unsigned long long totalJitterUs;
+        unsigned long maxExecUs;        // Tiempo de ejecución máximo
+    };
+
+    Task tasks[MAX_TASKS];
+    int taskCount;
+};
+
+#endif // TASK_SCHEDULER_H
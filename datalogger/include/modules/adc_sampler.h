@@ -0,0 +1,65 @@
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Canales muestreados en segundo plano (todos en ADC1)
+enum AdcChannelId {
+    ADC_CH_PH = 0,
+    ADC_CH_DO,
+    ADC_CH_EC,
+    ADC_CH_VBAT,        // Divisor de batería del sistema de emergencia
+    ADC_CH_COUNT
+};
+
+// Muestreo continuo del ADC1 por DMA (modo digital del ESP32-S3).
+// Una tarea propia recibe los frames del driver y guarda las muestras de cada
+// canal en un buffer circular; los lectores solo copian, nunca esperan al ADC.
+class AdcSampler {
+public:
+    AdcSampler();
+
+    // Configurar el patrón de canales y arrancar el muestreo
+    bool begin();
+    void end();
+    bool isRunning() const { return running; }
+
+    // Copiar las últimas n muestras del canal (la más reciente al final).
+    // Si aún hay menos de n se repite la más antigua. Devuelve cuántas
+    // muestras reales había.
+    int getLatest(AdcChannelId channel, int* out, int n);
+
+    // Promedio entero de las últimas n muestras del canal. false (sin tocar
+    // average) si el canal todavía no tiene n conversiones: el primer frame
+    // DMA tarda unos 32 ms en llegar
+    bool getAverage(AdcChannelId channel, int n, int& average);
+
+    // Copiar en orden las muestras nuevas desde `cursor` (hasta max) y
+    // avanzar el cursor. Si el lector se atrasó más que el buffer circular
+    // salta a la muestra más antigua disponible y suma las perdidas a *lost.
+    int readNew(AdcChannelId channel, uint32_t& cursor, uint16_t* out, int max,
+                uint32_t* lost = nullptr);
+
+    // Estadísticas
+    uint32_t getSampleCount(AdcChannelId channel) const { return writeCount[channel]; }
+    uint32_t getOverruns() const { return overruns; }
+    uint32_t getSampleRate() const { return ADC_DMA_SAMPLE_RATE / ADC_CH_COUNT; }
+
+private:
+    static const int MAX_HW_CHANNELS = 10;
+
+    uint16_t ring[ADC_CH_COUNT][ADC_RING_SIZE];
+    volatile uint32_t writeCount[ADC_CH_COUNT];     // Muestras totales por canal
+    int8_t hwToChannel[MAX_HW_CHANNELS];            // Canal ADC1 → AdcChannelId
+    volatile uint32_t overruns;                     // Frames perdidos por el driver
+
+    portMUX_TYPE lock;
+    TaskHandle_t taskHandle;
+    bool running;
+
+    static void samplerTask(void* parameter);
+    void processFrame(const uint8_t* data, uint32_t length);
+};
+
+#endif // ADC_SAMPLER_H
@@ -3,9 +3,18 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "modules/sample_record.h"
+#include "modules/adc_sampler.h"
+#include "utils/sliding_window_filter.h"
+#include "utils/linear_conversion.h"
+#include "utils/calibration_curve.h"
+#include "managers/eeprom_manager.h"
+#include "utils/temperature_compensation.h"
 
 #define NUM_READINGS 10
 
+typedef SlidingWindowFilter<ANALOG_FILTER_MAX_WINDOW> AnalogFilter;
+
 class AnalogSensors {
 public:
     // Constructor
@@ -16,7 +25,11 @@ public:
     float lastDO;
     float lastEC;
 
-    // Últimos valores crudos promediados
+    // Valores compensados por temperatura (NaN sin temperatura reciente)
+    float lastPHCompensated;            // Pendiente de Nernst a la temperatura del agua
+    float lastECCompensated;            // EC referida a 25°C
+
+    // Últimos valores crudos filtrados
     int lastRawPH;
     int lastRawDO;
     int lastRawEC;
@@ -32,19 +45,40 @@ public:
     
     // Inicializar los sensores
     void begin();
+
+    // Usar el muestreo continuo en lugar de analogRead() (nullptr = desactivar)
+    void setAdcSampler(AdcSampler* sampler) { adcSampler = sampler; }
     
     // Actualización de sensores
     void update();
+
+    // Temperatura del agua para la compensación y millis() de su recepción
+    void setWaterTemperature(float celsius, uint32_t timestampMs) {
+        tempCompensation.setTemperature(celsius, timestampMs);
+    }
+    const TemperatureCompensation& getTemperatureCompensation() const { return tempCompensation; }
     
-    // Calibración por sensor (asume que el sensor debería medir el valor dado AHORA)
+    // Calibración por sensor (asume que el sensor debería medir el valor dado AHORA).
+    // Cada llamada agrega un punto de referencia: con uno solo se corrige el
+    // offset; con dos o más se ajustan pendiente y offset por mínimos cuadrados
+    // (EC usa además una curva lineal por tramos a través de los puntos)
     int calibrateCurrentPH(float shouldBePH);
     int calibrateCurrentDO(float shouldBeDO);
     int calibrateCurrentEC(float shouldBeEC);
 
-    //  calibración por command (texto)
+    // Puntos de referencia acumulados por sensor
+    const CalPointSet& getCalibrationPoints(AdcChannelId channel) const;
+    void clearCalibrationPoints(AdcChannelId channel);
+
+    // Mayor error del último ajuste por mínimos cuadrados (unidades del sensor)
+    float getLastFitResidual() const { return lastFitResidual; }
+    bool isEcCurveActive() const { return ecCurve.isActive(); }
+
+    //  calibración por command (texto). Descarta los puntos del sensor.
+    //  setEcCalibration rechaza k <= 0
     void setPhCalibration(float offset, float slope);
     void setDoCalibration(float offset, float slope);
-    void setEcCalibration(float offset, float slope, float k);
+    bool setEcCalibration(float offset, float slope, float k);
 
     // Gestión de eeprom
     bool loadCalibrationFromEEPROM();
@@ -56,17 +90,70 @@ public:
     
     // Obtener datos para CSV
     String getCSVData() const;
+
+    // Completar los campos analógicos del registro (sin reservar memoria)
+    void fillRecord(SampleRecord& record) const;
+
+    // Filtro de un canal (ADC_CH_PH, ADC_CH_DO o ADC_CH_EC)
+    const AnalogFilter& getFilter(AdcChannelId channel) const { return filters[channel]; }
+
+    // Ruido del canal: desviación estándar de la ventana en cuentas de 12 bits
+    float getRawStdDev(AdcChannelId channel) const;
+
+    // Sobremuestreo por canal (n = 0..ANALOG_MAX_OVERSAMPLE, 4^n muestras por salida).
+    // Cambiarlo reinicia el filtro del canal. Devuelve false si n está fuera de rango
+    bool setOversampling(AdcChannelId channel, int bits);
+    int getOversampling(AdcChannelId channel) const { return oversampleBits[channel]; }
+
+    // Resolución efectiva: 12+n bits, limitada por el ruido medido en la ventana
+    float getEffectiveBits(AdcChannelId channel) const;
+
+    // Piso de ruido del canal en mV (desviación estándar de las salidas)
+    float getNoiseMillivolts(AdcChannelId channel) const;
+
+    // Muestras que el DMA sobrescribió antes de que update() las leyera
+    uint32_t getLostSamples() const { return lostSamples; }
     
 private:
-    // Variables para promediar lecturas
-    int phReadings[NUM_READINGS];
-    int doReadings[NUM_READINGS];
-    int ecReadings[NUM_READINGS];
-    int readIndex;
+    static const int NUM_CHANNELS = 3;          // pH, DO, EC (mismo orden que AdcChannelId)
+
+    // Un filtro por canal, alimentado muestra a muestra
+    AnalogFilter filters[NUM_CHANNELS];
+    uint32_t sampleCursor[NUM_CHANNELS];        // Próxima muestra a leer del AdcSampler
+    uint32_t lostSamples;
+
+    // Acumuladores de sobremuestreo
+    uint8_t oversampleBits[NUM_CHANNELS];
+    uint32_t oversampleSum[NUM_CHANNELS];
+    uint16_t oversampleCount[NUM_CHANNELS];
+
+    // Muestreo continuo por DMA (opcional)
+    AdcSampler* adcSampler;
+
+    // Filtros, sobremuestreo, cursores y conversiones: los usan la tarea de
+    // adquisición y los comandos de calibración (otro núcleo en el modo dual)
+    mutable portMUX_TYPE lock;
+
+    // Coeficientes cuentas → unidades, recalculados al cambiar la calibración
+    LinearConversion phConversion;
+    LinearConversion doConversion;
+    LinearConversion ecConversion;
+
+    // Calibración multipunto
+    MultiPointCalibration calPoints;
+    PiecewiseLinearTable ecCurve;
+    float lastFitResidual;
+
+    TemperatureCompensation tempCompensation;
 
     // Funciones auxiliares
     void performReadings();
-    int getAverageReading(int readings[]);
+    void addSample(int channel, int raw);
+    float filteredCounts(AdcChannelId channel) const;
+    void updateConversions();
+    void publishEcCurve(const PiecewiseLinearTable& curve);
+    float channelMillivolts(AdcChannelId channel) const;
+    int filteredRaw(AdcChannelId channel) const;
 };
 
 #endif // ANALOG_SENSORS_H
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef DELTA_CODEC_H
+#define DELTA_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Registro comprimido (SD_LOG_COMPRESSED=1, header binario versión 2):
+ *   uint8_t  largo          bytes que siguen (flags + varints + CRC)
+ *   uint8_t  flags          DELTA_KEY_FRAME si los valores son absolutos
+ *   varint × campos        zig-zag de (valor - anterior), o del valor en un key frame
+ *   uint16_t crc16          CRC-16/CCITT de flags y varints
+ *
+ * Los valores son los campos del registro en punto fijo (quantizeRecord()).
+ * Entre muestras consecutivas casi todos cambian poco y su delta ocupa un
+ * byte. Un registro delta solo se puede leer si se leyó el anterior; un key
+ * frame siempre, así un archivo se puede leer desde el medio.
+ *
+ * Lo comparten el firmware y tools/usvlog, por eso no depende de Arduino.
+ */
+#define DELTA_KEY_FRAME 0x01
+#define DELTA_MAX_VARINT 10         // Un int64 en LEB128
+
+// Peor caso de un registro de count campos
+#define DELTA_RECORD_MAX_SIZE(count) (2 + (count) * DELTA_MAX_VARINT + sizeof(uint16_t))
+
+// Codificar values. previous = nullptr escribe un key frame. Devuelve los
+// bytes escritos o 0 si no cabe
+size_t encodeDeltaRecord(const int64_t* values, const int64_t* previous, uint8_t count,
+                         uint8_t* buffer, size_t size);
+
+// Decodificar el registro al comienzo de buffer (available bytes leídos).
+// Devuelve su tamaño, o 0 si está truncado, mal formado o el CRC no
+// coincide. En un registro delta values = previous + delta (solo el delta
+// si previous = nullptr)
+size_t decodeDeltaRecord(const uint8_t* buffer, size_t available, uint8_t count,
+                         const int64_t* previous, int64_t* values, bool& keyFrame);
+
+#endif // DELTA_CODEC_H
@@ -10,6 +10,8 @@
 #include "config.h"
 
 class PixhawkInterface;
+class AdcSampler;
+class SDLogger;
 
 class EmergencySystem {
 public:
@@ -22,10 +24,17 @@ public:
     // Método para inyectar referencia al Pixhawk
     void setPixhawkInterface(PixhawkInterface* pixhawk) { pixhawkInterface = pixhawk; }
 
+    // Avisar a la SD de un posible corte de energía (flush anticipado)
+    void setDataLogger(SDLogger* logger) { dataLogger = logger; }
+
+    // Leer el voltaje desde el muestreo continuo (el pin comparte ADC1 con los sensores)
+    void setAdcSampler(AdcSampler* sampler) { adcSampler = sampler; }
+
     // Métodos para monitoreo de voltaje
     float getCurrentVoltage() { return currentVoltage; }
     float getVoltageThreshold() { return EMERGENCY_VOLTAGE_THRESHOLD_REAL; }
     bool isPowerControlActive() { return powerControlActive; }
+    bool isPowerWarning() { return powerWarning; }
 
     // Métodos para monitoreo de la seguridad de conmutación
     unsigned long getTimeInCurrentState() { return millis() - stateChangeTime; }
@@ -38,6 +47,8 @@ private:
     
     // Referencia al Pixhawk para coordinación
     PixhawkInterface* pixhawkInterface;
+    AdcSampler* adcSampler;
+    SDLogger* dataLogger;
 
     bool emergencyActive;
     bool gpsInitialized;
@@ -49,6 +60,7 @@ private:
     // Variables para control de voltaje y alimentación
     float currentVoltage;
     bool powerControlActive;          // Estado del control de alimentación
+    bool powerWarning;                // Voltaje bajo EMERGENCY_VOLTAGE_WARNING_REAL
     float voltageReadings[EMERGENCY_VOLTAGE_SAMPLES];  // Buffer para promedio
     int voltageReadingIndex;
     bool voltageBufferFull;
@@ -87,7 +99,7 @@ private:
 
     // Métodos para control de voltaje
     void checkVoltageLevel();
-    float readAverageVoltage();
+    bool readAverageVoltage(float& voltage);   // false si el ADC aún no tiene muestras
     void updateVoltageBuffer(float newReading);
 
     // Métodos para control seguro de conmutación
@@ -0,0 +1,42 @@
+#ifndef LOG_JOURNAL_H
+#define LOG_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Journal de solo anexado (SD_LOG_JOURNAL=1). Cada bloque del log (el header
+ * del archivo y cada registro, CSV o binario) va en un frame:
+ *   JournalFrameHeader (16 bytes, little-endian) + payload
+ * El CRC-32 cubre el resto del header y el payload. El número de archivo
+ * (log_NNNNNN) y la secuencia consecutiva permiten reconocer qué frames son
+ * del archivo actual y en qué orden, aunque se busquen en una imagen de la
+ * tarjeta sin sistema de archivos. El header del archivo es la secuencia 0.
+ *
+ * Lo comparten el firmware y tools/usvlog, por eso no depende de Arduino.
+ */
+#define JOURNAL_MAGIC_0 'U'
+#define JOURNAL_MAGIC_1 'J'
+#define JOURNAL_MAX_PAYLOAD 2048         // Cubre el header binario más grande
+
+struct __attribute__((packed)) JournalFrameHeader {
+    uint8_t magic[2];
+    uint16_t length;            // Bytes de payload
+    uint32_t fileNumber;        // N de log_NNNNNN
+    uint32_t sequence;          // 0 = header del archivo, luego 1, 2, ...
+    uint32_t crc;               // CRC-32 de length..sequence y del payload
+};
+
+inline size_t journalFrameSize(size_t payloadLength) {
+    return sizeof(JournalFrameHeader) + payloadLength;
+}
+
+// Completar el header de un frame cuyo payload ya está en
+// frame + sizeof(JournalFrameHeader)
+void sealJournalFrame(uint8_t* frame, uint16_t length, uint32_t fileNumber, uint32_t sequence);
+
+// Validar el frame al comienzo de buffer (available bytes leídos).
+// Devuelve su tamaño total, o 0 si no hay un frame íntegro
+size_t checkJournalFrame(const uint8_t* buffer, size_t available, JournalFrameHeader& header);
+
+#endif // LOG_JOURNAL_H
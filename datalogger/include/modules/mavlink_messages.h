@@ -0,0 +1,204 @@
+#ifndef MAVLINK_MESSAGES_H
+#define MAVLINK_MESSAGES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "modules/mavlink_parser.h"
+
+/*
+ * Descriptores de los mensajes MAVLink: id, CRC_EXTRA, largo del payload y
+ * offset/tipo de cada campo. Una sola tabla (mavlink_messages.cpp) alimenta
+ * la validación del parser (CRC_EXTRA) y el decodificador genérico.
+ *
+ * Los campos van en el orden del enlace: MAVLink los ordena por tamaño de
+ * tipo (los arreglos por el de su elemento), con las extensiones al final.
+ * La tabla se verifica al compilar: offsets contiguos, orden por tamaño,
+ * suma igual al largo e ids ordenados. Agregar un mensaje es agregar su
+ * enum de campos acá y su descriptor en la tabla.
+ *
+ * El decodificador copia el payload a un buffer propio (sin punteros
+ * desalineados) y completa con ceros los bytes finales que MAVLink 2
+ * recorta. Los campos de extensión no se describen: si llegan se ignoran.
+ * Lee little-endian, igual que el enlace, el ESP32 y la PC.
+ */
+
+enum MavlinkFieldType : uint8_t {
+    MAV_FIELD_U8 = 1,
+    MAV_FIELD_I8,
+    MAV_FIELD_U16,
+    MAV_FIELD_I16,
+    MAV_FIELD_U32,
+    MAV_FIELD_I32,
+    MAV_FIELD_U64,
+    MAV_FIELD_I64,
+    MAV_FIELD_F32,
+    MAV_FIELD_F64
+};
+
+// Tamaño en bytes de un elemento del tipo
+constexpr size_t mavlinkFieldSize(MavlinkFieldType type) {
+    return type == MAV_FIELD_U8 || type == MAV_FIELD_I8 ? 1
+         : type == MAV_FIELD_U16 || type == MAV_FIELD_I16 ? 2
+         : type == MAV_FIELD_U32 || type == MAV_FIELD_I32 || type == MAV_FIELD_F32 ? 4
+         : 8;
+}
+
+struct MavlinkFieldDescriptor {
+    uint8_t offset;                 // Dentro del payload
+    MavlinkFieldType type;
+    uint8_t count;                  // Elementos (>1 en arreglos)
+};
+
+struct MavlinkMessageDescriptor {
+    uint32_t msgId;
+    const char* name;
+    uint8_t crcExtra;
+    uint8_t length;                 // Payload sin extensiones (0 = solo se valida)
+    uint8_t fieldCount;
+    const MavlinkFieldDescriptor* fields;
+};
+
+// Payload más largo de los mensajes con campos descritos
+#define MAVLINK_MAX_DECODED_PAYLOAD 101
+
+// Ids de los mensajes que se decodifican
+enum MavlinkMessageId : uint32_t {
+    MAVLINK_MSG_HEARTBEAT = 0,
+    MAVLINK_MSG_SYS_STATUS = 1,
+    MAVLINK_MSG_SYSTEM_TIME = 2,
+    MAVLINK_MSG_GPS_RAW_INT = 24,
+    MAVLINK_MSG_GPS_STATUS = 25,
+    MAVLINK_MSG_ATTITUDE = 30,
+    MAVLINK_MSG_GLOBAL_POSITION_INT = 33,
+    MAVLINK_MSG_VFR_HUD = 74,
+    MAVLINK_MSG_BATTERY_STATUS = 147
+};
+
+// Índices de campo de cada mensaje, en el orden del enlace
+
+enum HeartbeatField : uint8_t {
+    HEARTBEAT_CUSTOM_MODE,
+    HEARTBEAT_TYPE,
+    HEARTBEAT_AUTOPILOT,
+    HEARTBEAT_BASE_MODE,
+    HEARTBEAT_SYSTEM_STATUS,
+    HEARTBEAT_MAVLINK_VERSION,
+    HEARTBEAT_FIELD_COUNT
+};
+
+enum SysStatusField : uint8_t {
+    SYS_STATUS_SENSORS_PRESENT,
+    SYS_STATUS_SENSORS_ENABLED,
+    SYS_STATUS_SENSORS_HEALTH,
+    SYS_STATUS_LOAD,
+    SYS_STATUS_VOLTAGE_BATTERY,     // mV, UINT16_MAX = desconocido
+    SYS_STATUS_CURRENT_BATTERY,     // cA, -1 = desconocido
+    SYS_STATUS_DROP_RATE_COMM,
+    SYS_STATUS_ERRORS_COMM,
+    SYS_STATUS_ERRORS_COUNT1,
+    SYS_STATUS_ERRORS_COUNT2,
+    SYS_STATUS_ERRORS_COUNT3,
+    SYS_STATUS_ERRORS_COUNT4,
+    SYS_STATUS_BATTERY_REMAINING,   // %, -1 = desconocido
+    SYS_STATUS_FIELD_COUNT
+};
+
+enum SystemTimeField : uint8_t {
+    SYSTEM_TIME_TIME_UNIX_USEC,
+    SYSTEM_TIME_TIME_BOOT_MS,
+    SYSTEM_TIME_FIELD_COUNT
+};
+
+enum GpsRawIntField : uint8_t {
+    GPS_RAW_INT_TIME_USEC,          // UNIX o desde el arranque, según el autopiloto
+    GPS_RAW_INT_LAT,                // grados * 1E7
+    GPS_RAW_INT_LON,
+    GPS_RAW_INT_ALT,                // mm sobre el nivel del mar
+    GPS_RAW_INT_EPH,
+    GPS_RAW_INT_EPV,
+    GPS_RAW_INT_VEL,
+    GPS_RAW_INT_COG,
+    GPS_RAW_INT_FIX_TYPE,
+    GPS_RAW_INT_SATELLITES_VISIBLE,
+    GPS_RAW_INT_FIELD_COUNT
+};
+
+enum GpsStatusField : uint8_t {
+    GPS_STATUS_SATELLITES_VISIBLE,
+    GPS_STATUS_SATELLITE_PRN,
+    GPS_STATUS_SATELLITE_USED,
+    GPS_STATUS_SATELLITE_ELEVATION,
+    GPS_STATUS_SATELLITE_AZIMUTH,
+    GPS_STATUS_SATELLITE_SNR,
+    GPS_STATUS_FIELD_COUNT
+};
+
+enum AttitudeField : uint8_t {
+    ATTITUDE_TIME_BOOT_MS,
+    ATTITUDE_ROLL,                  // rad
+    ATTITUDE_PITCH,
+    ATTITUDE_YAW,
+    ATTITUDE_ROLLSPEED,
+    ATTITUDE_PITCHSPEED,
+    ATTITUDE_YAWSPEED,
+    ATTITUDE_FIELD_COUNT
+};
+
+enum GlobalPositionIntField : uint8_t {
+    GLOBAL_POSITION_INT_TIME_BOOT_MS,
+    GLOBAL_POSITION_INT_LAT,
+    GLOBAL_POSITION_INT_LON,
+    GLOBAL_POSITION_INT_ALT,        // mm
+    GLOBAL_POSITION_INT_RELATIVE_ALT,
+    GLOBAL_POSITION_INT_VX,         // cm/s, NED
+    GLOBAL_POSITION_INT_VY,
+    GLOBAL_POSITION_INT_VZ,
+    GLOBAL_POSITION_INT_HDG,
+    GLOBAL_POSITION_INT_FIELD_COUNT
+};
+
+enum VfrHudField : uint8_t {
+    VFR_HUD_AIRSPEED,               // m/s
+    VFR_HUD_GROUNDSPEED,
+    VFR_HUD_ALT,
+    VFR_HUD_CLIMB,
+    VFR_HUD_HEADING,
+    VFR_HUD_THROTTLE,
+    VFR_HUD_FIELD_COUNT
+};
+
+enum BatteryStatusField : uint8_t {
+    BATTERY_STATUS_CURRENT_CONSUMED,
+    BATTERY_STATUS_ENERGY_CONSUMED,
+    BATTERY_STATUS_TEMPERATURE,     // cdegC, INT16_MAX = desconocido
+    BATTERY_STATUS_VOLTAGES,        // mV por celda, UINT16_MAX = sin celda
+    BATTERY_STATUS_CURRENT_BATTERY, // cA, -1 = desconocido
+    BATTERY_STATUS_ID,
+    BATTERY_STATUS_BATTERY_FUNCTION,
+    BATTERY_STATUS_TYPE,
+    BATTERY_STATUS_BATTERY_REMAINING,
+    BATTERY_STATUS_FIELD_COUNT
+};
+
+// Descriptor del mensaje, o nullptr si no está en la tabla
+const MavlinkMessageDescriptor* findMavlinkMessage(uint32_t msgId);
+
+// Tabla completa, ordenada por id (para herramientas de PC)
+const MavlinkMessageDescriptor* getMavlinkMessages(size_t& count);
+
+// Mensaje decodificado: payload alineado y completo hasta descriptor->length
+struct MavlinkMessage {
+    const MavlinkMessageDescriptor* descriptor;
+    uint8_t payload[MAVLINK_MAX_DECODED_PAYLOAD];
+
+    // Valor de un campo (index = elemento del arreglo), convertido desde su
+    // tipo. Un campo o elemento inexistente vale 0
+    int64_t getInt(uint8_t field, uint8_t index = 0) const;
+    uint64_t getUInt(uint8_t field, uint8_t index = 0) const;
+    float getFloat(uint8_t field, uint8_t index = 0) const;
+};
+
+// Decodificar un frame validado. false si el mensaje no tiene campos descritos
+bool mavlinkDecode(const MavlinkFrame& frame, MavlinkMessage& message);
+
+#endif // MAVLINK_MESSAGES_H
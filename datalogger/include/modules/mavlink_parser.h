@@ -0,0 +1,149 @@
+#ifndef MAVLINK_PARSER_H
+#define MAVLINK_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Framing MAVLink v1/v2 byte a byte, sin la biblioteca generada.
+ *   v1: 0xFE len seq sys comp msgid                         payload crc(2)
+ *   v2: 0xFD len incompat compat seq sys comp msgid(3)      payload crc(2) [firma(13)]
+ * El CRC X.25 cubre desde len hasta el fin del payload y termina con el
+ * CRC_EXTRA del mensaje, que depende de su definición: un frame cortado,
+ * desalineado o de otra versión del mensaje no pasa. Tras un frame inválido
+ * el análisis sigue desde el byte siguiente a su STX (no desde el final del
+ * frame supuesto), así un STX falso no se lleva puesto al frame real.
+ *
+ * Un id sin CRC_EXTRA en la tabla no se puede validar y se trata como un
+ * STX falso: se cuenta y se resincroniza. Si su header trae justo la
+ * secuencia que se espera de un emisor conocido es casi seguro un mensaje
+ * real no soportado, y no se cuenta como perdido en esa secuencia. La firma
+ * de v2 no se verifica (no hay clave compartida); se saltea y se cuenta.
+ *
+ * No depende de Arduino: se puede probar y medir en la PC.
+ */
+#define MAVLINK_STX_V1 0xFE
+#define MAVLINK_STX_V2 0xFD
+#define MAVLINK_V1_HEADER_SIZE 6
+#define MAVLINK_V2_HEADER_SIZE 10
+#define MAVLINK_CHECKSUM_SIZE 2
+#define MAVLINK_SIGNATURE_SIZE 13
+#define MAVLINK_IFLAG_SIGNED 0x01           // Único incompat flag definido
+#define MAVLINK_MAX_PAYLOAD 255
+#define MAVLINK_MAX_FRAME_SIZE (MAVLINK_V2_HEADER_SIZE + MAVLINK_MAX_PAYLOAD + \
+                                MAVLINK_CHECKSUM_SIZE + MAVLINK_SIGNATURE_SIZE)
+#define MAVLINK_MAX_LINKS 8                 // Pares sistema/componente con secuencia seguida
+
+// CRC_EXTRA del mensaje, o -1 si no está en la tabla (mavlink_messages.cpp)
+int mavlinkCrcExtra(uint32_t msgId);
+
+// Frame validado. payload apunta al buffer del parser: vale hasta el próximo byte
+struct MavlinkFrame {
+    uint8_t version;                // 1 o 2
+    uint8_t sequence;
+    uint8_t systemId;
+    uint8_t componentId;
+    uint32_t msgId;
+    uint8_t payloadLength;          // En v2 sin los ceros finales que recorta el emisor
+    const uint8_t* payload;
+    size_t frameSize;               // Bytes en el enlace, con CRC y firma
+    bool isSigned;
+};
+
+// Secuencia de un emisor (sistema/componente)
+struct MavlinkLinkSequence {
+    uint8_t systemId;
+    uint8_t componentId;
+    uint8_t lastSequence;
+    uint32_t frames;
+    uint32_t lostFrames;
+    uint8_t pendingUnknown;         // Ids sin CRC_EXTRA que ocuparon las secuencias siguientes
+};
+
+struct MavlinkStats {
+    uint32_t bytes;                 // Bytes entregados al parser
+    uint32_t frames;                // Frames con CRC válido
+    uint32_t crcErrors;             // Mensaje conocido con CRC inválido
+    uint32_t badHeaders;            // incompat flags desconocidos
+    uint32_t unknownFrames;         // Id sin CRC_EXTRA (mensaje no soportado o STX falso)
+    uint32_t signedFrames;
+    uint32_t skippedBytes;          // Bytes fuera de todo frame válido
+    uint32_t lostFrames;            // Huecos de secuencia sin los ids no soportados del emisor
+    uint32_t untrackedFrames;       // De emisores que no entraron en la tabla
+
+    void reset() {
+        bytes = 0;
+        frames = 0;
+        crcErrors = 0;
+        badHeaders = 0;
+        unknownFrames = 0;
+        signedFrames = 0;
+        skippedBytes = 0;
+        lostFrames = 0;
+        untrackedFrames = 0;
+    }
+
+    // Fracción de frames perdidos según las secuencias (0..1)
+    float dropRate() const {
+        uint32_t expected = frames + lostFrames;
+        return expected > 0 ? (float)lostFrames / expected : 0.0f;
+    }
+};
+
+class MavlinkParser {
+public:
+    MavlinkParser();
+
+    // Entregar un byte recibido. onFrame(const MavlinkFrame&) se llama por
+    // cada frame válido que complete, incluso varios si el byte cierra una
+    // resincronización
+    template <typename Handler>
+    void parse(uint8_t byte, Handler&& onFrame) {
+        stats.bytes++;
+        if (step(byte)) {
+            onFrame(current);
+        }
+        while (replayHead < replayLength) {
+            if (step(replay[replayHead++])) {
+                onFrame(current);
+            }
+        }
+        replayHead = 0;
+        replayLength = 0;
+    }
+
+    // Descartar el frame a medias (p.ej. al soltar el UART)
+    void reset();
+
+    const MavlinkStats& getStats() const { return stats; }
+    void resetStats();
+    int getLinkCount() const { return linkCount; }
+    const MavlinkLinkSequence& getLink(int index) const { return links[index]; }
+
+private:
+    uint8_t buffer[MAVLINK_MAX_FRAME_SIZE];
+    size_t count;                   // Bytes del frame en curso (0 = buscando STX)
+    size_t headerSize;
+    size_t checksumEnd;             // Fin del CRC dentro del frame
+    size_t frameEnd;                // Con la firma, si la hay
+    int crcExtra;
+    uint16_t crc;                   // Acumulado desde len
+
+    // Bytes de un frame descartado que falta volver a analizar
+    uint8_t replay[MAVLINK_MAX_FRAME_SIZE];
+    size_t replayHead;
+    size_t replayLength;
+
+    MavlinkFrame current;
+    MavlinkStats stats;
+    MavlinkLinkSequence links[MAVLINK_MAX_LINKS];
+    int linkCount;
+
+    bool step(uint8_t byte);
+    bool finishFrame();
+    void resync();
+    void trackSequence();
+    void noteUnknownFrame();
+};
+
+#endif // MAVLINK_PARSER_H
@@ -3,6 +3,41 @@
 
 #include <HardwareSerial.h>
 #include "config.h"
+#include "utils/uart_stats.h"
+#include "modules/sample_record.h"
+#include "modules/time_sync.h"
+#include "modules/mavlink_parser.h"
+#include "modules/mavlink_messages.h"
+
+// Datos que leen otras tareas (registro, displays). El parser trabaja sobre
+// sus propios campos y publica esta copia al terminar cada mensaje: con
+// UART_EVENT_DRAIN corre en la tarea de eventos UART, y lat/lon/alt o la
+// fecha no deben leerse a medio actualizar
+struct PixhawkState {
+    float latitude;
+    float longitude;
+    float altitude;
+    float heading;
+    float batteryVoltage;
+    float batteryCurrent;
+    int batteryRemaining;
+    float batteryTemperature;
+    float groundSpeed;
+    float airSpeed;
+    int numSatellites;
+    uint64_t gpsTimeUsec;
+    uint16_t gpsYear;
+    uint8_t gpsMonth;
+    uint8_t gpsDay;
+    uint8_t gpsHour;
+    uint8_t gpsMinute;
+    uint8_t gpsSecond;
+    bool gpsTimeValid;
+    bool connected;
+    bool armed;
+
+    bool hasValidTime() const { return gpsTimeValid && gpsYear >= 2020; }
+};
 
 class PixhawkInterface {
 public:
@@ -16,6 +51,20 @@ public:
     void resumeAfterEmergency(); // Retomar UART1 para Pixhawk
     bool isPaused() const { return paused; }
 
+    // Estadísticas de recepción del UART
+    const UartStats& getRxStats() const { return rxStats; }
+
+    // Estadísticas del enlace MAVLink (frames, CRC, secuencias)
+    const MavlinkParser& getLink() const { return mavlink; }
+    String getLinkStatsString() const;  // Tasas desde resetLinkStats()
+    void resetLinkStats();
+
+    // Cada SYSTEM_TIME se entrega como referencia UTC al estimador
+    void setTimeSync(TimeSync* sync) { timeSync = sync; }
+
+    // Copia coherente de los últimos datos publicados
+    PixhawkState getState() const;
+
     // Getters básicos para los datos (mantener interfaz original)
     float getLatitude();
     float getLongitude();
@@ -49,6 +98,7 @@ public:
     // Funciones para CSV
     String save_CSVData();
     String getCSVHeader();
+    void fillRecord(SampleRecord& record) const;
 
 private:
     // Estado de pausa
@@ -98,28 +148,45 @@ private:
     uint8_t gpsSecond;             // Segundo (0-59)
     bool gpsTimeValid;             // Si los datos de tiempo son válidos
 
+    // Referencia UTC para los registros
+    TimeSync* timeSync;
+    int64_t frameStartUsec;        // esp_timer al empezar a llegar el mensaje en proceso
+
     // Estado de conexión y sistema
     bool connected;
     bool armed;
-    uint8_t flightMode;
+    uint32_t flightMode;           // custom_mode del HEARTBEAT
     uint8_t systemStatus;
     
     unsigned long lastUpdateTime;
+
+    // Copia publicada para los lectores (ver PixhawkState)
+    PixhawkState published;
+    mutable portMUX_TYPE stateLock;
+    void publishState();
+
+    // Estadísticas del UART1
+    UartStats rxStats;
+    void configureUART();
+
+    // Framing con CRC: solo llegan a processMAVLinkMessage() frames válidos
+    MavlinkParser mavlink;
+    unsigned long linkStatsStart;
     
     // Funciones de procesamiento MAVLink (refactorizadas)
     void parseMAVLink();
-    void processMAVLinkMessage(uint8_t* buffer, uint8_t length, bool isMAVLink2);
+    void processMAVLinkMessage(const MavlinkFrame& frame);
     
-    // Métodos de parseo simplificados (basados en el código funcional)
-    void parseHeartbeat(uint8_t* payload);
-    void parseSysStatus(uint8_t* payload);
-    void parseGPSRawInt(uint8_t* payload);
-    void parseAttitude(uint8_t* payload);
-    void parseGlobalPosition(uint8_t* payload);
-    void parseVFRHUD(uint8_t* payload);
-    void parseBatteryStatus(uint8_t* payload);
-    void parseGPSStatus(uint8_t* payload);
-    void parseSystemTime(uint8_t* payload);
+    // Manejo de cada mensaje, ya decodificado con su descriptor
+    void parseHeartbeat(const MavlinkMessage& message);
+    void parseSysStatus(const MavlinkMessage& message);
+    void parseGPSRawInt(const MavlinkMessage& message);
+    void parseAttitude(const MavlinkMessage& message);
+    void parseGlobalPosition(const MavlinkMessage& message);
+    void parseVFRHUD(const MavlinkMessage& message);
+    void parseBatteryStatus(const MavlinkMessage& message);
+    void parseGPSStatus(const MavlinkMessage& message);
+    void parseSystemTime(const MavlinkMessage& message);
 
     // FUNCIONES AUXILIARES PARA TIEMPO
     void convertUnixTimeToDateTime(uint64_t unixTimeUsec);  // Convertir timestamp a fecha/hora
@@ -0,0 +1,103 @@
+#ifndef RECORD_SCHEMA_H
+#define RECORD_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "modules/sample_record.h"
+
+// Esquema del registro: nombre, tipo, escala y decimales de cada columna.
+// Lo comparten el firmware (formato binario del SDLogger) y la herramienta
+// de PC tools/usvlog, por eso no depende de Arduino.
+
+enum FieldType : uint8_t {
+    FIELD_U8 = 1,
+    FIELD_U16 = 2,
+    FIELD_U32 = 3,
+    FIELD_I32 = 4,
+    FIELD_F32 = 5,
+    FIELD_U64 = 6
+};
+
+struct FieldDescriptor {
+    const char* name;           // Igual que la columna del CSV (getCSVHeader() de cada módulo)
+    FieldType type;
+    uint16_t recordOffset;      // offsetof() en SampleRecord
+    float scale;                // valor = crudo * scale
+    uint8_t decimals;           // Decimales en el CSV
+};
+
+extern const FieldDescriptor RECORD_FIELDS[];
+extern const uint8_t RECORD_FIELD_COUNT;
+
+// Tamaño en bytes de un tipo de campo
+size_t fieldTypeSize(FieldType type);
+
+// Header CSV a partir de los nombres del esquema (sin fin de línea).
+// Devuelve la longitud o -1 si no cabe
+int formatSchemaCSVHeader(char* buffer, size_t size);
+
+/*
+ * Formato binario (little-endian):
+ *   BinaryLogHeader
+ *   fieldCount × BinaryFieldEntry
+ *   uint16_t crc16 del header y las entradas
+ *   registros de recordSize bytes: campos empaquetados en orden + uint16_t crc16
+ * En la versión 2 recordSize sigue siendo el del registro sin comprimir, pero
+ * los registros tienen largo variable (delta_codec.h).
+ */
+#define BINARY_LOG_MAGIC "USVL"
+#define BINARY_LOG_VERSION 1
+#define BINARY_LOG_VERSION_DELTA 2  // Registros comprimidos (ver delta_codec.h)
+#define BINARY_FIELD_NAME_LENGTH 24
+#define BINARY_LOG_MAX_FIELDS 32
+
+struct __attribute__((packed)) BinaryLogHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t fieldCount;
+    uint16_t recordSize;        // Campos + CRC (sin comprimir)
+    uint16_t headerSize;        // Todo hasta el primer registro
+};
+
+struct __attribute__((packed)) BinaryFieldEntry {
+    uint8_t type;
+    uint8_t decimals;
+    uint16_t packedOffset;      // Posición dentro del registro empaquetado
+    float scale;
+    char name[BINARY_FIELD_NAME_LENGTH];
+};
+
+// Cota del header binario para reservar buffers estáticos
+#define BINARY_HEADER_MAX_SIZE \
+    (sizeof(BinaryLogHeader) + BINARY_LOG_MAX_FIELDS * sizeof(BinaryFieldEntry) + sizeof(uint16_t))
+
+// Registro empaquetado sin CRC
+size_t binaryRecordPayloadSize();
+
+// Registro completo (campos + CRC)
+inline size_t binaryRecordSize() { return binaryRecordPayloadSize() + sizeof(uint16_t); }
+
+// Tamaño del header binario completo
+size_t binaryHeaderSize();
+
+// Escribir el header binario. Devuelve los bytes escritos o 0 si no cabe
+size_t writeBinaryHeader(uint8_t* buffer, size_t size, uint8_t version = BINARY_LOG_VERSION);
+
+// Empaquetar un registro con su CRC. Devuelve binaryRecordSize() o 0 si no cabe
+size_t encodeBinaryRecord(const SampleRecord& record, uint8_t* buffer, size_t size);
+
+// Desempaquetar un registro; false si el CRC no coincide
+bool decodeBinaryRecord(const uint8_t* buffer, SampleRecord& record);
+
+// Campos en punto fijo para la compresión delta: los F32 se redondean a los
+// decimales del CSV (la misma precisión que guarda el archivo de texto) y
+// NaN o infinito quedan como QUANTIZED_NAN; los enteros van tal cual
+#define QUANTIZED_NAN INT64_MIN
+
+void quantizeRecord(const SampleRecord& record, int64_t* values);
+void dequantizeRecord(const int64_t* values, SampleRecord& record);
+
+// 10^decimals (decimals <= 9)
+double decimalScale(uint8_t decimals);
+
+#endif // RECORD_SCHEMA_H
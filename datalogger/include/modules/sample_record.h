@@ -0,0 +1,46 @@
+#ifndef SAMPLE_RECORD_H
+#define SAMPLE_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Longitud máxima de una fila CSV (sin fin de línea)
+#define SAMPLE_CSV_MAX_LENGTH 256
+
+// Columnas de una fila CSV (deben coincidir con RECORD_FIELDS)
+#define SAMPLE_CSV_FIELD_COUNT 13
+
+// Instantánea de todos los módulos en el momento de captura.
+// Es POD para poder copiarla entre tareas sin reservar memoria.
+struct SampleRecord {
+    uint32_t timestampMs;       // millis() al capturar
+    uint64_t utcUsec;           // UTC en µs desde epoch UNIX (0 = sin referencia)
+
+    // Sonar
+    float sonarDepth;           // m
+    float waterTemperature;     // °C
+    uint8_t sonarValid;
+
+    // Sensores analógicos
+    float ph;
+    float dissolvedOxygen;      // mg/L
+    float conductivity;         // μS/cm
+    float phCompensated;        // pH corregido por temperatura (NaN sin temperatura)
+    float conductivity25;       // μS/cm referida a 25°C (NaN sin temperatura)
+
+    // Pixhawk
+    float latitude;             // grados
+    float longitude;            // grados
+    float altitude;             // m
+};
+
+// Formatear un registro como fila CSV (sin fin de línea) en el buffer dado.
+// Devuelve la longitud escrita o -1 si no cabe.
+int formatRecordCSV(const SampleRecord& record, char* buffer, size_t size);
+
+// Validar que una línea (sin fin de línea) tenga la forma que produce
+// formatRecordCSV y extraer su timestamp. Se usa para encontrar dónde
+// terminan los datos reales de un archivo preasignado.
+bool parseRecordCSVTimestamp(const char* line, size_t length, uint32_t& timestamp);
+
+#endif // SAMPLE_RECORD_H
@@ -3,26 +3,308 @@
 
 #include <SD.h>
 #include <SPI.h>
+#include <Preferences.h>
 #include "config.h"
+#include "modules/sample_record.h"
+#include "modules/time_sync.h"
+#include "utils/latency_histogram.h"
 
+// Estadísticas de escritura en la SD (tiempos en µs)
+struct SdWriteStats {
+    uint32_t writes;
+    uint32_t bytesWritten;
+    uint32_t totalWriteUs;
+    uint32_t maxWriteUs;
+    uint32_t flushes;
+    uint32_t totalFlushUs;
+    uint32_t maxFlushUs;
+    uint32_t openFailures;
+    uint32_t writeErrors;
+    uint32_t droppedRecords;
+    uint32_t maxStallUs;                // Operación de SD más larga (apertura, escritura o flush)
+    uint32_t buffersHighWater;          // Máximo de buffers ocupados a la vez
+    uint32_t pendingHighWater;          // Máximo de bytes esperando la SD
+    uint32_t rotations;                 // Archivos nuevos por límite de tamaño o tiempo
+    uint32_t encodedRecords;            // Registros formateados que entraron al buffer
+    uint32_t encodedBytes;              // Sus bytes (sin el frame del journal)
+    uint32_t totalEncodeUs;             // Tiempo de formateo o compresión
+    uint32_t maxEncodeUs;
+    uint32_t spooledRecords;            // Registros que pasaron por el spool de PSRAM
+    uint32_t spoolHighWater;            // Máximo de registros en el spool a la vez
+    uint32_t remounts;                  // Montajes tras perder la tarjeta
+    uint32_t discardedBytes;            // Bytes de un archivo que no estaba en la tarjeta nueva
+    uint32_t spilledBytes;              // Bytes de un archivo perdido guardados en la flash (.part)
+    uint32_t flashFallbacks;            // Pasos a la flash interna por falta de tarjeta
+
+    // Distribución de cada operación de la tarea de escritura
+    LatencyHistogram openLatency;
+    LatencyHistogram writeLatency;
+    LatencyHistogram flushLatency;
+
+    void reset() {
+        writes = 0;
+        bytesWritten = 0;
+        totalWriteUs = 0;
+        maxWriteUs = 0;
+        flushes = 0;
+        totalFlushUs = 0;
+        maxFlushUs = 0;
+        openFailures = 0;
+        writeErrors = 0;
+        droppedRecords = 0;
+        maxStallUs = 0;
+        buffersHighWater = 0;
+        pendingHighWater = 0;
+        rotations = 0;
+        encodedRecords = 0;
+        encodedBytes = 0;
+        totalEncodeUs = 0;
+        maxEncodeUs = 0;
+        spooledRecords = 0;
+        spoolHighWater = 0;
+        remounts = 0;
+        discardedBytes = 0;
+        spilledBytes = 0;
+        flashFallbacks = 0;
+        openLatency.reset();
+        writeLatency.reset();
+        flushLatency.reset();
+    }
+};
+
+// Resultado de SDLogger::startBenchmark()
+struct SdBenchResult {
+    bool ok;
+    uint32_t bytes;                     // Escritos hasta terminar o fallar
+    uint32_t elapsedUs;                 // Apertura, escrituras, flush y cierre
+    LatencyHistogram openLatency;
+    LatencyHistogram writeLatency;
+    LatencyHistogram flushLatency;
+
+    void reset() {
+        ok = false;
+        bytes = 0;
+        elapsedUs = 0;
+        openLatency.reset();
+        writeLatency.reset();
+        flushLatency.reset();
+    }
+
+    uint32_t kbPerSecond() const {
+        return elapsedUs > 0 ? (uint32_t)((uint64_t)bytes * 1000000 / elapsedUs / 1024) : 0;
+    }
+};
+
+// Registro en la SD con escritura diferida (write-behind).
+// Los productores formatean cada registro y lo copian al buffer activo; una
+// tarea propia escribe los buffers llenos y aplica la política de flush, así
+// una tarjeta que tarda cientos de ms no detiene la adquisición. Si todos
+// los buffers están esperando a la SD el registro queda sin formatear en un
+// spool en PSRAM y entra a los buffers cuando la tarjeta vuelve; solo se
+// descarta con el spool lleno. La tarea monta la tarjeta y la vuelve a
+// montar si se retira o falla; si no vuelve, el log sigue en la flash
+// interna (SD_FLASH_FALLBACK) hasta que la tarjeta aparece.
 class SDLogger {
 public:
     SDLogger();
+
+    // Bytes a reservar para cada archivo nuevo (0 = sin preasignación).
+    // Llamar antes de begin()
+    void setPreallocation(uint32_t bytes);
+
+    // Con hora UTC los archivos se llaman log_NNNNNN_AAAAMMDDTHHMMSSZ; uno
+    // creado antes de la primera referencia se renombra al llegar esta
+    void setTimeSync(TimeSync* sync) { timeSync = sync; }
+
+    // Arranca la tarea de escritura aunque no haya tarjeta: la monta en
+    // cuanto aparece. false solo si el logger no pudo arrancar
     bool begin();
     bool writeHeader(String header);
-    bool writeData(String data);
-    void update();
+    bool writeRecord(const SampleRecord& record);
+
+    // Forzar un flush inmediato en la tarea de escritura (p.ej. antes de un corte de energía)
+    void requestFlush();
+
+    // Mientras haya aviso de energía se hace flush en cada ciclo
+    void setPowerWarning(bool active) { powerWarning = active; }
+
+    // Escribir todo lo pendiente, cerrar el archivo y truncar la
+    // preasignación. Después no se aceptan más registros
+    void close();
+
+    // Prueba de escritura secuencial de `bytes` en un archivo aparte con el
+    // patrón del logger. La corre la tarea de escritura (la única que usa la
+    // tarjeta) entre dos ciclos y completa `result` al terminar; no bloquea.
+    // false si no hay tarjeta o ya hay una prueba en curso
+    bool startBenchmark(uint32_t bytes, SdBenchResult& result);
+    bool isBenchmarkRunning() const { return benchRequested; }
+
+    const SdWriteStats& getStats() const { return stats; }
+    void resetStats();
+    String getBusDescription() const;   // Bus y reloj configurados
+    uint32_t getLogBytesPerSecond() const;  // Carga del log desde resetStats()
+    int getBuffersInUse() const;
+    size_t getPendingBytes() const;
+    uint32_t getDataLength() const { return fileOffset; }
+    uint32_t getAllocatedSize() const { return allocatedSize; }
+    bool isCardMounted() const { return cardMounted; }
+    uint32_t getSpoolCount() const { return spoolCount; }
+    uint32_t getSpoolCapacity() const { return spoolCapacity; }
+    const String& getFilename() const { return currentFilename; }
+    void showStats() const;
+
+    // Respaldo en la flash interna. El volcado corre en la tarea que lo pide:
+    // LittleFS serializa el acceso con la tarea de escritura, y del archivo
+    // activo se lee hasta su último flush
+    bool isOnFlash() const { return onFlash; }
+    bool isFlashMounted() const { return flashMounted; }
+    size_t getFlashUsedBytes() const;
+    size_t getFlashTotalBytes() const;
+    void listFlashFiles(Print& out) const;
+    bool dumpFlashFile(const String& name, Print& out) const;
+    uint32_t dumpFlashFiles(Print& out) const;     // Todos; devuelve cuántos
+    uint32_t removeFlashFiles();        // Todos menos el activo; devuelve cuántos
 
 private:
+    // Buffer de la cadena de escritura. Alineado a palabra para que el
+    // driver (SPI o SDMMC) haga DMA sin copia intermedia
+    struct WriteBuffer {
+        uint8_t data[SD_BATCH_BUFFER_SIZE] __attribute__((aligned(4)));
+        size_t length;                  // Bytes cargados por el productor
+        size_t written;                 // Bytes ya escritos en la SD (flush parcial)
+        bool startsNewFile;             // Rotación: este buffer abre un archivo nuevo
+    };
+
+    enum AppendResult {
+        APPEND_OK = 0,
+        APPEND_FULL,                    // Sin buffer libre: va al spool
+        APPEND_INVALID                  // No serializable: se descarta
+    };
+
+    enum RotationState {
+        ROTATION_NONE = 0,
+        ROTATION_DUE,                   // La tarea detectó el límite; falta marcar el corte
+        ROTATION_QUEUED                 // El productor marcó el buffer que abre el archivo nuevo
+    };
+
     File dataFile;
+    bool fileOpen;
+    uint32_t fileOffset;                // Bytes escritos en el archivo actual
     bool sdInitialized;
-    unsigned long lastWriteTime;
+    volatile bool cardMounted;
+    bool cardRecovered;                 // recoverPreviousFile() ya corrió en esta sesión
+    bool fileCreated;                   // El archivo actual existe en la tarjeta
+    bool discardStream;                 // Buffers de un archivo perdido: a la flash o descartar hasta el corte
+    uint32_t consecutiveErrors;         // Ciclos de escritura fallidos seguidos
     String dataHeader;                  // Header del archivo actual
-    bool headerIsWritten;               // Header escrito
-    String dataBuffer;
     String currentFilename;             // Nombre actual del archivo
+    uint32_t fileNumber;                // N de log_NNNNNN
+
+    // Preasignación, numeración y punto de control en NVS para la recuperación
+    uint32_t preallocateBytes;          // Tamaño a reservar por archivo
+    uint32_t allocatedSize;             // Reservado en el archivo actual (0 = sin preasignar)
+    Preferences nvs;
+    unsigned long lastCheckpointTime;
+    volatile bool closeRequested;
+
+    // Pedido de sd_bench para la tarea de escritura
+    volatile bool benchRequested;
+    uint32_t benchBytes;
+    SdBenchResult* benchResult;
+
+    // Hora UTC del inicio de cada archivo en su nombre
+    TimeSync* timeSync;
+    int64_t fileStartUs;                // esp_timer al crear el archivo actual
+    bool filenameStamped;               // El nombre ya lleva la hora UTC
+
+    // Rotación
+    unsigned long fileStartTime;
+    volatile uint8_t rotationState;
+    uint32_t nextFileNumber;            // Reservado por la tarea al detectar el límite
+
+    // Respaldo en la flash interna (solo la tarea de escritura)
+    volatile bool flashMounted;
+    volatile bool onFlash;              // El archivo actual está en la flash
+    bool nextOnFlash;                   // Destino del archivo de la rotación pendiente
+    unsigned long cardLostTime;         // Desde cuándo no hay tarjeta
+    File spillFile;                     // "<archivo>.part" con lo que no llegó a la SD
+
+    // El primer archivo ya entró al flujo con su header (solo el productor)
+    bool streamStarted;
+
+    // Frames del journal (solo el productor)
+    uint32_t journalFileNumber;
+    uint32_t journalSequence;
+
+    // Estado de la compresión delta (solo el productor)
+    int64_t deltaPrevious[SAMPLE_CSV_FIELD_COUNT];
+    uint32_t deltaSinceKeyFrame;
+
+    // Spool en PSRAM: registros sin formatear en orden de llegada (solo el productor)
+    SampleRecord* spool;
+    uint32_t spoolCapacity;
+    uint32_t spoolHead;
+    volatile uint32_t spoolCount;
+
+    // Los buffers se usan en orden circular y forman un único flujo: cada
+    // buffer lleno termina en un múltiplo de SD_BATCH_BUFFER_SIZE del
+    // archivo, así las escrituras de la tarea cubren sectores completos
+    WriteBuffer buffers[SD_BUFFER_COUNT];
+    volatile int activeBuffer;          // Buffer que llenan los productores
+    volatile int writeIndex;            // Buffer lleno más antiguo
+    volatile int fullCount;             // Buffers llenos esperando a la SD
+    mutable portMUX_TYPE lock;          // Protege los tres índices y buffers[activeBuffer].length
+    TaskHandle_t taskHandle;
+
+    // Política de flush
+    volatile uint32_t recordsSinceFlush;
+    uint32_t unflushedBytes;
+    unsigned long lastFlushTime;
+    volatile bool flushRequested;
+    volatile bool powerWarning;
+
+    SdWriteStats stats;
+    unsigned long statsStartTime;
     
-    void generateUniqueFilename();      // Generar nombres únicos
+    bool mountCard();
+    bool remountCard();
+    void unmountCard();
+    void prepareCard();
+    void checkFlashFallback();
+    void spillBuffer(const uint8_t* data, size_t length);
+    fs::FS& logFs();                    // Sistema de archivos del archivo actual
+    uint32_t reserveFileNumber();       // Próximo número libre
+    uint32_t scanLastSequence();
+    bool readCardSequence(uint32_t& next);
+    void writeCardSequence(uint32_t next);
+    String logFilename(uint32_t number);
+    void stampFilename();
+    bool createPreallocated();
+    bool appendHeader();
+    void markNewFile();
+    bool append(const uint8_t* data, size_t length);
+    AppendResult appendRecord(const SampleRecord& record);
+    bool spoolRecord(const SampleRecord& record);
+    void drainSpool();
+    size_t pendingBytesLocked() const;
+
+    // Tarea de escritura
+    static void writerTask(void* parameter);
+    bool writerCycle();
+    bool writeBuffer(WriteBuffer& buffer, size_t length);
+    bool openFile();
+    void flushFile();
+    void startCheckpoint();
+    void finalizeFile();
+    bool rotateFile(WriteBuffer& first);
+    void checkRotation();
+    void recordStall(uint32_t elapsed);
+    void benchmarkCard(uint32_t bytes, SdBenchResult& result);
+
+    // Recuperación tras un corte de energía
+    void recoverPreviousFile();
+    uint32_t findDataEnd(File& file, uint32_t start, uint32_t number);
+    bool truncateFile(const String& name, uint32_t length);
 };
 
-#endif // SD_LOGGER_H
\ No newline at end of file
+#endif // SD_LOGGER_H
@@ -4,6 +4,8 @@
 #include <Arduino.h>
 #include <HardwareSerial.h>
 #include "config.h"
+#include "utils/uart_stats.h"
+#include "modules/sample_record.h"
 
 class SonarReceiver {
 public:
@@ -33,10 +35,12 @@ public:
     unsigned long getTotalPacketsReceived() const;
     unsigned long getValidPacketsReceived() const;
     unsigned long getErrorPacketsReceived() const;
+    const UartStats& getRxStats() const { return rxStats_; }
     
     // Para logging/CSV
     String getCSVHeader() const;
     String getCSVData() const;
+    void fillRecord(SampleRecord& record) const;
     void showStatus() const;
 
 private:
@@ -57,6 +61,10 @@ private:
         unsigned long receivedTime; // Cuando se recibió en datalogger
     } currentData_;
     
+    // Con UART_EVENT_DRAIN el parser corre en la tarea de eventos UART:
+    // currentData_ y connected_ se escriben y se leen con este lock
+    mutable portMUX_TYPE dataLock_;
+
     // Estado de conexión
     bool connected_;
     unsigned long lastDataTime_;
@@ -66,6 +74,7 @@ private:
     unsigned long totalPacketsReceived_;
     unsigned long validPacketsReceived_;
     unsigned long errorPacketsReceived_;
+    UartStats rxStats_;
     
     // Buffer para recepción
     String inputBuffer_;
@@ -79,6 +88,7 @@ private:
     uint32_t parseUInt32Value(const String& value);
     float parseFloatValue(const String& value);
     void resetData();
+    bool snapshot(SonarData& data) const;   // Copia coherente; devuelve hasValidData()
 };
 
 #endif // SONAR_RECEIVER_H
\ No newline at end of file
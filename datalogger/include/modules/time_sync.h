@@ -0,0 +1,71 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "config.h"
+
+// Estimación de la hora UTC a partir del reloj local (esp_timer, µs desde
+// el arranque) y de referencias UTC (SYSTEM_TIME del Pixhawk).
+//
+// Cada referencia llega tarde (cola del UART, periodo de la tarea), así que
+// de cada intervalo de TIME_SYNC_SLOT_MS se queda la de menos demora (la de
+// mayor offset UTC - local). Sobre los últimos TIME_SYNC_WINDOW puntos se
+// ajusta por mínimos cuadrados una recta: el término independiente es el
+// offset y la pendiente la deriva del cristal; la recta se sube hasta el
+// punto más adelantado en lugar de quedar en el promedio. Un error grande
+// aislado se descarta; si se repite se toma como un salto de la hora del
+// Pixhawk y se empieza de nuevo.
+class TimeSync {
+public:
+    TimeSync();
+
+    // Referencia: utcUsec medido en el instante local localUsec
+    void addReference(uint64_t utcUsec, int64_t localUsec);
+
+    // UTC en µs para un instante local, o 0 si aún no hay referencias
+    uint64_t toUtc(int64_t localUsec) const;
+    uint64_t nowUtc() const { return toUtc(esp_timer_get_time()); }
+
+    bool isSynced() const { return synced; }
+    uint32_t getReferenceCount() const { return references; }
+    uint32_t getResets() const { return resets; }
+    float getDriftPpm() const;
+    int32_t getLastErrorUs() const { return lastErrorUs; }          // Referencia vs estimación previa
+    uint32_t getReferenceAgeMs() const;
+    String toString() const;
+
+private:
+    struct Reference {
+        int64_t localUsec;
+        int64_t offsetUsec;         // UTC - local, relativo a baseOffset
+    };
+
+    bool synced;
+    Reference window[TIME_SYNC_WINDOW];
+    int next;
+    int count;
+    Reference slot;                 // Mejor referencia del intervalo en curso
+    int64_t slotStartUsec;
+    int64_t baseOffset;             // Primer offset: el ajuste trabaja con valores chicos
+    int outliers;
+
+    // Recta vigente: offset(local) = baseOffset + intercept + slope * (local - anchor)
+    int64_t anchorUsec;
+    double intercept;
+    double slope;
+
+    uint32_t references;
+    uint32_t resets;
+    int32_t lastErrorUs;
+    int64_t lastReferenceUsec;
+
+    mutable portMUX_TYPE lock;
+
+    void restart(uint64_t utcUsec, int64_t localUsec);
+    void push(const Reference& point);
+    void fit();
+    int64_t offsetAt(int64_t localUsec) const;
+};
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,57 @@
+#ifndef ADC_CALIBRATION_H
+#define ADC_CALIBRATION_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Linealización del ADC1 (12 bits, atenuación 11dB) a partir de la
+// caracterización grabada en eFuse en fábrica. begin() la lee una vez y
+// arma una tabla cuentas → mV compartida por todas las rutas analógicas.
+class AdcCalibration {
+public:
+    // Leer eFuse y construir la tabla (llamar una vez en setup)
+    static void begin();
+
+    static bool isReady() { return ready; }
+
+    // Origen de la caracterización ("eFuse Two Point", "Vref por defecto", ...)
+    static const char* getSource();
+
+    // Cuentas → mV (una lectura de tabla)
+    static uint16_t toMillivolts(int counts) {
+        if (counts < 0) {
+            counts = 0;
+        } else if (counts > ADC_LUT_SIZE - 1) {
+            counts = ADC_LUT_SIZE - 1;
+        }
+        if (!ready) {
+            return (uint16_t)(counts * ADC_VREF * 1000.0f / ADC_MAX_COUNT);
+        }
+        return lut[counts];
+    }
+
+    // Cuentas fraccionarias (salida de los filtros) → mV interpolando
+    // entre las dos entradas vecinas de la tabla
+    static float toMillivolts(float counts) {
+        if (counts <= 0.0f) {
+            return toMillivolts(0);
+        }
+        if (counts >= ADC_LUT_SIZE - 1) {
+            return toMillivolts(ADC_LUT_SIZE - 1);
+        }
+        int index = (int)counts;
+        float fraction = counts - index;
+        float low = toMillivolts(index);
+        float high = toMillivolts(index + 1);
+        return low + (high - low) * fraction;
+    }
+
+private:
+    static const int ADC_LUT_SIZE = 4096;
+
+    static uint16_t lut[ADC_LUT_SIZE];
+    static bool ready;
+    static int source;
+};
+
+#endif // ADC_CALIBRATION_H
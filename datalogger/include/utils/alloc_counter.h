@@ -0,0 +1,16 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Contador de reservas de heap (malloc/calloc/realloc). Solo cuenta si se
+// compila con ALLOC_STATS=1 y el enlazador envuelve esas funciones
+// (ver env esp32-s3-devkitc-1-allocstats en platformio.ini).
+#if ALLOC_STATS
+uint32_t allocCount();
+#else
+inline uint32_t allocCount() { return 0; }
+#endif
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,74 @@
+#ifndef CALIBRATION_CURVE_H
+#define CALIBRATION_CURVE_H
+
+#include <stdint.h>
+#include "utils/linear_conversion.h"
+
+// Puntos de referencia por sensor
+#define CAL_MAX_POINTS 5
+
+// Tabla de evaluación de la curva por tramos (EC)
+#define CAL_TABLE_SEGMENTS 64
+#define CAL_TABLE_MAX_MV 3300.0f
+
+// Un punto de calibración: lectura del sensor (mV) y valor de referencia
+struct CalPoint {
+    float millivolts;
+    float value;
+};
+
+// Puntos de un sensor (POD, se guarda tal cual en EEPROM)
+struct CalPointSet {
+    uint8_t count;
+    CalPoint points[CAL_MAX_POINTS];
+
+    void clear() { count = 0; }
+
+    // Agregar un punto. Si ya hay uno con el mismo valor de referencia (a
+    // menos de `sameValue`) se reemplaza; si el conjunto está lleno se
+    // descarta el más antiguo
+    void add(float millivolts, float value, float sameValue);
+};
+
+// Ajuste por mínimos cuadrados valor = mV * gain + offset. Devuelve false
+// con menos de dos puntos o si todas las lecturas son iguales.
+// maxResidual (opcional) recibe el mayor error absoluto del ajuste
+bool fitLeastSquares(const CalPointSet& set, float& gain, float& offset, float* maxResidual = nullptr);
+
+// Curva lineal por tramos a través de los puntos (ordenados por mV),
+// extrapolando con los tramos extremos. Cada tramo guarda su gain/offset
+// y una tabla de CAL_TABLE_SEGMENTS celdas uniformes sobre 0..CAL_TABLE_MAX_MV
+// indica el tramo donde empieza cada celda: evaluar es un índice, a lo sumo
+// un par de comparaciones y un multiply-add.
+class PiecewiseLinearTable {
+public:
+    PiecewiseLinearTable() : segmentCount(0) {}
+
+    // Compilar la tabla; queda inactiva con menos de dos puntos distintos
+    bool build(const CalPointSet& set);
+    void clear() { segmentCount = 0; }
+    bool isActive() const { return segmentCount > 0; }
+
+    float apply(float millivolts) const {
+        int cell = (int)(millivolts * (CAL_TABLE_SEGMENTS / CAL_TABLE_MAX_MV));
+        if (cell < 0) {
+            cell = 0;
+        } else if (cell >= CAL_TABLE_SEGMENTS) {
+            cell = CAL_TABLE_SEGMENTS - 1;
+        }
+
+        int segment = cellSegment[cell];
+        while (segment < segmentCount - 1 && millivolts > segmentEnd[segment]) {
+            segment++;
+        }
+        return segments[segment].apply(millivolts);
+    }
+
+private:
+    LinearConversion segments[CAL_MAX_POINTS - 1];
+    float segmentEnd[CAL_MAX_POINTS - 1];       // mV donde termina cada tramo
+    uint8_t cellSegment[CAL_TABLE_SEGMENTS];    // Tramo al inicio de cada celda
+    int segmentCount;
+};
+
+#endif // CALIBRATION_CURVE_H
@@ -0,0 +1,36 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRCs compartidos por el firmware y las herramientas de PC (sin Arduino)
+
+// CRC-16/CCITT-FALSE (polinomio 0x1021, inicial 0xFFFF)
+inline uint16_t crc16Ccitt(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// CRC-16/MCRF4XX, el "X.25" de MAVLink (0x1021 reflejado, inicial 0xFFFF,
+// sin inversión final). Byte a byte: el parser lo acumula mientras llegan
+inline uint16_t crc16X25Update(uint16_t crc, uint8_t data) {
+    uint8_t tmp = data ^ (uint8_t)(crc & 0xFF);
+    tmp ^= (uint8_t)(tmp << 4);
+    return (uint16_t)((crc >> 8) ^ ((uint16_t)tmp << 8) ^ ((uint16_t)tmp << 3) ^ (tmp >> 4));
+}
+
+// CRC-32 (IEEE 802.3, el de zlib). Acepta el resultado anterior para
+// calcularlo por partes: crc32Update(crc32Update(0, a, n), b, m)
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length);
+
+inline uint32_t crc32(const uint8_t* data, size_t length) {
+    return crc32Update(0, data, length);
+}
+
+#endif // CRC_H
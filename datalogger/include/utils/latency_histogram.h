@@ -0,0 +1,88 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+// Histograma de latencias en µs al estilo HDR: log-lineal, con
+// LATENCY_SUB_BUCKETS divisiones por cada potencia de dos. El error relativo
+// es de a lo sumo 1/LATENCY_SUB_BUCKETS (12.5%) en todo el rango de
+// uint32_t, con memoria fija y registro O(1) sin divisiones.
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS + (32 - LATENCY_SUB_BITS) * LATENCY_SUB_BUCKETS)
+
+struct LatencyHistogram {
+    uint32_t counts[LATENCY_BUCKETS];
+    uint32_t total;
+    uint32_t maxUs;
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        maxUs = 0;
+    }
+
+    void record(uint32_t us) {
+        counts[bucketOf(us)]++;
+        total++;
+        if (us > maxUs) {
+            maxUs = us;
+        }
+    }
+
+    // Valor bajo el cual cae el `percent`% de las muestras (cota superior
+    // de su bucket, sin pasar del máximo observado)
+    uint32_t percentile(float percent) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint32_t target = (uint32_t)ceilf(total * percent / 100.0f);
+        if (target < 1) {
+            target = 1;
+        }
+
+        uint32_t seen = 0;
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= target) {
+                uint32_t upper = bucketUpper(i);
+                return upper < maxUs ? upper : maxUs;
+            }
+        }
+        return maxUs;
+    }
+
+    String toString() const {
+        return "n=" + String(total) +
+               " p50=" + String(percentile(50)) +
+               " p99=" + String(percentile(99)) +
+               " máx=" + String(maxUs) + " µs";
+    }
+
+    // Valores chicos exactos; desde LATENCY_SUB_BUCKETS, los bits que siguen
+    // al más significativo eligen la división dentro de su potencia de dos
+    static int bucketOf(uint32_t us) {
+        if (us < LATENCY_SUB_BUCKETS) {
+            return us;
+        }
+        int exponent = 31 - __builtin_clz(us);
+        int shift = exponent - LATENCY_SUB_BITS;
+        int sub = (us >> shift) & (LATENCY_SUB_BUCKETS - 1);
+        return LATENCY_SUB_BUCKETS + shift * LATENCY_SUB_BUCKETS + sub;
+    }
+
+    static uint32_t bucketUpper(int bucket) {
+        if (bucket < LATENCY_SUB_BUCKETS) {
+            return bucket;
+        }
+        int shift = (bucket - LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS;
+        uint32_t sub = (bucket - LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS;
+        uint64_t lower = (uint64_t)(LATENCY_SUB_BUCKETS | sub) << shift;
+        uint64_t upper = lower + ((uint64_t)1 << shift) - 1;
+        return upper > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)upper;
+    }
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,23 @@
+#ifndef LINEAR_CONVERSION_H
+#define LINEAR_CONVERSION_H
+
+// Conversión lineal de cuentas del ADC a unidades de ingeniería:
+//   valor = cuentas * gain + offset
+// Los coeficientes se precalculan cuando cambia la calibración, así la
+// conversión por muestra es un solo multiply-add en float (la FPU del
+// ESP32-S3 es de precisión simple; los literales double la evitan).
+struct LinearConversion {
+    float gain;
+    float offset;
+
+    void set(float newGain, float newOffset) {
+        gain = newGain;
+        offset = newOffset;
+    }
+
+    float apply(float counts) const {
+        return counts * gain + offset;
+    }
+};
+
+#endif // LINEAR_CONVERSION_H
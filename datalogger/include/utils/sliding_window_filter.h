@@ -0,0 +1,214 @@
+#ifndef SLIDING_WINDOW_FILTER_H
+#define SLIDING_WINDOW_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// Filtro de ventana deslizante para muestras enteras.
+//  - Media: suma entera acumulada (exacta, O(1))
+//  - Mediana / media recortada: copia ordenada de la ventana que se actualiza
+//    por inserción (búsqueda binaria + memmove de a lo sumo MAX_WINDOW valores)
+//  - Varianza: Welford deslizante (O(1)), recalculada sobre la ventana cada
+//    vez que ésta da una vuelta completa para no acumular error de redondeo
+// El tamaño de ventana se elige en tiempo de ejecución hasta MAX_WINDOW.
+template <size_t MAX_WINDOW>
+class SlidingWindowFilter {
+public:
+    enum Mode {
+        MEAN = 0,
+        MEDIAN = 1,
+        TRIMMED_MEAN = 2
+    };
+
+    SlidingWindowFilter() : window(MAX_WINDOW), trim(0), mode(MEAN) {
+        reset();
+    }
+
+    // Elegir tamaño de ventana, modo de salida y muestras descartadas en
+    // cada extremo para la media recortada. Reinicia el filtro.
+    void configure(size_t windowSize, Mode filterMode, size_t trimCount) {
+        if (windowSize < 1) {
+            windowSize = 1;
+        }
+        if (windowSize > MAX_WINDOW) {
+            windowSize = MAX_WINDOW;
+        }
+        window = windowSize;
+        mode = filterMode;
+        trim = trimCount;
+        reset();
+    }
+
+    void reset() {
+        count = 0;
+        next = 0;
+        sum = 0;
+        lastSample = 0;
+        welfordMean = 0.0f;
+        welfordM2 = 0.0f;
+    }
+
+    void add(int32_t sample) {
+        if (count == window) {
+            // Ventana llena: reemplazar la muestra más antigua
+            int32_t oldest = samples[next];
+            removeSorted(oldest);
+            sum -= oldest;
+
+            float oldMean = welfordMean;
+            welfordMean += (float)(sample - oldest) / count;
+            welfordM2 += (float)(sample - oldest) * ((sample - welfordMean) + (oldest - oldMean));
+            if (welfordM2 < 0.0f) {
+                welfordM2 = 0.0f;
+            }
+        } else {
+            count++;
+            float delta = sample - welfordMean;
+            welfordMean += delta / count;
+            welfordM2 += delta * (sample - welfordMean);
+        }
+
+        samples[next] = sample;
+        next = (next + 1) % window;
+        insertSorted(sample);
+        sum += sample;
+        lastSample = sample;
+
+        // Re-anclar la varianza una vez por vuelta (costo amortizado O(1))
+        if (next == 0 && count == window) {
+            recomputeVariance();
+        }
+    }
+
+    // Salida según el modo configurado
+    float value() const {
+        switch (mode) {
+            case MEDIAN:       return median();
+            case TRIMMED_MEAN: return trimmedMean();
+            default:           return mean();
+        }
+    }
+
+    float mean() const {
+        return count > 0 ? (float)sum / count : 0.0f;
+    }
+
+    float median() const {
+        if (count == 0) {
+            return 0.0f;
+        }
+        if (count & 1) {
+            return sorted[count / 2];
+        }
+        return (sorted[count / 2 - 1] + sorted[count / 2]) * 0.5f;
+    }
+
+    // Media sin las `trim` muestras más bajas ni las `trim` más altas
+    float trimmedMean() const {
+        if (count == 0) {
+            return 0.0f;
+        }
+
+        size_t k = trim;
+        if (2 * k >= count) {
+            k = (count - 1) / 2;
+        }
+
+        int64_t trimmedSum = sum;
+        for (size_t i = 0; i < k; i++) {
+            trimmedSum -= sorted[i];
+            trimmedSum -= sorted[count - 1 - i];
+        }
+        return (float)trimmedSum / (count - 2 * k);
+    }
+
+    float variance() const {
+        return count > 1 ? welfordM2 / (count - 1) : 0.0f;
+    }
+
+    float stddev() const {
+        return sqrtf(variance());
+    }
+
+    size_t size() const { return count; }
+    size_t getWindow() const { return window; }
+    int32_t last() const { return lastSample; }
+
+private:
+    int32_t samples[MAX_WINDOW];    // Orden de llegada (circular)
+    int32_t sorted[MAX_WINDOW];     // Misma ventana ordenada
+    size_t window;
+    size_t trim;
+    Mode mode;
+
+    size_t count;
+    size_t next;                    // Próxima posición de escritura en samples
+    int64_t sum;
+    int32_t lastSample;
+    float welfordMean;
+    float welfordM2;
+
+    // Primera posición con sorted[i] > value entre las n primeras
+    size_t upperBound(int32_t value, size_t n) const {
+        size_t low = 0;
+        size_t high = n;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (sorted[mid] <= value) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // Primera posición con sorted[i] >= value entre las n primeras
+    size_t lowerBound(int32_t value, size_t n) const {
+        size_t low = 0;
+        size_t high = n;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (sorted[mid] < value) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // Se llama después de actualizar count: la ventana ordenada tiene count - 1 valores
+    void insertSorted(int32_t value) {
+        size_t n = count - 1;
+        size_t pos = upperBound(value, n);
+        memmove(&sorted[pos + 1], &sorted[pos], (n - pos) * sizeof(int32_t));
+        sorted[pos] = value;
+    }
+
+    // Se llama con la ventana llena, antes de insertar la muestra nueva.
+    // Si el valor no está (ventana inconsistente) no se mueve nada: insertSorted
+    // descarta entonces el mayor y el arreglo nunca se sale de rango
+    void removeSorted(int32_t value) {
+        size_t pos = lowerBound(value, count);
+        if (pos >= count || sorted[pos] != value) {
+            return;
+        }
+        memmove(&sorted[pos], &sorted[pos + 1], (count - pos - 1) * sizeof(int32_t));
+    }
+
+    void recomputeVariance() {
+        float m = mean();
+        float m2 = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            float d = samples[i] - m;
+            m2 += d * d;
+        }
+        welfordMean = m;
+        welfordM2 = m2;
+    }
+};
+
+#endif // SLIDING_WINDOW_FILTER_H
@@ -0,0 +1,71 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Cola acotada sin bloqueos para un único productor y un único consumidor.
+// Pensada para unir dos tareas fijadas en núcleos distintos: push() solo se
+// llama desde el productor y pop() solo desde el consumidor. N debe ser
+// potencia de 2.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue: N debe ser potencia de 2");
+
+public:
+    SpscQueue() : head(0), tail(0), dropped(0), highWater(0) {}
+
+    // Productor: encolar una copia. Devuelve false (y cuenta la pérdida) si está llena
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+
+        if (h - t >= N) {
+            dropped++;
+            return false;
+        }
+
+        buffer[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+
+        uint32_t used = h + 1 - t;
+        if (used > highWater) {
+            highWater = used;
+        }
+        return true;
+    }
+
+    // Consumidor: desencolar. Devuelve false si está vacía
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+
+        if (t == h) {
+            return false;
+        }
+
+        item = buffer[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Estadísticas (lecturas aproximadas desde cualquier tarea)
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return N; }
+    uint32_t getDropped() const { return dropped; }
+    uint32_t getHighWater() const { return highWater; }
+
+private:
+    T buffer[N];
+    std::atomic<uint32_t> head;     // Escrito solo por el productor
+    std::atomic<uint32_t> tail;     // Escrito solo por el consumidor
+
+    // Escritos solo por el productor
+    volatile uint32_t dropped;
+    volatile uint32_t highWater;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,45 @@
+#ifndef TEMPERATURE_COMPENSATION_H
+#define TEMPERATURE_COMPENSATION_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Compensación por temperatura del agua para EC y pH.
+//  - EC: referida a 25°C con coeficiente lineal α: EC25 = EC / (1 + α(T - 25))
+//  - pH: corrección de la pendiente de Nernst alrededor del punto isopotencial
+//        (pH 7): pH = 7 + (pH_medido - 7) * 298.15 / (T + 273.15)
+// Los factores están tabulados por grado; al llegar una temperatura nueva se
+// interpolan una sola vez y compensar cada muestra es un multiply.
+class TemperatureCompensation {
+public:
+    TemperatureCompensation();
+
+    // Última temperatura conocida y el millis() en que se recibió
+    void setTemperature(float celsius, uint32_t timestampMs);
+
+    // Hay una temperatura con menos de TEMP_COMP_MAX_AGE_MS de antigüedad
+    bool isValid(uint32_t nowMs) const;
+
+    float getTemperature() const { return temperature; }
+
+    float compensateEC(float ec) const { return ec * ecFactor; }
+    float compensatePH(float ph) const { return 7.0f + (ph - 7.0f) * phFactor; }
+
+private:
+    static const int TABLE_SIZE = TEMP_COMP_MAX_C - TEMP_COMP_MIN_C + 1;
+
+    float ecTable[TABLE_SIZE];
+    float phTable[TABLE_SIZE];
+
+    float temperature;
+    uint32_t timestamp;
+    bool hasTemperature;
+
+    // Factores de la temperatura actual
+    float ecFactor;
+    float phFactor;
+
+    float interpolate(const float* table, float celsius) const;
+};
+
+#endif // TEMPERATURE_COMPENSATION_H
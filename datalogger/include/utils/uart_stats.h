@@ -0,0 +1,61 @@
+#ifndef UART_STATS_H
+#define UART_STATS_H
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+
+// Contadores de recepción de un UART. Los errores llegan desde la cola de
+// eventos de ESP-IDF a través de HardwareSerial::onReceiveError().
+struct UartStats {
+    volatile uint32_t bytesReceived;
+    volatile uint32_t fifoOverflows;    // FIFO hardware desbordado (UART_FIFO_OVF_ERROR)
+    volatile uint32_t bufferFull;       // Buffer de recepción lleno (UART_BUFFER_FULL_ERROR)
+    volatile uint32_t frameErrors;
+    volatile uint32_t parityErrors;
+    volatile uint32_t breaks;
+    volatile uint32_t maxPending;       // Máximo de bytes pendientes al vaciar
+
+    void reset() {
+        bytesReceived = 0;
+        fifoOverflows = 0;
+        bufferFull = 0;
+        frameErrors = 0;
+        parityErrors = 0;
+        breaks = 0;
+        maxPending = 0;
+    }
+
+    void recordError(hardwareSerial_error_t error) {
+        switch (error) {
+            case UART_FIFO_OVF_ERROR:    fifoOverflows++; break;
+            case UART_BUFFER_FULL_ERROR: bufferFull++;    break;
+            case UART_FRAME_ERROR:       frameErrors++;   break;
+            case UART_PARITY_ERROR:      parityErrors++;  break;
+            case UART_BREAK_ERROR:       breaks++;        break;
+            default: break;
+        }
+    }
+
+    void recordPending(int pending) {
+        if (pending > 0 && (uint32_t)pending > maxPending) {
+            maxPending = pending;
+        }
+    }
+
+    // Bytes perdidos o corruptos: cualquier valor distinto de cero invalida el flujo
+    uint32_t lossEvents() const {
+        return fifoOverflows + bufferFull + frameErrors + parityErrors;
+    }
+
+    String toString() const {
+        return "rx=" + String(bytesReceived) +
+               " pendMax=" + String(maxPending) +
+               " ovf=" + String(fifoOverflows) +
+               " lleno=" + String(bufferFull) +
+               " frame=" + String(frameErrors) +
+               " paridad=" + String(parityErrors) +
+               " break=" + String(breaks);
+    }
+};
+
+#endif // UART_STATS_H
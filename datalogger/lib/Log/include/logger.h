@@ -34,6 +34,12 @@ public:
     
     // Establecer destinos de log
     static void setLogToSerial(bool enable);
+
+    // Salida diferida: los mensajes se encolan sin bloquear y se envían por
+    // Serial al llamar processDeferred() desde la tarea de E/S
+    static bool setDeferredOutput(size_t bufferSize);
+    static void processDeferred();
+    static unsigned long getDroppedMessages();
     
     // Métodos de logging
     static void error(const String& module, const String& message);
@@ -45,6 +51,8 @@ public:
 private:
     static LogLevel _defaultLevel;
     static bool _logToSerial;
+    static void* _deferredBuffer;
+    static unsigned long _droppedMessages;
     
     // Mapa para almacenar niveles por módulo
     static const int MAX_MODULES = 10;
@@ -88,6 +96,20 @@ inline void LogSetLevel(LogLevel level) {
     #endif
 }
 
+// Activar salida diferida (no bloqueante) con el tamaño de buffer dado
+inline void LogSetDeferred(size_t bufferSize) {
+    #if USE_LOGGER
+    Logger::setDeferredOutput(bufferSize);
+    #endif
+}
+
+// Enviar por Serial los mensajes diferidos pendientes
+inline void LogProcessDeferred() {
+    #if USE_LOGGER
+    Logger::processDeferred();
+    #endif
+}
+
 // Macros para logging (funcionan independientemente de USE_LOGGER)
 #if USE_LOGGER
 #define LOG_ERROR(module, message) \
@@ -3,12 +3,17 @@
 
 #if USE_LOGGER
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+
 // Inicialización de variables estáticas
 LogLevel Logger::_defaultLevel = INFO;
 bool Logger::_logToSerial = true;
 String Logger::_moduleNames[MAX_MODULES] = {};
 LogLevel Logger::_moduleLevels[MAX_MODULES] = {};
 int Logger::_moduleCount = 0;
+void* Logger::_deferredBuffer = nullptr;
+unsigned long Logger::_droppedMessages = 0;
 
 void Logger::init(LogLevel defaultLevel, bool useSerial) {
     _defaultLevel = defaultLevel;
@@ -57,6 +62,36 @@ void Logger::setLogToSerial(bool enable) {
     _logToSerial = enable;
 }
 
+bool Logger::setDeferredOutput(size_t bufferSize) {
+    if (_deferredBuffer != nullptr) {
+        return true;
+    }
+
+    // El ring buffer de ESP-IDF admite varios productores (una tarea por núcleo)
+    _deferredBuffer = xRingbufferCreate(bufferSize, RINGBUF_TYPE_NOSPLIT);
+    return _deferredBuffer != nullptr;
+}
+
+void Logger::processDeferred() {
+    if (_deferredBuffer == nullptr) {
+        return;
+    }
+
+    RingbufHandle_t ring = (RingbufHandle_t)_deferredBuffer;
+    size_t itemSize = 0;
+    char* item = (char*)xRingbufferReceive(ring, &itemSize, 0);
+    while (item != nullptr) {
+        Serial.write((const uint8_t*)item, itemSize);
+        Serial.println();
+        vRingbufferReturnItem(ring, item);
+        item = (char*)xRingbufferReceive(ring, &itemSize, 0);
+    }
+}
+
+unsigned long Logger::getDroppedMessages() {
+    return _droppedMessages;
+}
+
 void Logger::error(const String& module, const String& message) {
     log(ERROR, module, message);
 }
@@ -95,7 +130,15 @@ void Logger::log(LogLevel level, const String& module, const String& message) {
     
     // Enviar a salidas habilitadas
     if (_logToSerial) {
-        Serial.println(logMessage);
+        if (_deferredBuffer != nullptr) {
+            // Sin espera: si el buffer está lleno se descarta el mensaje
+            if (xRingbufferSend((RingbufHandle_t)_deferredBuffer, logMessage.c_str(),
+                                logMessage.length(), 0) != pdTRUE) {
+                _droppedMessages++;
+            }
+        } else {
+            Serial.println(logMessage);
+        }
     }
 }
 
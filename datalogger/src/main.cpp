@@ -7,6 +7,18 @@
 #include "modules/emergency_system.h"
 #include "modules/sonar_receiver.h"
 #include "modules/pixhawk_interface.h"
+#include "modules/time_sync.h"
+#include "modules/adc_sampler.h"
+#include "managers/task_scheduler.h"
+#include "modules/sample_record.h"
+#include "modules/record_schema.h"
+#include "modules/log_journal.h"
+#include "utils/alloc_counter.h"
+#include "utils/adc_calibration.h"
+
+#if DATALOGGER_DUAL_CORE
+#include "utils/spsc_queue.h"
+#endif
 
 // Instancia de configuración PROBADO Y CONFIRMADO
 AnalogSensors sensors;
@@ -15,10 +27,22 @@ SDLogger micro_sd;
 EmergencySystem emergencySystem;
 SonarReceiver sonar;
 PixhawkInterface pixhawk;
+TimeSync timeSync;
+AdcSampler adcSampler;
+TaskScheduler scheduler;
+
+// Reservas de heap del último registro (solo con ALLOC_STATS)
+uint32_t lastRecordAllocs = 0;
+
+#if DATALOGGER_DUAL_CORE
+// Planificador de E/S (núcleo de almacenamiento) y cola entre núcleos
+TaskScheduler ioScheduler;
+SpscQueue<SampleRecord, SAMPLE_QUEUE_SIZE> sampleQueue;
+TaskHandle_t acquisitionTaskHandle = nullptr;
+TaskHandle_t storageTaskHandle = nullptr;
+#endif
 
-// Variables de control de tiempo
-unsigned long lastDataLog = 0;
-unsigned long lastStatusDisplay = 0;
+// Intervalos de las tareas de registro y estado
 const unsigned long DATA_LOG_INTERVAL = 2000;    // Cada 2 segundos
 const unsigned long STATUS_DISPLAY_INTERVAL = 10000; // Mostrar estado cada 10 segundos
 
@@ -37,19 +61,22 @@ void init_logger(){
     LogSetModuleLevel("SONAR_RX", INFO);
     LogSetModuleLevel("PIXHAWK", DEBUG);
     LogSetModuleLevel("CMD", WARN);
+    LogSetModuleLevel("SCHED", INFO);
+    LogSetModuleLevel("ADC_DMA", INFO);
     
     LOG_INFO("MAIN", "Sistema datalogger iniciando...");
 #endif // USE_LOGGER
 }
 
 String createCSVHeader() {
-    String header = "Timestamp,";
+    String header = "Timestamp,UTC_us,";
     
     // 1. Datos del sonar
     header += sonar.getCSVHeader() + ",";
     
     // 2. Sensores analógicos
     header += "pH,DO,EC,";
+    header += "pH_TC,EC25,";       // Compensados por temperatura
     
     // 3. Datos de Pixhawk
     header += pixhawk.getCSVHeader();
@@ -60,6 +87,9 @@ String createCSVHeader() {
     return header;
 }
 
+#if ALLOC_STATS
+// Construcción histórica de la fila con String. Solo se conserva para medir
+// sus reservas de heap frente a la ruta con SampleRecord.
 String collectAllData() {
     String data = "";
     
@@ -73,20 +103,33 @@ String collectAllData() {
     data += String(sensors.lastPH, 3) + ",";
     data += String(sensors.lastDO, 3) + ",";
     data += String(sensors.lastEC, 1) + ",";
-    // data += String(sensors.lastRawPH) + ",";
-    // data += String(sensors.lastRawDO) + ",";
-    // data += String(sensors.lastRawEC) + ",";
     
     // 3. Datos de Pixhawk
     data += pixhawk.save_CSVData();
     
-    // 4. Sistema de emergencia
-    // data += String(emergencySystem.isEmergencyActive() ? 1 : 0) + ",";
-    // data += String(emergencySystem.getCurrentVoltage(), 3) + ",";
-    // data += String(emergencySystem.isPowerControlActive() ? 1 : 0);
-    
     return data;
 }
+#endif // ALLOC_STATS
+
+// Cada módulo completa sus campos del registro en el lugar (sin reservas)
+void captureSample(SampleRecord& record) {
+    // Un solo instante para ambos relojes (millis() es esp_timer / 1000)
+    int64_t now = esp_timer_get_time();
+    record.timestampMs = (uint32_t)(now / 1000);
+    record.utcUsec = timeSync.toUtc(now);
+
+    // 1. Datos del sonar
+    sonar.fillRecord(record);
+
+    // 2. Sensores analógicos
+    sensors.fillRecord(record);
+
+    // 3. Datos de Pixhawk
+    pixhawk.fillRecord(record);
+
+    // 4. Sistema de emergencia
+    // (no se registra)
+}
 
 void displaySystemStatus() {
     LOG_INFO("MAIN", "=================== ESTADO DEL SISTEMA ===================");
@@ -100,6 +143,7 @@ void displaySystemStatus() {
     } else {
         LOG_WARN("MAIN", "  Sin datos válidos de tiempo GPS");
     }
+    LOG_INFO("MAIN", "  Sincronización UTC: " + timeSync.toString());
 
     // Estado de emergencia
     LOG_INFO("MAIN", "  SISTEMA DE EMERGENCIA:");
@@ -125,6 +169,17 @@ void displaySystemStatus() {
     LOG_INFO("MAIN", "  pH: " + String(sensors.lastPH, 2) + " (raw: " + String(sensors.lastRawPH) + ")");
     LOG_INFO("MAIN", "  DO: " + String(sensors.lastDO, 2) + " mg/L (raw: " + String(sensors.lastRawDO) + ")");
     LOG_INFO("MAIN", "  EC: " + String(sensors.lastEC, 0) + " μS/cm (raw: " + String(sensors.lastRawEC) + ")");
+    if (!isnan(sensors.lastECCompensated)) {
+        LOG_INFO("MAIN", "  Compensados a " + String(sensors.getTemperatureCompensation().getTemperature(), 1) +
+                 "°C: pH " + String(sensors.lastPHCompensated, 2) + ", EC25 " + String(sensors.lastECCompensated, 0) + " μS/cm");
+    } else {
+        LOG_INFO("MAIN", "  Sin temperatura reciente - valores sin compensar");
+    }
+    LOG_INFO("MAIN", String("  Calibración ADC: ") + AdcCalibration::getSource());
+    if (adcSampler.isRunning()) {
+        LOG_INFO("MAIN", "  ADC continuo: " + String(adcSampler.getSampleCount(ADC_CH_PH)) +
+                 " muestras/canal, " + String(adcSampler.getOverruns()) + " desbordes");
+    }
     
     // Pixhawk
     LOG_INFO("MAIN", "  PIXHAWK:");
@@ -132,10 +187,155 @@ void displaySystemStatus() {
     LOG_INFO("MAIN", "  Altitud: " + String(pixhawk.getAltitude(), 1) + "m");
     LOG_INFO("MAIN", "  Batería: " + String(pixhawk.getBatteryVoltage(), 2) + "V (" + String(pixhawk.getBatteryRemaining()) + "%)");
     LOG_INFO("MAIN", "  Satélites: " + String(pixhawk.getNumSatellites()));
+
+    // Enlaces UART
+    LOG_INFO("MAIN", "  UART:");
+    LOG_INFO("MAIN", "  Pixhawk (Serial1): " + pixhawk.getRxStats().toString());
+    LOG_INFO("MAIN", "  MAVLink: " + pixhawk.getLinkStatsString());
+    LOG_INFO("MAIN", "  Sonar (Serial2): " + sonar.getRxStats().toString());
+    if (pixhawk.getRxStats().lossEvents() > 0 || sonar.getRxStats().lossEvents() > 0) {
+        LOG_WARN("MAIN", "  ¡Se perdieron bytes en recepción UART!");
+    }
+
+    // Tarjeta SD
+    LOG_INFO("MAIN", "  SD:");
+    micro_sd.showStats();
+
+    // Planificador
+    scheduler.showStats();
+
+#if ALLOC_STATS
+    // Comparar con la construcción histórica basada en String
+    uint32_t allocsBefore = allocCount();
+    collectAllData();
+    uint32_t legacyAllocs = allocCount() - allocsBefore;
+    LOG_INFO("MAIN", "  HEAP:");
+    LOG_INFO("MAIN", "  Reservas por registro: " + String(lastRecordAllocs) +
+             " (con String: " + String(legacyAllocs) + ")");
+    LOG_INFO("MAIN", "  Heap libre: " + String(ESP.getFreeHeap()) + " bytes, bloque máximo: " +
+             String(ESP.getMaxAllocHeap()) + " bytes");
+#endif
+
+#if DATALOGGER_DUAL_CORE
+    ioScheduler.showStats();
+    LOG_INFO("MAIN", "  DOBLE NÚCLEO:");
+    LOG_INFO("MAIN", "  Cola de registros: " + String(sampleQueue.size()) + "/" + String(sampleQueue.capacity()) +
+             " (máx " + String(sampleQueue.getHighWater()) + ", descartados " + String(sampleQueue.getDropped()) + ")");
+    LOG_INFO("MAIN", "  Stack libre adquisición/almacenamiento: " +
+             String(uxTaskGetStackHighWaterMark(acquisitionTaskHandle)) + "/" +
+             String(uxTaskGetStackHighWaterMark(storageTaskHandle)) + " bytes");
+#endif
     
     LOG_INFO("MAIN", "=========================================================");
 }
 
+// ====================== TAREAS PERIÓDICAS ======================
+void taskEmergency() {
+    emergencySystem.update();
+}
+
+void taskPixhawk() {
+    pixhawk.update();
+}
+
+void taskSonar() {
+    sonar.update();
+}
+
+void taskCommands() {
+    commandManager.update();
+}
+
+void taskAnalog() {
+    // Temperatura del agua más reciente para la compensación
+    if (sonar.hasValidData()) {
+        sensors.setWaterTemperature(sonar.getTemperature(), sonar.getLastDataTime());
+    }
+    sensors.update();
+}
+
+void taskDataLog() {
+    LOG_DEBUG("MAIN", "Capturando datos");
+    uint32_t allocsBefore = allocCount();
+    
+    // Recopilar todos los datos y copiarlos al buffer de la SD; la
+    // escritura la hace la tarea del SDLogger
+    SampleRecord record;
+    captureSample(record);
+    micro_sd.writeRecord(record);
+    lastRecordAllocs = allocCount() - allocsBefore;
+    
+    LOG_INFO("MAIN", "Registro en cola para la SD");
+}
+
+void taskStatus() {
+    displaySystemStatus();
+    // pixhawk.show_message();
+}
+
+#if DATALOGGER_DUAL_CORE
+// Núcleo de adquisición: solo captura, el formato y la SD van en el otro núcleo
+void taskCapture() {
+    SampleRecord record;
+    captureSample(record);
+
+    if (!sampleQueue.push(record)) {
+        LOG_WARN("MAIN", "Cola de registros llena - registro descartado");
+    }
+}
+
+// Núcleo de almacenamiento: formatear los registros pendientes en los buffers de la SD
+void taskStorage() {
+    SampleRecord record;
+
+    while (sampleQueue.pop(record)) {
+        uint32_t allocsBefore = allocCount();
+        micro_sd.writeRecord(record);
+        lastRecordAllocs = allocCount() - allocsBefore;
+    }
+
+    // Enviar por Serial los mensajes generados por el núcleo de adquisición
+    LogProcessDeferred();
+}
+
+void acquisitionTask(void* parameter) {
+    for (;;) {
+        scheduler.runAndSleep();
+    }
+}
+
+void storageTask(void* parameter) {
+    for (;;) {
+        ioScheduler.runAndSleep();
+    }
+}
+
+void startDualCoreTasks() {
+    // Adquisición: UARTs, ADC y emergencia
+    scheduler.addTask("EMERGENCY", taskEmergency, EMERGENCY_CHECK_RATE, TASK_EMERGENCY_DEADLINE);
+    scheduler.addTask("PIXHAWK", taskPixhawk, TASK_PIXHAWK_PERIOD, TASK_PIXHAWK_DEADLINE);
+    scheduler.addTask("SONAR", taskSonar, TASK_SONAR_PERIOD, TASK_SONAR_DEADLINE);
+    scheduler.addTask("ANALOG", taskAnalog, TASK_ANALOG_PERIOD, TASK_ANALOG_DEADLINE);
+    scheduler.addTask("CAPTURE", taskCapture, DATA_LOG_INTERVAL, TASK_DATA_LOG_DEADLINE);
+
+    // Almacenamiento: SD, comandos y reportes
+    ioScheduler.addTask("STORAGE", taskStorage, TASK_STORAGE_PERIOD, TASK_STORAGE_DEADLINE);
+    ioScheduler.addTask("COMMANDS", taskCommands, TASK_COMMANDS_PERIOD, TASK_COMMANDS_DEADLINE);
+    ioScheduler.addTask("STATUS", taskStatus, STATUS_DISPLAY_INTERVAL, TASK_STATUS_DEADLINE);
+
+    // A partir de aquí el log no bloquea al núcleo de adquisición
+    LogSetDeferred(LOG_DEFERRED_BUFFER_SIZE);
+
+    xTaskCreatePinnedToCore(acquisitionTask, "acquisition", ACQUISITION_TASK_STACK, nullptr,
+                            ACQUISITION_TASK_PRIORITY, &acquisitionTaskHandle, ACQUISITION_TASK_CORE);
+    xTaskCreatePinnedToCore(storageTask, "storage", STORAGE_TASK_STACK, nullptr,
+                            STORAGE_TASK_PRIORITY, &storageTaskHandle, STORAGE_TASK_CORE);
+
+    LOG_INFO("MAIN", "Modo doble núcleo: adquisición en núcleo " + String(ACQUISITION_TASK_CORE) +
+             ", almacenamiento en núcleo " + String(STORAGE_TASK_CORE));
+}
+#endif // DATALOGGER_DUAL_CORE
+
 void setup() {
     // Inicializar comunicación serial
     Serial.begin(115200);
@@ -155,6 +355,9 @@ void setup() {
     commandManager.begin();
     LOG_INFO("MAIN", "Sistema de comandos listo");
 
+    // Tabla cuentas → mV del ADC1 (usada por emergencia y sensores)
+    AdcCalibration::begin();
+
     // Inicializar sistema de emergencia (PRIORITARIO)
     LOG_INFO("MAIN", "Inicializando sistema de emergencia...");
     emergencySystem.begin();
@@ -164,6 +367,16 @@ void setup() {
     LOG_INFO("MAIN", "Inicializando sensores analógicos...");
     sensors.begin();
     LOG_INFO("MAIN", "Sensores analógicos listos");
+
+#if ANALOG_USE_DMA
+    // Muestreo continuo de pH/DO/EC y voltaje de batería (todos en ADC1)
+    if (adcSampler.begin()) {
+        sensors.setAdcSampler(&adcSampler);
+        emergencySystem.setAdcSampler(&adcSampler);
+    } else {
+        LOG_ERROR("MAIN", "Error al iniciar ADC continuo - usando analogRead()");
+    }
+#endif
     
     // Inicializar receptor de sonar
     LOG_INFO("MAIN", "Inicializando receptor de sonar...");
@@ -180,17 +393,47 @@ void setup() {
 
     // Conectar sistemas para coordinación
     emergencySystem.setPixhawkInterface(&pixhawk);
+    emergencySystem.setDataLogger(&micro_sd);
+    pixhawk.setTimeSync(&timeSync);
+    micro_sd.setTimeSync(&timeSync);
+    commandManager.setDataLogger(&micro_sd);
+    commandManager.setPixhawk(&pixhawk);
     
     // Inicializar tarjeta SD
     LOG_INFO("MAIN", "Inicializando tarjeta SD");
+#if SD_PREALLOCATE
+    // Espacio de toda la misión: registros esperados × bytes por registro
+    uint32_t expectedRecords = SD_MISSION_DURATION_MIN * 60000UL / DATA_LOG_INTERVAL;
+#if SD_LOG_COMPRESSED
+    uint32_t recordBytes = SD_DELTA_RECORD_ESTIMATE;
+#elif SD_LOG_BINARY
+    uint32_t recordBytes = binaryRecordSize();
+#else
+    uint32_t recordBytes = SD_CSV_RECORD_ESTIMATE;
+#endif
+#if SD_LOG_JOURNAL
+    recordBytes += sizeof(JournalFrameHeader);
+#endif
+    micro_sd.setPreallocation(expectedRecords * recordBytes);
+#endif
     if (micro_sd.begin()) {
         // Crear header del CSV con todos los datos
         String csvHeader = createCSVHeader();
         micro_sd.writeHeader(csvHeader);
-        LOG_INFO("MAIN", "Tarjeta SD lista");
+
+        // El esquema binario y tools/usvlog generan el header con los mismos nombres
+        char schemaHeader[SAMPLE_CSV_MAX_LENGTH];
+        if (formatSchemaCSVHeader(schemaHeader, sizeof(schemaHeader)) < 0 || csvHeader != schemaHeader) {
+            LOG_WARN("MAIN", "El header CSV no coincide con el esquema de registro");
+        }
+        if (micro_sd.isCardMounted()) {
+            LOG_INFO("MAIN", "Tarjeta SD lista");
+        } else {
+            LOG_WARN("MAIN", "Sin tarjeta SD: los registros esperan hasta que se monte");
+        }
         LOG_DEBUG("MAIN", "Header CSV: " + csvHeader);
     } else {
-        LOG_ERROR("MAIN", "Error al inicializar tarjeta SD");
+        LOG_ERROR("MAIN", "Error al iniciar el logger de la SD");
     }
     
     LOG_INFO("MAIN", "");
@@ -199,53 +442,26 @@ void setup() {
     LOG_INFO("MAIN", " Estado se mostrará cada " + String(STATUS_DISPLAY_INTERVAL/1000) + " segundos");
     LOG_INFO("MAIN", "");
     
-    // Mostrar estado inicial
-    displaySystemStatus();
+#if DATALOGGER_DUAL_CORE
+    startDualCoreTasks();
+#else
+    // Registrar tareas (el orden define la prioridad)
+    scheduler.addTask("EMERGENCY", taskEmergency, EMERGENCY_CHECK_RATE, TASK_EMERGENCY_DEADLINE);
+    scheduler.addTask("PIXHAWK", taskPixhawk, TASK_PIXHAWK_PERIOD, TASK_PIXHAWK_DEADLINE);
+    scheduler.addTask("SONAR", taskSonar, TASK_SONAR_PERIOD, TASK_SONAR_DEADLINE);
+    scheduler.addTask("COMMANDS", taskCommands, TASK_COMMANDS_PERIOD, TASK_COMMANDS_DEADLINE);
+    scheduler.addTask("ANALOG", taskAnalog, TASK_ANALOG_PERIOD, TASK_ANALOG_DEADLINE);
+    scheduler.addTask("DATA_LOG", taskDataLog, DATA_LOG_INTERVAL, TASK_DATA_LOG_DEADLINE);
+    scheduler.addTask("STATUS", taskStatus, STATUS_DISPLAY_INTERVAL, TASK_STATUS_DEADLINE);
+#endif
 }
 
 void loop() {
-    unsigned long currentTime = millis();
-
-    // Procesar comandos seriales
-    commandManager.update();
-
-    // Sistema de emergencia
-    emergencySystem.update();
-    
-    // ===== ACTUALIZAR TODOS LOS MÓDULOS =====
-    // Actualizar sensores analógicos
-    sensors.update();
-    
-    // Actualizar receptor de sonar
-    sonar.update();
-    
-    // Actualizar interfaz Pixhawk
-    pixhawk.update();
-        
-    // ===== CAPTURA Y ALMACENAMIENTO DE DATOS =====
-    if (currentTime - lastDataLog >= DATA_LOG_INTERVAL) {
-        LOG_DEBUG("MAIN", "Capturando datos");
-        
-        // Recopilar todos los datos
-        String allData = collectAllData();
-        
-        // Escribir a SD
-        micro_sd.writeData(allData);
-        micro_sd.update();
-        
-        LOG_INFO("MAIN", "Datos guardados en SD");
-        LOG_VERBOSE("MAIN", "Datos: " + allData);
-        
-        lastDataLog = currentTime;
-    }
-    
-    // ===== MOSTRAR ESTADO DEL SISTEMA =====
-    if (currentTime - lastStatusDisplay >= STATUS_DISPLAY_INTERVAL) {
-        displaySystemStatus();
-        lastStatusDisplay = currentTime;
-        // pixhawk.show_message();
-    }
-        
-    // Pequeña pausa para no saturar el procesador
-    delay(1600);
+#if DATALOGGER_DUAL_CORE
+    // Todo el trabajo está en las tareas fijadas a cada núcleo
+    vTaskDelete(NULL);
+#else
+    // Ejecutar las tareas vencidas y dormir hasta la próxima
+    scheduler.runAndSleep();
+#endif
 }
\ No newline at end of file
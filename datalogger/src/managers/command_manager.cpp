@@ -2,7 +2,8 @@
 #include "managers/eeprom_manager.h"
 
 
-CommandManager::CommandManager(AnalogSensors& sensors) : sensors(sensors) {
+CommandManager::CommandManager(AnalogSensors& sensors) : sensors(sensors), dataLogger(nullptr), pixhawk(nullptr),
+                                                      benchPending(false) {
 }
 
 void CommandManager::begin() {    
@@ -19,6 +20,12 @@ void CommandManager::begin() {
 }
 
 void CommandManager::update() {   
+    // Resultado de sd_bench cuando la tarea de la SD termina
+    if (benchPending && !dataLogger->isBenchmarkRunning()) {
+        benchPending = false;
+        displaySdBenchmark();
+    }
+
     // Procesar comandos
     if (Serial.available() > 0) {
         String command = Serial.readStringUntil('\n');
@@ -36,6 +43,7 @@ void CommandManager::processCommand(String command) {
         int rawValue = sensors.calibrateCurrentPH(knownPH);
 
         String msg = "pH calibrado a " + String(knownPH) + " (en el valor crudo: " + String(rawValue) + ")";
+        msg += calibrationSummary(ADC_CH_PH);
         LOG_INFO("CMD", msg);
         Serial.println(msg);  // También mostrar en serial para respuesta inmediata
     }
@@ -46,6 +54,7 @@ void CommandManager::processCommand(String command) {
         int rawValue = sensors.calibrateCurrentDO(knownDO);
         
         String msg = "Oxígeno disuelto calibrado a " + String(knownDO) + " mg/L (valor crudo: " + String(rawValue) + ")";
+        msg += calibrationSummary(ADC_CH_DO);
         LOG_INFO("CMD", msg);
         Serial.println(msg);
     }
@@ -56,10 +65,28 @@ void CommandManager::processCommand(String command) {
         int rawValue = sensors.calibrateCurrentEC(knownEC);
         
         String msg = "Conductividad calibrada a " + String(knownEC) + " μS/cm (valor crudo: " + String(rawValue) + ")";
+        msg += calibrationSummary(ADC_CH_EC);
         LOG_INFO("CMD", msg);
         Serial.println(msg);
     }
     
+    // Descartar los puntos de referencia de un sensor: cal_clear <ph|do|ec>
+    else if (command.startsWith("cal_clear")) {
+        String name = command.substring(10);
+        name.trim();
+
+        if (name == "ph" || name == "do" || name == "ec") {
+            AdcChannelId channel = name == "ph" ? ADC_CH_PH : (name == "do" ? ADC_CH_DO : ADC_CH_EC);
+            sensors.clearCalibrationPoints(channel);
+
+            String msg = "Puntos de calibración de " + name + " descartados (se conservan slope y offset)";
+            LOG_INFO("CMD", msg);
+            Serial.println(msg);
+        } else {
+            Serial.println("Uso: cal_clear <ph|do|ec>");
+        }
+    }
+    
 // ************ COMANDOS CALIBRACION MANUAL ************
 // Comandos adicionales para setear offset y slope directamente
     else if (command.startsWith("set_ph_offset")) {
@@ -106,33 +133,39 @@ void CommandManager::processCommand(String command) {
         float offset = command.substring(14).toFloat();
         float currentSlope = sensors.ecSlope;
         float currentK = sensors.ecK;
-        sensors.setEcCalibration(offset, currentSlope, currentK);
-        
-        String msg = "EC offset seteado a: " + String(offset, 4);
-        LOG_INFO("CMD", msg);
-        Serial.println(msg);
+        if (!sensors.setEcCalibration(offset, currentSlope, currentK)) {
+            Serial.println("Calibración EC rechazada: constante K guardada inválida (usar set_ec_k)");
+        } else {
+            String msg = "EC offset seteado a: " + String(offset, 4);
+            LOG_INFO("CMD", msg);
+            Serial.println(msg);
+        }
     }
     
     else if (command.startsWith("set_ec_slope")) {
         float slope = command.substring(13).toFloat();
         float currentOffset = sensors.ecOffset;
         float currentK = sensors.ecK;
-        sensors.setEcCalibration(currentOffset, slope, currentK);
-        
-        String msg = "EC slope seteado a: " + String(slope, 4);
-        LOG_INFO("CMD", msg);
-        Serial.println(msg);
+        if (!sensors.setEcCalibration(currentOffset, slope, currentK)) {
+            Serial.println("Calibración EC rechazada: constante K guardada inválida (usar set_ec_k)");
+        } else {
+            String msg = "EC slope seteado a: " + String(slope, 4);
+            LOG_INFO("CMD", msg);
+            Serial.println(msg);
+        }
     }
 
     else if (command.startsWith("set_ec_k")) {
         float k = command.substring(9).toFloat();
         float currentOffset = sensors.ecOffset;
         float currentSlope = sensors.ecSlope;
-        sensors.setEcCalibration(currentOffset, currentSlope, k);
-        
-        String msg = "EC constante K seteada a: " + String(k, 4);
-        LOG_INFO("CMD", msg);
-        Serial.println(msg);
+        if (!sensors.setEcCalibration(currentOffset, currentSlope, k)) {
+            Serial.println("Constante K inválida: debe ser mayor que 0");
+        } else {
+            String msg = "EC constante K seteada a: " + String(k, 4);
+            LOG_INFO("CMD", msg);
+            Serial.println(msg);
+        }
     }
 
 // ************ COMANDOS DE GESTIÓN EEPROM ************
@@ -148,6 +181,37 @@ void CommandManager::processCommand(String command) {
         LOG_INFO("CMD", "EEPROM borrada");
     }
 
+// ************ COMANDOS DE ADQUISICION ************
+    // Sobremuestreo por canal: set_os <ph|do|ec> <n>
+    else if (command.startsWith("set_os")) {
+        String args = command.substring(7);
+        args.trim();
+        int space = args.indexOf(' ');
+        String name = args.substring(0, space);
+        int bits = space > 0 ? args.substring(space + 1).toInt() : -1;
+
+        AdcChannelId channel = ADC_CH_PH;
+        bool validName = true;
+        if (name == "ph") {
+            channel = ADC_CH_PH;
+        } else if (name == "do") {
+            channel = ADC_CH_DO;
+        } else if (name == "ec") {
+            channel = ADC_CH_EC;
+        } else {
+            validName = false;
+        }
+
+        if (validName && sensors.setOversampling(channel, bits)) {
+            String msg = "Sobremuestreo " + name + ": " + String(1 << (2 * bits)) +
+                         " muestras por salida (" + String(12 + bits) + " bits)";
+            LOG_INFO("CMD", msg);
+            Serial.println(msg);
+        } else {
+            Serial.println("Uso: set_os <ph|do|ec> <n>  (n = 0.." + String(ANALOG_MAX_OVERSAMPLE) + ")");
+        }
+    }
+
 // ************ COMANDOS COMUNES ************
     // Comando para mostrar datos
     else if (command == "show_data") {
@@ -163,6 +227,76 @@ void CommandManager::processCommand(String command) {
         displayCalibrationData();
     }
 
+    // Estadísticas de la escritura en SD: sd_stats [reset]
+    else if (command.startsWith("sd_stats")) {
+        if (dataLogger == nullptr) {
+            Serial.println("SD no disponible");
+        } else if (command.substring(8).indexOf("reset") >= 0) {
+            dataLogger->resetStats();
+            Serial.println("Estadísticas de la SD reiniciadas");
+        } else {
+            displaySdStats();
+        }
+    }
+
+    // Prueba de la tarjeta: sd_bench [KB]
+    else if (command.startsWith("sd_bench")) {
+        if (dataLogger == nullptr) {
+            Serial.println("SD no disponible");
+        } else {
+            long kb = command.length() > 8 ? command.substring(8).toInt() : SD_BENCH_DEFAULT_KB;
+            if (kb <= 0 || kb > SD_BENCH_MAX_KB) {
+                Serial.println("Tamaño inválido (1-" + String(SD_BENCH_MAX_KB) + " KB)");
+            } else if (benchPending) {
+                Serial.println("Ya hay una prueba de la SD en curso");
+            } else {
+                runSdBenchmark((uint32_t)kb);
+            }
+        }
+    }
+
+    // Cerrar el archivo antes de retirar la tarjeta
+    else if (command == "sd_close") {
+        if (dataLogger == nullptr) {
+            Serial.println("SD no disponible");
+        } else {
+            dataLogger->close();
+            Serial.println("Archivo cerrado (" + String(dataLogger->getDataLength()) +
+                           " bytes). Reinicie para volver a registrar.");
+        }
+    }
+
+    // Enlace con el Pixhawk: mav_stats [reset]
+    else if (command.startsWith("mav_stats")) {
+        if (pixhawk == nullptr) {
+            Serial.println("Pixhawk no disponible");
+        } else if (command.substring(9).indexOf("reset") >= 0) {
+            pixhawk->resetLinkStats();
+            Serial.println("Estadísticas de MAVLink reiniciadas");
+        } else {
+            displayMavlinkStats();
+        }
+    }
+
+    // Respaldo en la flash interna: dump_flash [archivo|*]
+    else if (command.startsWith("dump_flash")) {
+        if (dataLogger == nullptr) {
+            Serial.println("SD no disponible");
+        } else {
+            dumpFlash(command.substring(10));
+        }
+    }
+
+    // Borrar los archivos de la flash ya volcados (salvo el activo)
+    else if (command == "flash_clear") {
+        if (dataLogger == nullptr || !dataLogger->isFlashMounted()) {
+            Serial.println("Flash interna no disponible");
+        } else {
+            uint32_t removed = dataLogger->removeFlashFiles();
+            Serial.println(String(removed) + " archivos borrados de la flash");
+        }
+    }
+
     // Comando no reconocido
     else {
         String msg = "Comando no reconocido: '" + command + "'. Escriba 'help' para ver comandos disponibles.";
@@ -192,19 +326,40 @@ void CommandManager::displaySensorData() {
     Serial.print(ph, 2);
     Serial.print(" (raw: ");
     Serial.print(phRaw);
+    Serial.print(" ± ");
+    Serial.print(sensors.getRawStdDev(ADC_CH_PH), 1);
     Serial.println(")");
+    printResolution(ADC_CH_PH);
     
     Serial.print("Oxígeno Disuelto: ");
     Serial.print(dissolvedOxygen, 2);
     Serial.print(" mg/L (raw: ");
     Serial.print(doRaw);
+    Serial.print(" ± ");
+    Serial.print(sensors.getRawStdDev(ADC_CH_DO), 1);
     Serial.println(")");
+    printResolution(ADC_CH_DO);
     
     Serial.print("Conductividad: ");
     Serial.print(conductivity, 0);
     Serial.print(" μS/cm (raw: ");
     Serial.print(ecRaw);
+    Serial.print(" ± ");
+    Serial.print(sensors.getRawStdDev(ADC_CH_EC), 1);
     Serial.println(")");
+    printResolution(ADC_CH_EC);
+
+    if (!isnan(sensors.lastECCompensated)) {
+        Serial.print("Compensados a ");
+        Serial.print(sensors.getTemperatureCompensation().getTemperature(), 1);
+        Serial.print("°C: pH ");
+        Serial.print(sensors.lastPHCompensated, 2);
+        Serial.print(", EC25 ");
+        Serial.print(sensors.lastECCompensated, 0);
+        Serial.println(" μS/cm");
+    } else {
+        Serial.println("Sin temperatura del agua reciente: valores sin compensar");
+    }
     Serial.println("========================================");
     
     String logMsg = "Datos mostrados - pH: " + String(ph, 2) + 
@@ -215,19 +370,27 @@ void CommandManager::displaySensorData() {
 
 void CommandManager::displayCalibrationData() {
     Serial.println("\n========== VALORES DE CALIBRACIÓN ACTUALES ==========");
+
+    if (EEPROMManager::hasLegacyData()) {
+        Serial.println("AVISO: la calibración guardada es de una versión anterior (escala ADC");
+        Serial.println("ideal 3.3V/4095) y fue descartada. Recalibrar los sensores.");
+    }
     
     Serial.println("pH:");
     Serial.print("  Offset: "); Serial.println(sensors.phOffset, 4);
     Serial.print("  Slope:  "); Serial.println(sensors.phSlope, 4);
+    printCalibrationPoints(ADC_CH_PH);
     
     Serial.println("Oxígeno Disuelto (DO):");
     Serial.print("  Offset: "); Serial.println(sensors.doOffset, 4);
     Serial.print("  Slope:  "); Serial.println(sensors.doSlope, 4);
+    printCalibrationPoints(ADC_CH_DO);
     
     Serial.println("Conductividad Eléctrica (EC):");
     Serial.print("  Offset: "); Serial.println(sensors.ecOffset, 4);
     Serial.print("  Slope:  "); Serial.println(sensors.ecSlope, 4);
     Serial.print("  K:      "); Serial.println(sensors.ecK, 4);
+    printCalibrationPoints(ADC_CH_EC);
 
     Serial.println("=====================================================");
     
@@ -235,11 +398,55 @@ void CommandManager::displayCalibrationData() {
     Serial.println("pH = 7.0 + ((voltaje - 2.5) / slope) + offset");
     Serial.println("DO = voltaje * slope + offset");
     Serial.println("EC = voltaje * K * slope + offset");
+    if (sensors.isEcCurveActive()) {
+        Serial.println("EC: curva lineal por tramos a través de los puntos (reemplaza la fórmula)");
+    }
     Serial.println("=====================================================\n");
     
     LOG_DEBUG("CMD", "Valores de calibración mostrados");
 }
 
+// Estado del ajuste tras agregar un punto de calibración
+String CommandManager::calibrationSummary(AdcChannelId channel) {
+    int count = sensors.getCalibrationPoints(channel).count;
+    if (count < 2) {
+        return " - 1 punto, solo offset";
+    }
+
+    String summary = " - " + String(count) + " puntos, error máx " + String(sensors.getLastFitResidual(), 3);
+    if (channel == ADC_CH_EC && sensors.isEcCurveActive()) {
+        summary += ", curva por tramos";
+    }
+    return summary;
+}
+
+// Puntos de referencia guardados de un sensor (para show_cal)
+void CommandManager::printCalibrationPoints(AdcChannelId channel) {
+    const CalPointSet& set = sensors.getCalibrationPoints(channel);
+    Serial.print("  Puntos: ");
+    Serial.println(set.count);
+    for (int i = 0; i < set.count; i++) {
+        Serial.print("    ");
+        Serial.print(set.points[i].millivolts, 1);
+        Serial.print(" mV → ");
+        Serial.println(set.points[i].value, 3);
+    }
+}
+
+// Resolución efectiva y piso de ruido de un canal (para show_data)
+void CommandManager::printResolution(AdcChannelId channel) {
+    int bits = sensors.getOversampling(channel);
+    Serial.print("    x");
+    Serial.print(1 << (2 * bits));
+    Serial.print(" → ");
+    Serial.print(12 + bits);
+    Serial.print(" bits, efectivos: ");
+    Serial.print(sensors.getEffectiveBits(channel), 1);
+    Serial.print(", ruido: ");
+    Serial.print(sensors.getNoiseMillivolts(channel), 2);
+    Serial.println(" mV");
+}
+
 // ====================== MENSAJE DE AYUDA ======================
 void CommandManager::displayHelp() {
     Serial.println("\n=================== COMANDOS DISPONIBLES ===================");
@@ -247,6 +454,8 @@ void CommandManager::displayHelp() {
     Serial.println("  cal_ph X     - Calibrar sensor de pH con valor conocido X");
     Serial.println("  cal_do X     - Calibrar sensor de oxígeno disuelto con valor conocido X (mg/L)");
     Serial.println("  cal_ec X     - Calibrar sensor de conductividad con valor conocido X (μS/cm)");
+    Serial.println("  cal_clear S  - Descartar los puntos de referencia del sensor S (ph, do o ec)");
+    Serial.println("  (Cada cal_* agrega un punto; con 2 o más se ajustan slope y offset)");
     Serial.println("");
     Serial.println("CALIBRACIÓN AVANZADA: \t (Setear offset y slope directamente con el valor)");
     Serial.println("  set_ph_offset X   - Setear offset de pH a X");
@@ -257,6 +466,9 @@ void CommandManager::displayHelp() {
     Serial.println("  set_ec_slope X    - Setear slope de EC a X");
     Serial.println("  set_ec_k X        - Setear constante K de EC a X");
     Serial.println("");
+    Serial.println("ADQUISICIÓN:");
+    Serial.println("  set_os <ph|do|ec> N - Sobremuestrear 4^N lecturas por salida (12+N bits, N = 0..3)");
+    Serial.println("");
     Serial.println("GESTIÓN EEPROM:");
     Serial.println("  reset_cal    - Reiniciar calibraciones a valores por defecto");
     Serial.println("  clear_eeprom - Borrar completamente la EEPROM");
@@ -264,8 +476,146 @@ void CommandManager::displayHelp() {
     Serial.println("DATOS:");
     Serial.println("  show_data    - Mostrar lecturas actuales de sensores");
     Serial.println("  show_cal     - Mostrar variables de calibracion almacenadas");
+    Serial.println("  sd_stats     - Buffers, tiempos y descartes de la SD ('sd_stats reset' los reinicia)");
+    Serial.println("  sd_bench [KB] - Probar la tarjeta: velocidad y latencias p50/p99/máx (" +
+                   String(SD_BENCH_DEFAULT_KB) + " KB por defecto)");
+    Serial.println("  sd_close     - Cerrar el archivo (truncar la preasignación) antes de retirar la SD");
+    Serial.println("  mav_stats    - Enlace con el Pixhawk: tasas, CRC y frames perdidos ('mav_stats reset')");
+    Serial.println("  dump_flash [archivo|*] - Listar los logs de la flash interna o enviarlos por USB");
+    Serial.println("  flash_clear  - Borrar los logs de la flash interna (salvo el activo)");
     Serial.println("  help         - Mostrar esta ayuda");
     Serial.println("==========================================================\n");
     
     LOG_DEBUG("CMD", "Ayuda mostrada");
-}
\ No newline at end of file
+}
+
+// ====================== ESTADÍSTICAS SD ======================
+void CommandManager::displaySdStats() {
+    const SdWriteStats& stats = dataLogger->getStats();
+    uint32_t avgWrite = stats.writes > 0 ? stats.totalWriteUs / stats.writes : 0;
+    uint32_t avgFlush = stats.flushes > 0 ? stats.totalFlushUs / stats.flushes : 0;
+    uint32_t avgEncode = stats.encodedRecords > 0 ? stats.totalEncodeUs / stats.encodedRecords : 0;
+    uint32_t avgRecord = stats.encodedRecords > 0 ? stats.encodedBytes / stats.encodedRecords : 0;
+
+    Serial.println("\n=================== ESCRITURA SD ===================");
+    Serial.println("Buffers ocupados: " + String(dataLogger->getBuffersInUse()) + "/" + String(SD_BUFFER_COUNT) +
+                   " (máx " + String(stats.buffersHighWater) + ")");
+    Serial.println("Bytes pendientes: " + String(dataLogger->getPendingBytes()) +
+                   " (máx " + String(stats.pendingHighWater) + ")");
+    Serial.println("Registros descartados: " + String(stats.droppedRecords));
+    Serial.println("Tarjeta: " + String(dataLogger->isCardMounted() ? "montada" : "AUSENTE") +
+                   ", montajes: " + String(stats.remounts) + ", bytes descartados por cambio de tarjeta: " +
+                   String(stats.discardedBytes));
+    Serial.println("Spool PSRAM: " + String(dataLogger->getSpoolCount()) + "/" + String(dataLogger->getSpoolCapacity()) +
+                   " registros (máx " + String(stats.spoolHighWater) + ", total " + String(stats.spooledRecords) + ")");
+    if (dataLogger->isFlashMounted()) {
+        Serial.println("Flash interna: " + String(dataLogger->isOnFlash() ? "REGISTRANDO" : "en espera") + ", " +
+                       String(dataLogger->getFlashUsedBytes() / 1024) + "/" +
+                       String(dataLogger->getFlashTotalBytes() / 1024) + " KB, pasos a la flash: " +
+                       String(stats.flashFallbacks) + ", bytes en .part: " + String(stats.spilledBytes));
+    }
+    Serial.println("Bloqueo máx de la SD: " + String(stats.maxStallUs) + " µs");
+    Serial.println("Escrituras: " + String(stats.writes) + " (" + String(stats.bytesWritten) + " bytes), prom " +
+                   String(avgWrite) + " µs, máx " + String(stats.maxWriteUs) + " µs");
+    Serial.println("Flush: " + String(stats.flushes) + ", prom " + String(avgFlush) + " µs, máx " +
+                   String(stats.maxFlushUs) + " µs");
+    Serial.println("Errores apertura/escritura: " + String(stats.openFailures) + "/" + String(stats.writeErrors));
+    Serial.println("Registros: " + String(stats.encodedRecords) + ", prom " + String(avgRecord) +
+                   " bytes, codificación prom " + String(avgEncode) + " µs, máx " + String(stats.maxEncodeUs) + " µs");
+    Serial.println("Latencia apertura:  " + stats.openLatency.toString());
+    Serial.println("Latencia escritura: " + stats.writeLatency.toString());
+    Serial.println("Latencia flush:     " + stats.flushLatency.toString());
+    Serial.println("Archivo: " + dataLogger->getFilename() + ", rotaciones: " + String(stats.rotations));
+    if (dataLogger->getAllocatedSize() > 0) {
+        Serial.println("Archivo preasignado: " + String(dataLogger->getDataLength()) + "/" +
+                       String(dataLogger->getAllocatedSize()) + " bytes usados");
+    }
+    Serial.println("====================================================\n");
+}
+
+// ====================== PRUEBA DE LA SD ======================
+void CommandManager::runSdBenchmark(uint32_t kb) {
+    if (!dataLogger->startBenchmark(kb * 1024, benchResult)) {
+        Serial.println("No se pudo iniciar la prueba: SD no montada");
+        return;
+    }
+    benchPending = true;
+    Serial.println("Probando la SD con " + String(kb) + " KB (bloques de " + String(SD_BATCH_BUFFER_SIZE) +
+                   " bytes con flush por bloque)...");
+}
+
+void CommandManager::displaySdBenchmark() {
+    const SdBenchResult& result = benchResult;
+    bool ok = result.ok;
+
+    Serial.println("\n=================== PRUEBA DE LA SD ===================");
+    Serial.println("Bus: " + dataLogger->getBusDescription());
+    if (!ok && result.bytes == 0) {
+        Serial.println("No se pudo escribir el archivo de prueba");
+    } else {
+        Serial.println("Escrito: " + String(result.bytes / 1024) + " KB en " + String(result.elapsedUs / 1000) +
+                       " ms -> " + String(result.kbPerSecond()) + " KB/s" + (ok ? "" : " (error de escritura)"));
+
+        // Cuánto del bus medido ocupa el log actual y cuánto queda para otros flujos
+        uint32_t logRate = dataLogger->getLogBytesPerSecond();
+        uint32_t busRate = result.kbPerSecond() * 1024;
+        if (busRate > 0) {
+            Serial.println("Carga del log: " + String(logRate) + " B/s (" +
+                           String(100.0f * logRate / busRate, 2) + "% del bus), libre: " +
+                           String((busRate > logRate ? busRate - logRate : 0) / 1024) + " KB/s");
+        }
+    }
+    Serial.println("Apertura:  " + result.openLatency.toString());
+    Serial.println("Escritura: " + result.writeLatency.toString());
+    Serial.println("Flush:     " + result.flushLatency.toString());
+    Serial.println("====================================================\n");
+}
+
+// ====================== ENLACE MAVLINK ======================
+void CommandManager::displayMavlinkStats() {
+    const MavlinkParser& link = pixhawk->getLink();
+    const MavlinkStats& stats = link.getStats();
+
+    Serial.println("\n=================== ENLACE MAVLINK ===================");
+    Serial.println(pixhawk->getLinkStatsString());
+    Serial.println("Frames válidos: " + String(stats.frames) + " (firmados " + String(stats.signedFrames) +
+                   "), bytes: " + String(stats.bytes));
+    Serial.println("UART: " + pixhawk->getRxStats().toString());
+    for (int i = 0; i < link.getLinkCount(); i++) {
+        const MavlinkLinkSequence& sequence = link.getLink(i);
+        Serial.println("  Sistema " + String(sequence.systemId) + "/" + String(sequence.componentId) + ": " +
+                       String(sequence.frames) + " frames, " + String(sequence.lostFrames) + " perdidos");
+    }
+    if (stats.untrackedFrames > 0) {
+        Serial.println("  Otros emisores (sin seguimiento): " + String(stats.untrackedFrames) + " frames");
+    }
+    Serial.println("======================================================\n");
+}
+
+// ====================== FLASH INTERNA ======================
+// Sin argumento lista los archivos; con un nombre (o * para todos) los envía
+// crudos por el USB entre líneas de inicio y fin
+void CommandManager::dumpFlash(String args) {
+    args.trim();
+    if (args.length() == 0) {
+        Serial.println("\n=================== FLASH INTERNA ===================");
+        dataLogger->listFlashFiles(Serial);
+        Serial.println("'dump_flash <archivo>' o 'dump_flash *' para enviarlos");
+        Serial.println("====================================================\n");
+        return;
+    }
+
+    if (args != "*") {
+        if (!dataLogger->dumpFlashFile(args, Serial)) {
+            Serial.println("No se pudo leer '" + args + "' de la flash");
+        }
+        return;
+    }
+
+    if (!dataLogger->isFlashMounted()) {
+        Serial.println("Flash interna no disponible");
+        return;
+    }
+    uint32_t sent = dataLogger->dumpFlashFiles(Serial);
+    Serial.println(String(sent) + " archivos enviados");
+}
@@ -87,6 +87,56 @@ bool EEPROMManager::loadCalibrations(float& phOffset, float& phSlope,
     return true;
 }
 
+bool EEPROMManager::saveCalibrationPoints(const MultiPointCalibration& points) {
+    if (!initialized) {
+        LOG_ERROR("EEPROM", "EEPROM no inicializado");
+        return false;
+    }
+
+    MultiPointCalibration data = points;
+    data.magic = POINTS_MAGIC_NUMBER;
+
+    const uint8_t* dataPtr = (const uint8_t*)&data;
+    for (size_t i = 0; i < sizeof(MultiPointCalibration); i++) {
+        EEPROM.write(EEPROM_POINTS_ADDRESS + i, dataPtr[i]);
+    }
+
+    bool success = EEPROM.commit();
+
+    if (success) {
+        LOG_INFO("EEPROM", "Puntos de calibración guardados correctamente");
+    } else {
+        LOG_ERROR("EEPROM", "Error al guardar puntos de calibración");
+    }
+
+    return success;
+}
+
+bool EEPROMManager::loadCalibrationPoints(MultiPointCalibration& points) {
+    if (!initialized) {
+        LOG_ERROR("EEPROM", "EEPROM no inicializado");
+        return false;
+    }
+
+    MultiPointCalibration data;
+    uint8_t* dataPtr = (uint8_t*)&data;
+    for (size_t i = 0; i < sizeof(MultiPointCalibration); i++) {
+        dataPtr[i] = EEPROM.read(EEPROM_POINTS_ADDRESS + i);
+    }
+
+    // Memoria escrita por una versión sin multipunto o borrada
+    if (data.magic != POINTS_MAGIC_NUMBER ||
+        data.ph.count > CAL_MAX_POINTS ||
+        data.dissolvedOxygen.count > CAL_MAX_POINTS ||
+        data.ec.count > CAL_MAX_POINTS) {
+        return false;
+    }
+
+    points = data;
+    LOG_INFO("EEPROM", "Puntos de calibración cargados correctamente");
+    return true;
+}
+
 bool EEPROMManager::hasValidData() {
     if (!initialized) {
         return false;
@@ -97,6 +147,15 @@ bool EEPROMManager::hasValidData() {
     return EEPROM.read(magicAddress) == MAGIC_NUMBER;
 }
 
+bool EEPROMManager::hasLegacyData() {
+    if (!initialized) {
+        return false;
+    }
+
+    size_t magicAddress = offsetof(CalibrationData, magic);
+    return EEPROM.read(magicAddress) == LEGACY_MAGIC_NUMBER;
+}
+
 void EEPROMManager::clearAll() {
     if (!initialized) {
         return;
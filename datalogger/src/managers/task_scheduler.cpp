@@ -0,0 +1,133 @@
+#include "managers/task_scheduler.h"
+#include "logger.h"
+
+TaskScheduler::TaskScheduler() {
+    taskCount = 0;
+}
+
+int TaskScheduler::addTask(const char* name, TaskCallback callback,
+                           unsigned long periodMs, unsigned long deadlineMs) {
+    if (taskCount >= MAX_TASKS || callback == nullptr || periodMs == 0) {
+        LOG_ERROR("SCHED", "No se pudo registrar la tarea " + String(name));
+        return -1;
+    }
+
+    Task& task = tasks[taskCount];
+    task.name = name;
+    task.callback = callback;
+    task.periodUs = periodMs * 1000UL;
+    task.deadlineUs = deadlineMs * 1000UL;
+    task.nextRelease = micros();    // Primera ejecución inmediata
+
+    LOG_INFO("SCHED", "Tarea " + String(name) + ": periodo " + String(periodMs) +
+             "ms, deadline " + String(deadlineMs) + "ms");
+
+    taskCount++;
+    resetStats();
+    return taskCount - 1;
+}
+
+unsigned long TaskScheduler::run() {
+    for (int i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        unsigned long startTime = micros();
+
+        // Comparación con signo para tolerar el desborde de micros()
+        if ((long)(startTime - task.nextRelease) < 0) {
+            continue;
+        }
+
+        unsigned long release = task.nextRelease;
+        unsigned long jitter = startTime - release;
+
+        task.callback();
+
+        unsigned long endTime = micros();
+        unsigned long execTime = endTime - startTime;
+
+        task.runs++;
+        task.totalJitterUs += jitter;
+        if (jitter > task.maxJitterUs) {
+            task.maxJitterUs = jitter;
+        }
+        if (execTime > task.maxExecUs) {
+            task.maxExecUs = execTime;
+        }
+        if (endTime - release > task.deadlineUs) {
+            task.deadlineMisses++;
+            LOG_DEBUG("SCHED", "Deadline perdido: " + String(task.name) +
+                      " (" + String((endTime - release) / 1000) + "ms)");
+        }
+
+        // Avanzar a la siguiente liberación manteniendo la fase. Si la tarea
+        // quedó más de un periodo atrasada se descartan las liberaciones perdidas
+        // en lugar de ejecutarla varias veces seguidas.
+        task.nextRelease = release + task.periodUs;
+        if ((long)(endTime - task.nextRelease) >= (long)task.periodUs) {
+            unsigned long behind = endTime - task.nextRelease;
+            unsigned long skipped = behind / task.periodUs;
+            task.skippedReleases += skipped;
+            task.nextRelease += skipped * task.periodUs;
+        }
+    }
+
+    // Calcular tiempo hasta la próxima liberación
+    unsigned long now = micros();
+    unsigned long minWait = ULONG_MAX;
+    for (int i = 0; i < taskCount; i++) {
+        long wait = (long)(tasks[i].nextRelease - now);
+        if (wait <= 0) {
+            return 0;
+        }
+        if ((unsigned long)wait < minWait) {
+            minWait = wait;
+        }
+    }
+
+    return minWait;
+}
+
+void TaskScheduler::runAndSleep() {
+    unsigned long waitUs = run();
+
+    // delay() cede la CPU a FreeRTOS; la resolución es de 1 tick (1ms)
+    if (waitUs >= 1000) {
+        delay(waitUs / 1000);
+    } else if (waitUs > 0) {
+        delayMicroseconds(waitUs);
+    }
+}
+
+void TaskScheduler::resetStats() {
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].runs = 0;
+        tasks[i].deadlineMisses = 0;
+        tasks[i].skippedReleases = 0;
+        tasks[i].maxJitterUs = 0;
+        tasks[i].totalJitterUs = 0;
+        tasks[i].maxExecUs = 0;
+    }
+}
+
+unsigned long TaskScheduler::getDeadlineMisses() const {
+    unsigned long total = 0;
+    for (int i = 0; i < taskCount; i++) {
+        total += tasks[i].deadlineMisses;
+    }
+    return total;
+}
+
+void TaskScheduler::showStats() const {
+    LOG_INFO("SCHED", "  PLANIFICADOR (jitter medio/máx, ejecución máx, deadlines perdidos):");
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        unsigned long avgJitter = task.runs > 0 ? (unsigned long)(task.totalJitterUs / task.runs) : 0;
+
+        LOG_INFO("SCHED", "  " + String(task.name) +
+                 ": ejecuciones=" + String(task.runs) +
+                 " jitter=" + String(avgJitter) + "/" + String(task.maxJitterUs) + "us" +
+                 " exec=" + String(task.maxExecUs) + "us" +
+                 " perdidos=" + String(task.deadlineMisses) +
+                 " saltados=" + String(task.skippedReleases));
+    }
+}
@@ -0,0 +1,219 @@
+#include "modules/adc_sampler.h"
+#include "logger.h"
+#include <driver/adc.h>
+
+AdcSampler::AdcSampler() {
+    for (int ch = 0; ch < ADC_CH_COUNT; ch++) {
+        writeCount[ch] = 0;
+        for (int i = 0; i < ADC_RING_SIZE; i++) {
+            ring[ch][i] = 0;
+        }
+    }
+    for (int i = 0; i < MAX_HW_CHANNELS; i++) {
+        hwToChannel[i] = -1;
+    }
+
+    overruns = 0;
+    taskHandle = nullptr;
+    running = false;
+    portMUX_INITIALIZE(&lock);
+}
+
+bool AdcSampler::begin() {
+    if (running) {
+        return true;
+    }
+
+    // Orden = AdcChannelId
+    const int pins[ADC_CH_COUNT] = {
+        ANALOG_SENSOR_PH, ANALOG_SENSOR_DO, ANALOG_SENSOR_EC, EMERGENCY_VOLTAGE_PIN
+    };
+
+    adc_digi_pattern_config_t pattern[ADC_CH_COUNT];
+    uint32_t channelMask = 0;
+
+    for (int i = 0; i < ADC_CH_COUNT; i++) {
+        int hwChannel = digitalPinToAnalogChannel(pins[i]);
+
+        // En el ESP32-S3 los canales 0-9 son ADC1; el modo continuo usa solo ADC1
+        if (hwChannel < 0 || hwChannel >= MAX_HW_CHANNELS) {
+            LOG_ERROR("ADC_DMA", "GPIO" + String(pins[i]) + " no pertenece a ADC1");
+            return false;
+        }
+
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = hwChannel;
+        pattern[i].unit = 0;                        // ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+        channelMask |= (1 << hwChannel);
+        hwToChannel[hwChannel] = i;
+    }
+
+    adc_digi_init_config_t initConfig = {};
+    initConfig.max_store_buf_size = ADC_DMA_FRAME_SIZE * 4;
+    initConfig.conv_num_each_intr = ADC_DMA_FRAME_SIZE;
+    initConfig.adc1_chan_mask = channelMask;
+    initConfig.adc2_chan_mask = 0;
+
+    if (adc_digi_initialize(&initConfig) != ESP_OK) {
+        LOG_ERROR("ADC_DMA", "Error al inicializar el driver ADC continuo");
+        return false;
+    }
+
+    adc_digi_configuration_t digiConfig = {};
+    digiConfig.conv_limit_en = false;
+    digiConfig.conv_limit_num = 250;
+    digiConfig.pattern_num = ADC_CH_COUNT;
+    digiConfig.adc_pattern = pattern;
+    digiConfig.sample_freq_hz = ADC_DMA_SAMPLE_RATE;
+    digiConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digiConfig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+
+    if (adc_digi_controller_configure(&digiConfig) != ESP_OK) {
+        LOG_ERROR("ADC_DMA", "Error al configurar el patrón de canales");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    running = true;
+    adc_digi_start();
+
+    xTaskCreatePinnedToCore(samplerTask, "adc_sampler", ADC_TASK_STACK, this,
+                            ADC_TASK_PRIORITY, &taskHandle, ADC_TASK_CORE);
+
+    LOG_INFO("ADC_DMA", "Muestreo continuo iniciado: " + String(ADC_CH_COUNT) + " canales a " +
+             String(getSampleRate()) + " Hz por canal");
+    return true;
+}
+
+void AdcSampler::end() {
+    if (!running) {
+        return;
+    }
+
+    running = false;
+    if (taskHandle != nullptr) {
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+    adc_digi_stop();
+    adc_digi_deinitialize();
+}
+
+void AdcSampler::samplerTask(void* parameter) {
+    AdcSampler* self = (AdcSampler*)parameter;
+    uint8_t frame[ADC_DMA_FRAME_SIZE];
+
+    for (;;) {
+        uint32_t length = 0;
+
+        // Bloquea hasta que el DMA completa un frame
+        esp_err_t result = adc_digi_read_bytes(frame, sizeof(frame), &length, ADC_MAX_DELAY);
+
+        // ESP_ERR_INVALID_STATE: el pool del driver se llenó y se perdieron
+        // frames, pero los datos devueltos siguen siendo válidos
+        if (result == ESP_ERR_INVALID_STATE) {
+            self->overruns++;
+        } else if (result != ESP_OK) {
+            continue;
+        }
+
+        self->processFrame(frame, length);
+    }
+}
+
+void AdcSampler::processFrame(const uint8_t* data, uint32_t length) {
+    portENTER_CRITICAL(&lock);
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t* result = (const adc_digi_output_data_t*)&data[i];
+        uint32_t hwChannel = result->type2.channel;
+
+        if (hwChannel >= MAX_HW_CHANNELS || hwToChannel[hwChannel] < 0) {
+            continue;
+        }
+
+        int channel = hwToChannel[hwChannel];
+        uint32_t count = writeCount[channel];
+        ring[channel][count % ADC_RING_SIZE] = result->type2.data;
+        writeCount[channel] = count + 1;
+    }
+
+    portEXIT_CRITICAL(&lock);
+}
+
+int AdcSampler::getLatest(AdcChannelId channel, int* out, int n) {
+    portENTER_CRITICAL(&lock);
+
+    uint32_t count = writeCount[channel];
+    int available = count < (uint32_t)n ? (int)count : n;
+    if (available > ADC_RING_SIZE) {
+        available = ADC_RING_SIZE;
+    }
+
+    // Índice de la primera muestra a copiar
+    uint32_t first = count - available;
+    for (int i = 0; i < n; i++) {
+        if (available == 0) {
+            out[i] = 0;
+        } else if (i < n - available) {
+            out[i] = ring[channel][first % ADC_RING_SIZE];
+        } else {
+            out[i] = ring[channel][(first + i - (n - available)) % ADC_RING_SIZE];
+        }
+    }
+
+    portEXIT_CRITICAL(&lock);
+    return available;
+}
+
+bool AdcSampler::getAverage(AdcChannelId channel, int n, int& average) {
+    if (n <= 0) {
+        return false;
+    }
+    if (n > ADC_RING_SIZE) {
+        n = ADC_RING_SIZE;
+    }
+
+    portENTER_CRITICAL(&lock);
+
+    uint32_t count = writeCount[channel];
+    if (count < (uint32_t)n) {
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+
+    long sum = 0;
+    for (int i = 1; i <= n; i++) {
+        sum += ring[channel][(count - i) % ADC_RING_SIZE];
+    }
+
+    portEXIT_CRITICAL(&lock);
+    average = sum / n;
+    return true;
+}
+
+int AdcSampler::readNew(AdcChannelId channel, uint32_t& cursor, uint16_t* out, int max,
+                        uint32_t* lost) {
+    portENTER_CRITICAL(&lock);
+
+    uint32_t count = writeCount[channel];
+    uint32_t pending = count - cursor;
+    if (pending > ADC_RING_SIZE) {
+        if (lost != nullptr) {
+            *lost += pending - ADC_RING_SIZE;
+        }
+        cursor = count - ADC_RING_SIZE;
+        pending = ADC_RING_SIZE;
+    }
+
+    int n = pending < (uint32_t)max ? (int)pending : max;
+    for (int i = 0; i < n; i++) {
+        out[i] = ring[channel][(cursor + i) % ADC_RING_SIZE];
+    }
+    cursor += n;
+
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
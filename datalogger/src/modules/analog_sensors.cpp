@@ -1,9 +1,12 @@
 #include "logger.h"
 #include "modules/analog_sensors.h"
 #include "managers/eeprom_manager.h"
+#include "utils/adc_calibration.h"
 
 
 AnalogSensors::AnalogSensors() {
+    // Antes que nada: initDefaultCalibration() ya lo usa
+    portMUX_INITIALIZE(&lock);
     
     // Inicializar con valores predeterminados
     initDefaultCalibration();
@@ -11,16 +14,25 @@ AnalogSensors::AnalogSensors() {
     // Inicializar últimos valores
     lastPH = 7.0;
     lastDO = 0.0;
+    lastFitResidual = 0.0f;
     lastEC = 0.0;
+    lastPHCompensated = NAN;
+    lastECCompensated = NAN;
     lastRawPH = 0;
     lastRawDO = 0;
     lastRawEC = 0;
-    
-    // Inicializar arrays de lecturas
-    for (int i = 0; i < NUM_READINGS; i++) {
-        phReadings[i] = 0;
-        doReadings[i] = 0;
-        ecReadings[i] = 0;
+
+    adcSampler = nullptr;
+    lostSamples = 0;
+
+    // Configurar filtros por canal
+    const int windows[NUM_CHANNELS] = {ANALOG_PH_WINDOW, ANALOG_DO_WINDOW, ANALOG_EC_WINDOW};
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        filters[i].configure(windows[i], (AnalogFilter::Mode)ANALOG_FILTER_MODE, ANALOG_FILTER_TRIM);
+        sampleCursor[i] = 0;
+        oversampleBits[i] = ANALOG_DEFAULT_OVERSAMPLE;
+        oversampleSum[i] = 0;
+        oversampleCount[i] = 0;
     }
 }
 
@@ -44,17 +56,43 @@ void AnalogSensors::begin() {
 
 // ====================== CALCULAR VALORES Y ACTUALIZAR ======================
 void AnalogSensors::performReadings() {
+    // Con muestreo continuo se pasan al filtro todas las muestras nuevas
+    // desde el último update (sin esperas, costo constante por muestra)
+    if (adcSampler != nullptr && adcSampler->isRunning()) {
+        uint16_t chunk[32];
+
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            int n;
+            do {
+                // Por bloques: la sección crítica queda corta
+                portENTER_CRITICAL(&lock);
+                n = adcSampler->readNew((AdcChannelId)ch, sampleCursor[ch], chunk, 32, &lostSamples);
+                for (int i = 0; i < n; i++) {
+                    addSample(ch, chunk[i]);
+                }
+                portEXIT_CRITICAL(&lock);
+            } while (n == 32);
+        }
+        return;
+    }
+
     // Realizar NUM_READINGS lecturas
     // Secuencia: pH -> DO -> EC -> pH -> DO -> EC ...
     for (int i = 0; i < NUM_READINGS; i++) {
-        phReadings[i] = analogRead(ANALOG_SENSOR_PH);
+        int rawPH = analogRead(ANALOG_SENSOR_PH);
         delayMicroseconds(100);  // Pequeña pausa entre lecturas
         
-        doReadings[i] = analogRead(ANALOG_SENSOR_DO);
+        int rawDO = analogRead(ANALOG_SENSOR_DO);
         delayMicroseconds(100);
         
-        ecReadings[i] = analogRead(ANALOG_SENSOR_EC);
+        int rawEC = analogRead(ANALOG_SENSOR_EC);
         delayMicroseconds(100);
+
+        portENTER_CRITICAL(&lock);
+        addSample(ADC_CH_PH, rawPH);
+        addSample(ADC_CH_DO, rawDO);
+        addSample(ADC_CH_EC, rawEC);
+        portEXIT_CRITICAL(&lock);
         
         // Pausa entre ciclos de lectura
         if (i < NUM_READINGS - 1) {
@@ -67,26 +105,142 @@ void AnalogSensors::update() {
     // Realizar lecturas de todos los sensores
     performReadings();
 
-    // Calcular promedios
-    lastRawPH = getAverageReading(phReadings);
-    lastRawDO = getAverageReading(doReadings);
-    lastRawEC = getAverageReading(ecReadings);
-    LOG_INFO("ANALOG", "Valores crudos promediados:");
+    // Valores filtrados
+    lastRawPH = filteredRaw(ADC_CH_PH);
+    lastRawDO = filteredRaw(ADC_CH_DO);
+    lastRawEC = filteredRaw(ADC_CH_EC);
+    LOG_INFO("ANALOG", "Valores crudos filtrados:");
     LOG_INFO("ANALOG", "  pH raw: " + String(lastRawPH));
     LOG_INFO("ANALOG", "  DO raw: " + String(lastRawDO)); 
     LOG_INFO("ANALOG", "  EC raw: " + String(lastRawEC));
-    // Convertir a voltaje
-    float phVoltage = (lastRawPH  * 3.3) / 4095.0;
-    float doVoltage = (lastRawDO * 3.3) / 4095.0;
-    float ecVoltage = (lastRawEC * 3.3) / 4095.0;
-    
-    // Aplicar calibraciones
-    lastPH = 7.0 + ((phVoltage - 2.5) / phSlope) + phOffset;
 
-    // pH = pH_neutro + (ΔVoltaje / Pendiente) + Offset
+    // Valor filtrado sin redondear → mV (tabla eFuse) → calibración
+    // (coeficientes precalculados en updateConversions)
+    float phMillivolts = channelMillivolts(ADC_CH_PH);
+    float doMillivolts = channelMillivolts(ADC_CH_DO);
+    float ecMillivolts = channelMillivolts(ADC_CH_EC);
+    portENTER_CRITICAL(&lock);
+    lastPH = phConversion.apply(phMillivolts);
+    lastDO = doConversion.apply(doMillivolts);
+    lastEC = ecCurve.isActive() ? ecCurve.apply(ecMillivolts) : ecConversion.apply(ecMillivolts);
+    portEXIT_CRITICAL(&lock);
+
+    // Compensación por temperatura (solo con una temperatura reciente)
+    if (tempCompensation.isValid(millis())) {
+        lastPHCompensated = tempCompensation.compensatePH(lastPH);
+        lastECCompensated = tempCompensation.compensateEC(lastEC);
+    } else {
+        lastPHCompensated = NAN;
+        lastECCompensated = NAN;
+    }
+}
+
+// Acumular 4^n muestras y pasar al filtro su suma diezmada (>> n), un
+// valor de 12+n bits. El ruido del ADC hace de dither entre muestras.
+// Se llama con el lock tomado
+void AnalogSensors::addSample(int channel, int raw) {
+    int bits = oversampleBits[channel];
+    if (bits == 0) {
+        filters[channel].add(raw);
+        return;
+    }
+
+    oversampleSum[channel] += raw;
+    oversampleCount[channel]++;
+
+    if (oversampleCount[channel] == (1u << (2 * bits))) {
+        filters[channel].add(oversampleSum[channel] >> bits);
+        oversampleSum[channel] = 0;
+        oversampleCount[channel] = 0;
+    }
+}
+
+// Salida del filtro expresada en cuentas de 12 bits (fraccionaria)
+float AnalogSensors::filteredCounts(AdcChannelId channel) const {
+    portENTER_CRITICAL(&lock);
+    float counts = filters[channel].value() / (float)(1 << oversampleBits[channel]);
+    portEXIT_CRITICAL(&lock);
+    return counts;
+}
+
+float AnalogSensors::channelMillivolts(AdcChannelId channel) const {
+    return AdcCalibration::toMillivolts(filteredCounts(channel));
+}
+
+bool AnalogSensors::setOversampling(AdcChannelId channel, int bits) {
+    if (channel < 0 || channel >= NUM_CHANNELS || bits < 0 || bits > ANALOG_MAX_OVERSAMPLE) {
+        return false;
+    }
+
+    // Cambia la escala de las salidas: descartar la ventana y lo acumulado
+    portENTER_CRITICAL(&lock);
+    oversampleBits[channel] = bits;
+    oversampleSum[channel] = 0;
+    oversampleCount[channel] = 0;
+    filters[channel].reset();
+    portEXIT_CRITICAL(&lock);
+
+    LOG_INFO("ANALOG", "Sobremuestreo canal " + String((int)channel) + ": " +
+             String(1 << (2 * bits)) + " muestras → " + String(12 + bits) + " bits");
+    return true;
+}
+
+float AnalogSensors::getRawStdDev(AdcChannelId channel) const {
+    portENTER_CRITICAL(&lock);
+    float sigma = filters[channel].stddev() / (float)(1 << oversampleBits[channel]);
+    portEXIT_CRITICAL(&lock);
+    return sigma;
+}
+
+float AnalogSensors::getEffectiveBits(AdcChannelId channel) const {
+    float nominal = 12 + oversampleBits[channel];
+    float sigma = getRawStdDev(channel);
+    portENTER_CRITICAL(&lock);
+    size_t windowSize = filters[channel].size();
+    portEXIT_CRITICAL(&lock);
+
+    // Resolución limitada por ruido: 12 - log2(σ·√12), con σ en cuentas de 12 bits
+    float rmsCodes = sigma * 3.4641f;
+    if (windowSize < 2 || rmsCodes <= 0.0f) {
+        return nominal;
+    }
+
+    float noiseBits = 12.0f - log2f(rmsCodes);
+    return noiseBits < nominal ? noiseBits : nominal;
+}
+
+float AnalogSensors::getNoiseMillivolts(AdcChannelId channel) const {
+    // Pendiente local de la tabla eFuse alrededor del valor actual
+    float counts = filteredCounts(channel);
+    float sigma = getRawStdDev(channel);
+    return AdcCalibration::toMillivolts(counts + sigma) - AdcCalibration::toMillivolts(counts);
+}
+
+// La curva se compila fuera del lock; aquí solo se copia (~120 bytes)
+void AnalogSensors::publishEcCurve(const PiecewiseLinearTable& curve) {
+    portENTER_CRITICAL(&lock);
+    ecCurve = curve;
+    portEXIT_CRITICAL(&lock);
+}
+
+void AnalogSensors::updateConversions() {
+    // Las conversiones parten de mV; las calibraciones siguen expresadas en V
+    const float voltsPerMv = 0.001f;
+
+    // pH = pH_neutro + ((V - 2.5) / Pendiente) + Offset
     // phSlope = (Voltaje_pH4 - Voltaje_pH7) / (4 - 7) = ΔV / ΔpH
-    lastDO = doVoltage * doSlope + doOffset;
-    lastEC = ecVoltage * ecK * ecSlope + ecOffset;
+    //   → gain = 0.001 / phSlope, offset = 7 - 2.5 / phSlope + phOffset
+    float phGain = voltsPerMv / phSlope;
+    float phIntercept = 7.0f - 2.5f / phSlope + phOffset;
+
+    // DO = V * doSlope + doOffset
+
+    // EC = V * K * ecSlope + ecOffset
+    portENTER_CRITICAL(&lock);
+    phConversion.set(phGain, phIntercept);
+    doConversion.set(voltsPerMv * doSlope, doOffset);
+    ecConversion.set(voltsPerMv * ecK * ecSlope, ecOffset);
+    portEXIT_CRITICAL(&lock);
 }
 
 // ====================== CALIBRACIÓN POR SENSOR  ======================
@@ -94,16 +248,25 @@ void AnalogSensors::update() {
 int AnalogSensors::calibrateCurrentPH(float shouldBePH) {
     // Tomar lectura actual
     performReadings();
-    int currentRaw = getAverageReading(phReadings);
-
-    // Convertir valor raw a voltaje
-    float voltage = (currentRaw * 3.3) / 4095.0;
-    
-    // Calcular qué valor daría con la calibración actual
-    float currentCalculated = 7.0 + ((voltage - 2.5) / phSlope);
-    
-    // Ajustar offset para que la lectura actual sea el valor conocido
-    phOffset = shouldBePH - currentCalculated;
+    int currentRaw = filteredRaw(ADC_CH_PH);
+    float millivolts = channelMillivolts(ADC_CH_PH);
+
+    calPoints.ph.add(millivolts, shouldBePH, CAL_PH_SAME_POINT);
+
+    // pH = mV * gain + offset  →  phSlope = 0.001 / gain,
+    //                             phOffset = offset - 7 + 2.5 / phSlope
+    float gain;
+    float offset;
+    if (fitLeastSquares(calPoints.ph, gain, offset, &lastFitResidual) && gain != 0.0f) {
+        phSlope = 0.001f / gain;
+        phOffset = offset - 7.0f + 2.5f / phSlope;
+    } else {
+        // Un solo punto: ajustar offset para que la lectura actual sea el valor conocido
+        float currentCalculated = phConversion.apply(millivolts) - phOffset;
+        phOffset = shouldBePH - currentCalculated;
+        lastFitResidual = 0.0f;
+    }
+    updateConversions();
 
     // Guardar en EEPROM
     saveCalibrationToEEPROM();
@@ -114,16 +277,23 @@ int AnalogSensors::calibrateCurrentPH(float shouldBePH) {
 int AnalogSensors::calibrateCurrentDO(float shouldBeDO) {
     // Tomar lectura actual
     performReadings();
-    int currentRaw = getAverageReading(doReadings);
-    
-    // Convertir valor raw a voltaje
-    float voltage = (currentRaw * 3.3) / 4095.0;
-    
-    // Calcular qué valor daría con la calibración actual
-    float currentCalculated = voltage * doSlope;
-    
-    // Ajustar offset para que la lectura actual sea el valor conocido
-    doOffset = shouldBeDO - currentCalculated;
+    int currentRaw = filteredRaw(ADC_CH_DO);
+    float millivolts = channelMillivolts(ADC_CH_DO);
+
+    calPoints.dissolvedOxygen.add(millivolts, shouldBeDO, CAL_DO_SAME_POINT);
+
+    // DO = mV * gain + offset  →  doSlope = 1000 * gain, doOffset = offset
+    float gain;
+    float offset;
+    if (fitLeastSquares(calPoints.dissolvedOxygen, gain, offset, &lastFitResidual)) {
+        doSlope = gain * 1000.0f;
+        doOffset = offset;
+    } else {
+        float currentCalculated = doConversion.apply(millivolts) - doOffset;
+        doOffset = shouldBeDO - currentCalculated;
+        lastFitResidual = 0.0f;
+    }
+    updateConversions();
 
     // Guardar en EEPROM
     saveCalibrationToEEPROM();
@@ -134,16 +304,27 @@ int AnalogSensors::calibrateCurrentDO(float shouldBeDO) {
 int AnalogSensors::calibrateCurrentEC(float shouldBeEC) {
     // Tomar lectura actual
     performReadings();
-    int currentRaw = getAverageReading(ecReadings);
-    
-    // Convertir valor raw a voltaje
-    float voltage = (currentRaw * 3.3) / 4095.0;
-    
-    // Calcular qué valor daría con la calibración actual
-    float currentCalculated = voltage * ecK * ecSlope;
-    
-    // Ajustar offset para que la lectura actual sea el valor conocido
-    ecOffset = shouldBeEC - currentCalculated;
+    int currentRaw = filteredRaw(ADC_CH_EC);
+    float millivolts = channelMillivolts(ADC_CH_EC);
+
+    calPoints.ec.add(millivolts, shouldBeEC, CAL_EC_SAME_POINT);
+
+    // Recta de mínimos cuadrados en slope/offset (referencia y respaldo) y
+    // curva por tramos a través de los puntos para la conversión
+    float gain;
+    float offset;
+    if (fitLeastSquares(calPoints.ec, gain, offset, &lastFitResidual) && ecK > 0.0f) {
+        ecSlope = gain * 1000.0f / ecK;
+        ecOffset = offset;
+    } else {
+        float currentCalculated = ecConversion.apply(millivolts) - ecOffset;
+        ecOffset = shouldBeEC - currentCalculated;
+        lastFitResidual = 0.0f;
+    }
+    PiecewiseLinearTable curve;
+    curve.build(calPoints.ec);
+    publishEcCurve(curve);
+    updateConversions();
 
     // Guardar en EEPROM
     saveCalibrationToEEPROM();
@@ -151,10 +332,38 @@ int AnalogSensors::calibrateCurrentEC(float shouldBeEC) {
     return currentRaw;
 }
 
+const CalPointSet& AnalogSensors::getCalibrationPoints(AdcChannelId channel) const {
+    switch (channel) {
+        case ADC_CH_DO: return calPoints.dissolvedOxygen;
+        case ADC_CH_EC: return calPoints.ec;
+        default:        return calPoints.ph;
+    }
+}
+
+void AnalogSensors::clearCalibrationPoints(AdcChannelId channel) {
+    switch (channel) {
+        case ADC_CH_PH:
+            calPoints.ph.clear();
+            break;
+        case ADC_CH_DO:
+            calPoints.dissolvedOxygen.clear();
+            break;
+        case ADC_CH_EC:
+            calPoints.ec.clear();
+            publishEcCurve(PiecewiseLinearTable());
+            break;
+        default:
+            return;
+    }
+    EEPROMManager::saveCalibrationPoints(calPoints);
+}
+
 // ====================== CALIBRACIONES POR COMMAND ======================
 void AnalogSensors::setPhCalibration(float offset, float slope) {
     phOffset = offset;
     phSlope = slope;
+    calPoints.ph.clear();
+    updateConversions();
 
     // Guardar en EEPROM
     saveCalibrationToEEPROM();
@@ -163,35 +372,77 @@ void AnalogSensors::setPhCalibration(float offset, float slope) {
 void AnalogSensors::setDoCalibration(float offset, float slope) {
     doOffset = offset;
     doSlope = slope;
+    calPoints.dissolvedOxygen.clear();
+    updateConversions();
 
     // Guardar automáticamente en EEPROM
     saveCalibrationToEEPROM();
 }
 
-void AnalogSensors::setEcCalibration(float offset, float slope, float k) {
+bool AnalogSensors::setEcCalibration(float offset, float slope, float k) {
+    // La constante de celda divide en calibrateCurrentEC (también descarta NaN)
+    if (!(k > 0.0f)) {
+        LOG_WARN("ANALOG", "Constante K de EC inválida: " + String(k, 4));
+        return false;
+    }
+
     ecOffset = offset;
     ecSlope = slope;
     ecK = k;
+    calPoints.ec.clear();
+    publishEcCurve(PiecewiseLinearTable());
+    updateConversions();
 
     // Guardar automáticamente en EEPROM
     saveCalibrationToEEPROM();
+    return true;
 }
 
 // ====================== GESTIÓN DE EEPROM ======================
 
 bool AnalogSensors::loadCalibrationFromEEPROM() {
     if (!EEPROMManager::hasValidData()) {
-        LOG_INFO("ANALOG", "No hay calibraciones válidas en EEPROM");
+        if (EEPROMManager::hasLegacyData()) {
+            LOG_WARN("ANALOG", "Calibración de EEPROM hecha con la escala ADC anterior: descartada, recalibrar los sensores");
+        } else {
+            LOG_INFO("ANALOG", "No hay calibraciones válidas en EEPROM");
+        }
         return false;
     }
     
+    // Todo se lee y se compila en copias locales: la EEPROM y la curva no
+    // se tocan con el lock tomado, solo se publica el resultado
+    float loadedPhOffset, loadedPhSlope, loadedDoOffset, loadedDoSlope;
+    float loadedEcOffset, loadedEcSlope, loadedEcK;
     bool success = EEPROMManager::loadCalibrations(
-        phOffset, phSlope,
-        doOffset, doSlope,
-        ecOffset, ecSlope, ecK
+        loadedPhOffset, loadedPhSlope,
+        loadedDoOffset, loadedDoSlope,
+        loadedEcOffset, loadedEcSlope, loadedEcK
     );
     
     if (success) {
+        // Puntos multipunto (no existen en memorias grabadas por versiones anteriores)
+        MultiPointCalibration loadedPoints;
+        PiecewiseLinearTable curve;
+        if (EEPROMManager::loadCalibrationPoints(loadedPoints)) {
+            curve.build(loadedPoints.ec);
+        } else {
+            loadedPoints.ph.clear();
+            loadedPoints.dissolvedOxygen.clear();
+            loadedPoints.ec.clear();
+        }
+
+        phOffset = loadedPhOffset;
+        phSlope = loadedPhSlope;
+        doOffset = loadedDoOffset;
+        doSlope = loadedDoSlope;
+        ecOffset = loadedEcOffset;
+        ecSlope = loadedEcSlope;
+        ecK = loadedEcK;
+        calPoints = loadedPoints;
+        publishEcCurve(curve);
+
+        updateConversions();
         LOG_INFO("ANALOG", "Calibraciones cargadas desde EEPROM");
     } else {
         LOG_ERROR("ANALOG", "Error al cargar calibraciones de EEPROM");
@@ -205,7 +456,7 @@ bool AnalogSensors::saveCalibrationToEEPROM() {
         phOffset, phSlope,
         doOffset, doSlope,
         ecOffset, ecSlope, ecK
-    );
+    ) && EEPROMManager::saveCalibrationPoints(calPoints);
     
     if (success) {
         LOG_INFO("ANALOG", "Calibraciones guardadas en EEPROM");
@@ -235,6 +486,14 @@ void AnalogSensors::initDefaultCalibration() {
     ecOffset = 0.0;
     ecSlope = 1.0;
     ecK = 10.0;                     // Constante de celda (se debe determinar experimentalmente)
+
+    // Sin puntos de referencia
+    calPoints.ph.clear();
+    calPoints.dissolvedOxygen.clear();
+    calPoints.ec.clear();
+    publishEcCurve(PiecewiseLinearTable());
+
+    updateConversions();
 }
 
 String AnalogSensors::getCSVData() const {
@@ -242,17 +501,21 @@ String AnalogSensors::getCSVData() const {
     data += String(lastPH, 2) + ",";
     data += String(lastDO, 2) + ",";
     data += String(lastEC, 0) + ",";
-    data += String(phReadings[readIndex]) + ",";
-    data += String(doReadings[readIndex]) + ",";
-    data += String(ecReadings[readIndex]);
+    data += String(filters[ADC_CH_PH].last()) + ",";
+    data += String(filters[ADC_CH_DO].last()) + ",";
+    data += String(filters[ADC_CH_EC].last());
     
     return data;
 }
 
-int AnalogSensors::getAverageReading(int readings[]) {
-    long sum = 0;
-    for (int i = 0; i < NUM_READINGS; i++) {
-        sum += readings[i];
-    }
-    return sum / NUM_READINGS;
+void AnalogSensors::fillRecord(SampleRecord& record) const {
+    record.ph = lastPH;
+    record.dissolvedOxygen = lastDO;
+    record.conductivity = lastEC;
+    record.phCompensated = lastPHCompensated;
+    record.conductivity25 = lastECCompensated;
+}
+
+int AnalogSensors::filteredRaw(AdcChannelId channel) const {
+    return (int)lroundf(filteredCounts(channel));
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "modules/delta_codec.h"
+#include "utils/crc.h"
+
+// Zig-zag: los deltas chicos, positivos o negativos, quedan en pocos bits
+static inline uint64_t zigzagEncode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t zigzagDecode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+size_t encodeDeltaRecord(const int64_t* values, const int64_t* previous, uint8_t count,
+                         uint8_t* buffer, size_t size) {
+    if (size < DELTA_RECORD_MAX_SIZE(count)) {
+        return 0;
+    }
+
+    size_t pos = 1;
+    buffer[pos++] = previous == nullptr ? DELTA_KEY_FRAME : 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        // Resta en uint64: un salto a QUANTIZED_NAN no desborda, solo da la vuelta
+        uint64_t delta = (uint64_t)values[i] - (previous == nullptr ? 0 : (uint64_t)previous[i]);
+        uint64_t raw = zigzagEncode((int64_t)delta);
+        while (raw >= 0x80) {
+            buffer[pos++] = (uint8_t)(raw | 0x80);
+            raw >>= 7;
+        }
+        buffer[pos++] = (uint8_t)raw;
+    }
+
+    uint16_t crc = crc16Ccitt(buffer + 1, pos - 1);
+    buffer[pos++] = (uint8_t)crc;
+    buffer[pos++] = (uint8_t)(crc >> 8);
+
+    if (pos - 1 > 0xFF) {
+        return 0;
+    }
+    buffer[0] = (uint8_t)(pos - 1);
+    return pos;
+}
+
+size_t decodeDeltaRecord(const uint8_t* buffer, size_t available, uint8_t count,
+                         const int64_t* previous, int64_t* values, bool& keyFrame) {
+    if (available < 1) {
+        return 0;
+    }
+    size_t total = 1 + buffer[0];
+    if (total < 2 + count + sizeof(uint16_t) || total > available) {
+        return 0;
+    }
+
+    size_t end = total - sizeof(uint16_t);
+    uint16_t stored = (uint16_t)(buffer[end] | (buffer[end + 1] << 8));
+    if (crc16Ccitt(buffer + 1, end - 1) != stored) {
+        return 0;
+    }
+
+    keyFrame = (buffer[1] & DELTA_KEY_FRAME) != 0;
+    size_t pos = 2;
+    for (uint8_t i = 0; i < count; i++) {
+        uint64_t raw = 0;
+        int shift = 0;
+        do {
+            if (pos >= end || shift >= 64) {
+                return 0;
+            }
+            raw |= (uint64_t)(buffer[pos] & 0x7F) << shift;
+            shift += 7;
+        } while (buffer[pos++] & 0x80);
+
+        uint64_t base = (keyFrame || previous == nullptr) ? 0 : (uint64_t)previous[i];
+        values[i] = (int64_t)(base + (uint64_t)zigzagDecode(raw));
+    }
+
+    // Todos los bytes hasta el CRC deben ser varints
+    return pos == end ? total : 0;
+}
@@ -1,5 +1,8 @@
 #include "modules/emergency_system.h"
 #include "modules/pixhawk_interface.h" 
+#include "modules/adc_sampler.h"
+#include "modules/sd_logger.h"
+#include "utils/adc_calibration.h"
 #include "logger.h"
 #include <SPI.h>
 #include <nRF24L01.h>
@@ -26,6 +29,7 @@ EmergencySystem::EmergencySystem() {
     // Inicializar variables de voltaje
     currentVoltage = 0.0;
     powerControlActive = true;  // Por defecto, alimentación activa
+    powerWarning = false;
     voltageReadingIndex = 0;
     voltageBufferFull = false;
 
@@ -50,6 +54,8 @@ EmergencySystem::EmergencySystem() {
     radio = nullptr;
     hspi = nullptr;
     pixhawkInterface = nullptr;
+    adcSampler = nullptr;
+    dataLogger = nullptr;
 }
 
 // Destructor
@@ -91,12 +97,10 @@ void EmergencySystem::begin() {
 void EmergencySystem::update() {
     unsigned long currentTime = millis();
     
-    // Verificar estado
-    if (currentTime - lastCheckTime >= EMERGENCY_CHECK_RATE) {
-        LOG_INFO("EMERGENCY", "Verificando estado del pin");
-        checkVoltageLevel();
-        lastCheckTime = currentTime;
-    }
+    // Verificar estado (el planificador llama a update() cada EMERGENCY_CHECK_RATE)
+    LOG_VERBOSE("EMERGENCY", "Verificando estado del pin");
+    checkVoltageLevel();
+    lastCheckTime = currentTime;
 
 
     // Si está en emergencia, leer GPS y enviar datos
@@ -117,14 +121,34 @@ void EmergencySystem::update() {
 }
 
 void EmergencySystem::checkVoltageLevel() {
-    // Leer voltaje actual
-    currentVoltage = readAverageVoltage();
+    // Leer voltaje actual. Sin muestras suficientes del ADC (recién
+    // arrancado) no hay lectura: un 0 V activaría la emergencia al arrancar
+    float voltage;
+    if (!readAverageVoltage(voltage)) {
+        LOG_VERBOSE("EMERGENCY", "Sin muestras de VBAT todavía");
+        return;
+    }
+    currentVoltage = voltage;
 
     // Actualizar buffer de voltaje
     updateVoltageBuffer(currentVoltage);
 
     LOG_VERBOSE("EMERGENCY", "Voltaje actual: " + String(currentVoltage, 3) + "V");
 
+    // Aviso de energía: por encima del umbral de emergencia, para que la SD
+    // confirme los datos antes de un posible corte
+    bool warning = currentVoltage < EMERGENCY_VOLTAGE_WARNING_REAL;
+    if (warning != powerWarning) {
+        powerWarning = warning;
+        if (warning) {
+            LOG_WARN("EMERGENCY", "Aviso de energía: " + String(currentVoltage, 3) + "V < " +
+                     String(EMERGENCY_VOLTAGE_WARNING_REAL, 2) + "V");
+        }
+        if (dataLogger != nullptr) {
+            dataLogger->setPowerWarning(warning);
+        }
+    }
+
      // Lógica de activación/desactivación con histéresis
     if (!emergencyActive) {
         // No estamos en emergencia - verificar si voltaje baja del umbral
@@ -144,25 +168,33 @@ void EmergencySystem::checkVoltageLevel() {
     }
 }
 
-float EmergencySystem::readAverageVoltage() {
+bool EmergencySystem::readAverageVoltage(float& voltage) {
     // Realizar múltiples lecturas para mayor estabilidad
     int totalReading = 0;
     const int numSamples = 10;
-    
-    for (int i = 0; i < numSamples; i++) {
-        totalReading += analogRead(EMERGENCY_VOLTAGE_PIN);
-        delayMicroseconds(100);  // Pequeña pausa entre lecturas
+    float averageReading;
+
+    if (adcSampler != nullptr && adcSampler->isRunning()) {
+        // Con el ADC1 en modo continuo analogRead() no está disponible
+        int average;
+        if (!adcSampler->getAverage(ADC_CH_VBAT, numSamples, average)) {
+            return false;
+        }
+        averageReading = average;
+    } else {
+        for (int i = 0; i < numSamples; i++) {
+            totalReading += analogRead(EMERGENCY_VOLTAGE_PIN);
+            delayMicroseconds(100);  // Pequeña pausa entre lecturas
+        }
+        averageReading = totalReading / (float)numSamples;
     }
     
-    float averageReading = totalReading / (float)numSamples;
-    
-    // Convertir a voltaje (ESP32: 12 bits, 3.3V referencia)
-    float adcVoltage = (averageReading * 3.3) / 4095.0;
+    // Cuentas → mV con la tabla caracterizada, luego voltaje real del
+    // sistema aplicando el factor de escala del divisor
+    const float voltsPerMv = 0.001f * (float)VOLTAGE_SCALE_FACTOR;
 
-    // Convertir a voltaje real del sistema aplicando factor de escala
-    float realVoltage = adcVoltage * VOLTAGE_SCALE_FACTOR;
-
-    return realVoltage;
+    voltage = AdcCalibration::toMillivolts(averageReading) * voltsPerMv;
+    return true;
 }
 
 void EmergencySystem::updateVoltageBuffer(float newReading) {
@@ -179,6 +211,11 @@ void EmergencySystem::activateEmergency() {
 
     emergencyActive = true;
 
+    // Confirmar en la SD todo lo pendiente
+    if (dataLogger != nullptr) {
+        dataLogger->requestFlush();
+    }
+
     // Conmutar control de alimentación
     setPowerControl(false);  // Cambiar a modo emergencia (LOW)
 
@@ -0,0 +1,40 @@
+#include <string.h>
+#include "modules/log_journal.h"
+#include "utils/crc.h"
+
+// El CRC empieza después de magic y crc no se incluye a sí mismo
+static uint32_t frameCrc(const uint8_t* frame, size_t payloadLength) {
+    const size_t covered = offsetof(JournalFrameHeader, crc) - offsetof(JournalFrameHeader, length);
+    uint32_t crc = crc32(frame + offsetof(JournalFrameHeader, length), covered);
+    return crc32Update(crc, frame + sizeof(JournalFrameHeader), payloadLength);
+}
+
+void sealJournalFrame(uint8_t* frame, uint16_t length, uint32_t fileNumber, uint32_t sequence) {
+    JournalFrameHeader header;
+    header.magic[0] = JOURNAL_MAGIC_0;
+    header.magic[1] = JOURNAL_MAGIC_1;
+    header.length = length;
+    header.fileNumber = fileNumber;
+    header.sequence = sequence;
+    header.crc = 0;
+    memcpy(frame, &header, sizeof(header));
+
+    header.crc = frameCrc(frame, length);
+    memcpy(frame + offsetof(JournalFrameHeader, crc), &header.crc, sizeof(header.crc));
+}
+
+size_t checkJournalFrame(const uint8_t* buffer, size_t available, JournalFrameHeader& header) {
+    if (available < sizeof(JournalFrameHeader) ||
+        buffer[0] != JOURNAL_MAGIC_0 || buffer[1] != JOURNAL_MAGIC_1) {
+        return 0;
+    }
+
+    memcpy(&header, buffer, sizeof(header));
+    if (header.length > JOURNAL_MAX_PAYLOAD || journalFrameSize(header.length) > available) {
+        return 0;
+    }
+    if (frameCrc(buffer, header.length) != header.crc) {
+        return 0;
+    }
+    return journalFrameSize(header.length);
+}
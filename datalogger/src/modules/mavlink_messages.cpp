@@ -0,0 +1,442 @@
+#include <string.h>
+#include "modules/mavlink_messages.h"
+
+// Campos en el orden del enlace. Los arreglos llevan el tamaño del enum: un
+// campo de menos queda en cero y no pasa la verificación de offsets
+
+static constexpr MavlinkFieldDescriptor HEARTBEAT_FIELDS[HEARTBEAT_FIELD_COUNT] = {
+    {0, MAV_FIELD_U32, 1},          // custom_mode
+    {4, MAV_FIELD_U8, 1},           // type
+    {5, MAV_FIELD_U8, 1},           // autopilot
+    {6, MAV_FIELD_U8, 1},           // base_mode
+    {7, MAV_FIELD_U8, 1},           // system_status
+    {8, MAV_FIELD_U8, 1},           // mavlink_version
+};
+
+static constexpr MavlinkFieldDescriptor SYS_STATUS_FIELDS[SYS_STATUS_FIELD_COUNT] = {
+    {0, MAV_FIELD_U32, 1},          // onboard_control_sensors_present
+    {4, MAV_FIELD_U32, 1},          // onboard_control_sensors_enabled
+    {8, MAV_FIELD_U32, 1},          // onboard_control_sensors_health
+    {12, MAV_FIELD_U16, 1},         // load
+    {14, MAV_FIELD_U16, 1},         // voltage_battery
+    {16, MAV_FIELD_I16, 1},         // current_battery
+    {18, MAV_FIELD_U16, 1},         // drop_rate_comm
+    {20, MAV_FIELD_U16, 1},         // errors_comm
+    {22, MAV_FIELD_U16, 1},         // errors_count1
+    {24, MAV_FIELD_U16, 1},         // errors_count2
+    {26, MAV_FIELD_U16, 1},         // errors_count3
+    {28, MAV_FIELD_U16, 1},         // errors_count4
+    {30, MAV_FIELD_I8, 1},          // battery_remaining
+};
+
+static constexpr MavlinkFieldDescriptor SYSTEM_TIME_FIELDS[SYSTEM_TIME_FIELD_COUNT] = {
+    {0, MAV_FIELD_U64, 1},          // time_unix_usec
+    {8, MAV_FIELD_U32, 1},          // time_boot_ms
+};
+
+static constexpr MavlinkFieldDescriptor GPS_RAW_INT_FIELDS[GPS_RAW_INT_FIELD_COUNT] = {
+    {0, MAV_FIELD_U64, 1},          // time_usec
+    {8, MAV_FIELD_I32, 1},          // lat
+    {12, MAV_FIELD_I32, 1},         // lon
+    {16, MAV_FIELD_I32, 1},         // alt
+    {20, MAV_FIELD_U16, 1},         // eph
+    {22, MAV_FIELD_U16, 1},         // epv
+    {24, MAV_FIELD_U16, 1},         // vel
+    {26, MAV_FIELD_U16, 1},         // cog
+    {28, MAV_FIELD_U8, 1},          // fix_type
+    {29, MAV_FIELD_U8, 1},          // satellites_visible
+};
+
+static constexpr MavlinkFieldDescriptor GPS_STATUS_FIELDS[GPS_STATUS_FIELD_COUNT] = {
+    {0, MAV_FIELD_U8, 1},           // satellites_visible
+    {1, MAV_FIELD_U8, 20},          // satellite_prn
+    {21, MAV_FIELD_U8, 20},         // satellite_used
+    {41, MAV_FIELD_U8, 20},         // satellite_elevation
+    {61, MAV_FIELD_U8, 20},         // satellite_azimuth
+    {81, MAV_FIELD_U8, 20},         // satellite_snr
+};
+
+static constexpr MavlinkFieldDescriptor ATTITUDE_FIELDS[ATTITUDE_FIELD_COUNT] = {
+    {0, MAV_FIELD_U32, 1},          // time_boot_ms
+    {4, MAV_FIELD_F32, 1},          // roll
+    {8, MAV_FIELD_F32, 1},          // pitch
+    {12, MAV_FIELD_F32, 1},         // yaw
+    {16, MAV_FIELD_F32, 1},         // rollspeed
+    {20, MAV_FIELD_F32, 1},         // pitchspeed
+    {24, MAV_FIELD_F32, 1},         // yawspeed
+};
+
+static constexpr MavlinkFieldDescriptor GLOBAL_POSITION_INT_FIELDS[GLOBAL_POSITION_INT_FIELD_COUNT] = {
+    {0, MAV_FIELD_U32, 1},          // time_boot_ms
+    {4, MAV_FIELD_I32, 1},          // lat
+    {8, MAV_FIELD_I32, 1},          // lon
+    {12, MAV_FIELD_I32, 1},         // alt
+    {16, MAV_FIELD_I32, 1},         // relative_alt
+    {20, MAV_FIELD_I16, 1},         // vx
+    {22, MAV_FIELD_I16, 1},         // vy
+    {24, MAV_FIELD_I16, 1},         // vz
+    {26, MAV_FIELD_U16, 1},         // hdg
+};
+
+static constexpr MavlinkFieldDescriptor VFR_HUD_FIELDS[VFR_HUD_FIELD_COUNT] = {
+    {0, MAV_FIELD_F32, 1},          // airspeed
+    {4, MAV_FIELD_F32, 1},          // groundspeed
+    {8, MAV_FIELD_F32, 1},          // alt
+    {12, MAV_FIELD_F32, 1},         // climb
+    {16, MAV_FIELD_I16, 1},         // heading
+    {18, MAV_FIELD_U16, 1},         // throttle
+};
+
+static constexpr MavlinkFieldDescriptor BATTERY_STATUS_FIELDS[BATTERY_STATUS_FIELD_COUNT] = {
+    {0, MAV_FIELD_I32, 1},          // current_consumed
+    {4, MAV_FIELD_I32, 1},          // energy_consumed
+    {8, MAV_FIELD_I16, 1},          // temperature
+    {10, MAV_FIELD_U16, 10},        // voltages
+    {30, MAV_FIELD_I16, 1},         // current_battery
+    {32, MAV_FIELD_U8, 1},          // id
+    {33, MAV_FIELD_U8, 1},          // battery_function
+    {34, MAV_FIELD_U8, 1},          // type
+    {35, MAV_FIELD_I8, 1},          // battery_remaining
+};
+
+#define MAVLINK_FIELDS(fields) sizeof(fields) / sizeof(fields[0]), fields
+
+// Mensajes de common.xml y ardupilotmega.xml, ordenados por id: los de los
+// streams de ArduPilot/PX4 y los de misión, parámetros, logs y periféricos
+// que pueden compartir el enlace. Los que no se usan solo aportan su
+// CRC_EXTRA para validar el frame (y así su secuencia cuenta)
+static constexpr MavlinkMessageDescriptor MAVLINK_MESSAGES[] = {
+    {0, "HEARTBEAT", 50, 9, MAVLINK_FIELDS(HEARTBEAT_FIELDS)},
+    {1, "SYS_STATUS", 124, 31, MAVLINK_FIELDS(SYS_STATUS_FIELDS)},
+    {2, "SYSTEM_TIME", 137, 12, MAVLINK_FIELDS(SYSTEM_TIME_FIELDS)},
+    {4, "PING", 237, 0, 0, nullptr},
+    {5, "CHANGE_OPERATOR_CONTROL", 217, 0, 0, nullptr},
+    {6, "CHANGE_OPERATOR_CONTROL_ACK", 104, 0, 0, nullptr},
+    {7, "AUTH_KEY", 119, 0, 0, nullptr},
+    {11, "SET_MODE", 89, 0, 0, nullptr},
+    {20, "PARAM_REQUEST_READ", 214, 0, 0, nullptr},
+    {21, "PARAM_REQUEST_LIST", 159, 0, 0, nullptr},
+    {22, "PARAM_VALUE", 220, 0, 0, nullptr},
+    {23, "PARAM_SET", 168, 0, 0, nullptr},
+    {24, "GPS_RAW_INT", 24, 30, MAVLINK_FIELDS(GPS_RAW_INT_FIELDS)},
+    {25, "GPS_STATUS", 23, 101, MAVLINK_FIELDS(GPS_STATUS_FIELDS)},
+    {26, "SCALED_IMU", 170, 0, 0, nullptr},
+    {27, "RAW_IMU", 144, 0, 0, nullptr},
+    {28, "RAW_PRESSURE", 67, 0, 0, nullptr},
+    {29, "SCALED_PRESSURE", 115, 0, 0, nullptr},
+    {30, "ATTITUDE", 39, 28, MAVLINK_FIELDS(ATTITUDE_FIELDS)},
+    {31, "ATTITUDE_QUATERNION", 246, 0, 0, nullptr},
+    {32, "LOCAL_POSITION_NED", 185, 0, 0, nullptr},
+    {33, "GLOBAL_POSITION_INT", 104, 28, MAVLINK_FIELDS(GLOBAL_POSITION_INT_FIELDS)},
+    {34, "RC_CHANNELS_SCALED", 237, 0, 0, nullptr},
+    {35, "RC_CHANNELS_RAW", 244, 0, 0, nullptr},
+    {36, "SERVO_OUTPUT_RAW", 222, 0, 0, nullptr},
+    {37, "MISSION_REQUEST_PARTIAL_LIST", 212, 0, 0, nullptr},
+    {38, "MISSION_WRITE_PARTIAL_LIST", 9, 0, 0, nullptr},
+    {39, "MISSION_ITEM", 254, 0, 0, nullptr},
+    {40, "MISSION_REQUEST", 230, 0, 0, nullptr},
+    {41, "MISSION_SET_CURRENT", 28, 0, 0, nullptr},
+    {42, "MISSION_CURRENT", 28, 0, 0, nullptr},
+    {43, "MISSION_REQUEST_LIST", 132, 0, 0, nullptr},
+    {44, "MISSION_COUNT", 221, 0, 0, nullptr},
+    {45, "MISSION_CLEAR_ALL", 232, 0, 0, nullptr},
+    {46, "MISSION_ITEM_REACHED", 11, 0, 0, nullptr},
+    {47, "MISSION_ACK", 153, 0, 0, nullptr},
+    {48, "SET_GPS_GLOBAL_ORIGIN", 41, 0, 0, nullptr},
+    {49, "GPS_GLOBAL_ORIGIN", 39, 0, 0, nullptr},
+    {50, "PARAM_MAP_RC", 78, 0, 0, nullptr},
+    {51, "MISSION_REQUEST_INT", 196, 0, 0, nullptr},
+    {54, "SAFETY_SET_ALLOWED_AREA", 15, 0, 0, nullptr},
+    {55, "SAFETY_ALLOWED_AREA", 3, 0, 0, nullptr},
+    {61, "ATTITUDE_QUATERNION_COV", 167, 0, 0, nullptr},
+    {62, "NAV_CONTROLLER_OUTPUT", 183, 0, 0, nullptr},
+    {63, "GLOBAL_POSITION_INT_COV", 119, 0, 0, nullptr},
+    {64, "LOCAL_POSITION_NED_COV", 191, 0, 0, nullptr},
+    {65, "RC_CHANNELS", 118, 0, 0, nullptr},
+    {66, "REQUEST_DATA_STREAM", 148, 0, 0, nullptr},
+    {67, "DATA_STREAM", 21, 0, 0, nullptr},
+    {69, "MANUAL_CONTROL", 243, 0, 0, nullptr},
+    {70, "RC_CHANNELS_OVERRIDE", 124, 0, 0, nullptr},
+    {73, "MISSION_ITEM_INT", 38, 0, 0, nullptr},
+    {74, "VFR_HUD", 20, 20, MAVLINK_FIELDS(VFR_HUD_FIELDS)},
+    {75, "COMMAND_INT", 158, 0, 0, nullptr},
+    {76, "COMMAND_LONG", 152, 0, 0, nullptr},
+    {77, "COMMAND_ACK", 143, 0, 0, nullptr},
+    {81, "MANUAL_SETPOINT", 106, 0, 0, nullptr},
+    {82, "SET_ATTITUDE_TARGET", 49, 0, 0, nullptr},
+    {83, "ATTITUDE_TARGET", 22, 0, 0, nullptr},
+    {84, "SET_POSITION_TARGET_LOCAL_NED", 143, 0, 0, nullptr},
+    {85, "POSITION_TARGET_LOCAL_NED", 140, 0, 0, nullptr},
+    {86, "SET_POSITION_TARGET_GLOBAL_INT", 5, 0, 0, nullptr},
+    {87, "POSITION_TARGET_GLOBAL_INT", 150, 0, 0, nullptr},
+    {89, "LOCAL_POSITION_NED_SYSTEM_GLOBAL_OFFSET", 231, 0, 0, nullptr},
+    {90, "HIL_STATE", 183, 0, 0, nullptr},
+    {91, "HIL_CONTROLS", 63, 0, 0, nullptr},
+    {92, "HIL_RC_INPUTS_RAW", 54, 0, 0, nullptr},
+    {93, "HIL_ACTUATOR_CONTROLS", 47, 0, 0, nullptr},
+    {100, "OPTICAL_FLOW", 175, 0, 0, nullptr},
+    {101, "GLOBAL_VISION_POSITION_ESTIMATE", 102, 0, 0, nullptr},
+    {102, "VISION_POSITION_ESTIMATE", 158, 0, 0, nullptr},
+    {103, "VISION_SPEED_ESTIMATE", 208, 0, 0, nullptr},
+    {104, "VICON_POSITION_ESTIMATE", 56, 0, 0, nullptr},
+    {105, "HIGHRES_IMU", 93, 0, 0, nullptr},
+    {106, "OPTICAL_FLOW_RAD", 138, 0, 0, nullptr},
+    {107, "HIL_SENSOR", 108, 0, 0, nullptr},
+    {108, "SIM_STATE", 32, 0, 0, nullptr},
+    {109, "RADIO_STATUS", 185, 0, 0, nullptr},
+    {110, "FILE_TRANSFER_PROTOCOL", 84, 0, 0, nullptr},
+    {111, "TIMESYNC", 34, 0, 0, nullptr},
+    {112, "CAMERA_TRIGGER", 174, 0, 0, nullptr},
+    {113, "HIL_GPS", 124, 0, 0, nullptr},
+    {114, "HIL_OPTICAL_FLOW", 237, 0, 0, nullptr},
+    {115, "HIL_STATE_QUATERNION", 4, 0, 0, nullptr},
+    {116, "SCALED_IMU2", 76, 0, 0, nullptr},
+    {117, "LOG_REQUEST_LIST", 128, 0, 0, nullptr},
+    {118, "LOG_ENTRY", 56, 0, 0, nullptr},
+    {119, "LOG_REQUEST_DATA", 116, 0, 0, nullptr},
+    {120, "LOG_DATA", 134, 0, 0, nullptr},
+    {121, "LOG_ERASE", 237, 0, 0, nullptr},
+    {122, "LOG_REQUEST_END", 203, 0, 0, nullptr},
+    {123, "GPS_INJECT_DATA", 250, 0, 0, nullptr},
+    {124, "GPS2_RAW", 87, 0, 0, nullptr},
+    {125, "POWER_STATUS", 203, 0, 0, nullptr},
+    {126, "SERIAL_CONTROL", 220, 0, 0, nullptr},
+    {127, "GPS_RTK", 25, 0, 0, nullptr},
+    {128, "GPS2_RTK", 226, 0, 0, nullptr},
+    {129, "SCALED_IMU3", 46, 0, 0, nullptr},
+    {130, "DATA_TRANSMISSION_HANDSHAKE", 29, 0, 0, nullptr},
+    {131, "ENCAPSULATED_DATA", 223, 0, 0, nullptr},
+    {132, "DISTANCE_SENSOR", 85, 0, 0, nullptr},
+    {133, "TERRAIN_REQUEST", 6, 0, 0, nullptr},
+    {134, "TERRAIN_DATA", 229, 0, 0, nullptr},
+    {135, "TERRAIN_CHECK", 203, 0, 0, nullptr},
+    {136, "TERRAIN_REPORT", 1, 0, 0, nullptr},
+    {137, "SCALED_PRESSURE2", 195, 0, 0, nullptr},
+    {138, "ATT_POS_MOCAP", 109, 0, 0, nullptr},
+    {139, "SET_ACTUATOR_CONTROL_TARGET", 168, 0, 0, nullptr},
+    {140, "ACTUATOR_CONTROL_TARGET", 181, 0, 0, nullptr},
+    {141, "ALTITUDE", 47, 0, 0, nullptr},
+    {142, "RESOURCE_REQUEST", 72, 0, 0, nullptr},
+    {143, "SCALED_PRESSURE3", 131, 0, 0, nullptr},
+    {144, "FOLLOW_TARGET", 127, 0, 0, nullptr},
+    {146, "CONTROL_SYSTEM_STATE", 103, 0, 0, nullptr},
+    {147, "BATTERY_STATUS", 154, 36, MAVLINK_FIELDS(BATTERY_STATUS_FIELDS)},
+    {148, "AUTOPILOT_VERSION", 178, 0, 0, nullptr},
+    {149, "LANDING_TARGET", 200, 0, 0, nullptr},
+    {150, "SENSOR_OFFSETS", 134, 0, 0, nullptr},
+    {151, "SET_MAG_OFFSETS", 219, 0, 0, nullptr},
+    {152, "MEMINFO", 208, 0, 0, nullptr},
+    {153, "AP_ADC", 188, 0, 0, nullptr},
+    {154, "DIGICAM_CONFIGURE", 84, 0, 0, nullptr},
+    {155, "DIGICAM_CONTROL", 22, 0, 0, nullptr},
+    {156, "MOUNT_CONFIGURE", 19, 0, 0, nullptr},
+    {157, "MOUNT_CONTROL", 21, 0, 0, nullptr},
+    {158, "MOUNT_STATUS", 134, 0, 0, nullptr},
+    {160, "FENCE_POINT", 78, 0, 0, nullptr},
+    {161, "FENCE_FETCH_POINT", 68, 0, 0, nullptr},
+    {162, "FENCE_STATUS", 189, 0, 0, nullptr},
+    {163, "AHRS", 127, 0, 0, nullptr},
+    {164, "SIMSTATE", 154, 0, 0, nullptr},
+    {165, "HWSTATUS", 21, 0, 0, nullptr},
+    {166, "RADIO", 21, 0, 0, nullptr},
+    {167, "LIMITS_STATUS", 144, 0, 0, nullptr},
+    {168, "WIND", 1, 0, 0, nullptr},
+    {169, "DATA16", 234, 0, 0, nullptr},
+    {170, "DATA32", 73, 0, 0, nullptr},
+    {171, "DATA64", 181, 0, 0, nullptr},
+    {172, "DATA96", 22, 0, 0, nullptr},
+    {173, "RANGEFINDER", 83, 0, 0, nullptr},
+    {174, "AIRSPEED_AUTOCAL", 167, 0, 0, nullptr},
+    {175, "RALLY_POINT", 138, 0, 0, nullptr},
+    {176, "RALLY_FETCH_POINT", 234, 0, 0, nullptr},
+    {177, "COMPASSMOT_STATUS", 240, 0, 0, nullptr},
+    {178, "AHRS2", 47, 0, 0, nullptr},
+    {179, "CAMERA_STATUS", 189, 0, 0, nullptr},
+    {180, "CAMERA_FEEDBACK", 52, 0, 0, nullptr},
+    {181, "BATTERY2", 174, 0, 0, nullptr},
+    {182, "AHRS3", 229, 0, 0, nullptr},
+    {183, "AUTOPILOT_VERSION_REQUEST", 85, 0, 0, nullptr},
+    {184, "REMOTE_LOG_DATA_BLOCK", 159, 0, 0, nullptr},
+    {185, "REMOTE_LOG_BLOCK_STATUS", 186, 0, 0, nullptr},
+    {186, "LED_CONTROL", 72, 0, 0, nullptr},
+    {191, "MAG_CAL_PROGRESS", 92, 0, 0, nullptr},
+    {192, "MAG_CAL_REPORT", 36, 0, 0, nullptr},
+    {193, "EKF_STATUS_REPORT", 71, 0, 0, nullptr},
+    {194, "PID_TUNING", 98, 0, 0, nullptr},
+    {195, "DEEPSTALL", 120, 0, 0, nullptr},
+    {225, "EFI_STATUS", 208, 0, 0, nullptr},
+    {226, "RPM", 207, 0, 0, nullptr},
+    {230, "ESTIMATOR_STATUS", 163, 0, 0, nullptr},
+    {231, "WIND_COV", 105, 0, 0, nullptr},
+    {241, "VIBRATION", 90, 0, 0, nullptr},
+    {242, "HOME_POSITION", 104, 0, 0, nullptr},
+    {244, "MESSAGE_INTERVAL", 95, 0, 0, nullptr},
+    {245, "EXTENDED_SYS_STATE", 130, 0, 0, nullptr},
+    {246, "ADSB_VEHICLE", 184, 0, 0, nullptr},
+    {250, "DEBUG_VECT", 49, 0, 0, nullptr},
+    {251, "NAMED_VALUE_FLOAT", 170, 0, 0, nullptr},
+    {252, "NAMED_VALUE_INT", 44, 0, 0, nullptr},
+    {253, "STATUSTEXT", 83, 0, 0, nullptr},
+    {254, "DEBUG", 46, 0, 0, nullptr},
+    {256, "SETUP_SIGNING", 71, 0, 0, nullptr},
+    {257, "BUTTON_CHANGE", 131, 0, 0, nullptr},
+    {258, "PLAY_TUNE", 187, 0, 0, nullptr},
+    {264, "FLIGHT_INFORMATION", 49, 0, 0, nullptr},
+    {265, "MOUNT_ORIENTATION", 26, 0, 0, nullptr},
+    {266, "LOGGING_DATA", 193, 0, 0, nullptr},
+    {267, "LOGGING_DATA_ACKED", 35, 0, 0, nullptr},
+    {268, "LOGGING_ACK", 14, 0, 0, nullptr},
+    {290, "ESC_INFO", 251, 0, 0, nullptr},
+    {291, "ESC_STATUS", 10, 0, 0, nullptr},
+    {300, "PROTOCOL_VERSION", 217, 0, 0, nullptr},
+    {310, "UAVCAN_NODE_STATUS", 28, 0, 0, nullptr},
+    {311, "UAVCAN_NODE_INFO", 95, 0, 0, nullptr},
+    {330, "OBSTACLE_DISTANCE", 23, 0, 0, nullptr},
+    {331, "ODOMETRY", 91, 0, 0, nullptr},
+    {340, "UTM_GLOBAL_POSITION", 99, 0, 0, nullptr},
+    {350, "DEBUG_FLOAT_ARRAY", 232, 0, 0, nullptr},
+    {360, "ORBIT_EXECUTION_STATUS", 11, 0, 0, nullptr},
+    {380, "TIME_ESTIMATE_TO_TARGET", 232, 0, 0, nullptr},
+    {385, "TUNNEL", 147, 0, 0, nullptr},
+    {410, "EVENT", 160, 0, 0, nullptr},
+    {411, "CURRENT_EVENT_SEQUENCE", 106, 0, 0, nullptr},
+    {9000, "WHEEL_DISTANCE", 113, 0, 0, nullptr},
+    {11010, "ADAP_TUNING", 46, 0, 0, nullptr},
+    {11011, "VISION_POSITION_DELTA", 106, 0, 0, nullptr},
+    {11020, "AOA_SSA", 205, 0, 0, nullptr},
+    {11030, "ESC_TELEMETRY_1_TO_4", 144, 0, 0, nullptr},
+    {11031, "ESC_TELEMETRY_5_TO_8", 133, 0, 0, nullptr},
+    {11032, "ESC_TELEMETRY_9_TO_12", 85, 0, 0, nullptr},
+    {11039, "WATER_DEPTH", 47, 0, 0, nullptr},
+    {11040, "MCU_STATUS", 142, 0, 0, nullptr},
+};
+
+static const size_t MAVLINK_MESSAGE_COUNT = sizeof(MAVLINK_MESSAGES) / sizeof(MAVLINK_MESSAGES[0]);
+
+// Verificación al compilar (recursiva para C++11)
+
+// Cada campo empieza donde termina el anterior, no es más grande que él y
+// el último cierra en el largo del payload
+static constexpr bool fieldsMatchLayout(const MavlinkFieldDescriptor* fields, size_t count,
+                                        size_t length, size_t offset, size_t previousSize) {
+    return count == 0
+        ? offset == length
+        : fields[0].offset == offset && fields[0].count > 0 &&
+          mavlinkFieldSize(fields[0].type) <= previousSize &&
+          fieldsMatchLayout(fields + 1, count - 1, length,
+                            offset + mavlinkFieldSize(fields[0].type) * fields[0].count,
+                            mavlinkFieldSize(fields[0].type));
+}
+
+static constexpr bool messagesMatchLayout(const MavlinkMessageDescriptor* messages, size_t count,
+                                          int64_t previousId) {
+    return count == 0 ||
+           ((int64_t)messages[0].msgId > previousId &&
+            messages[0].length <= MAVLINK_MAX_DECODED_PAYLOAD &&
+            fieldsMatchLayout(messages[0].fields, messages[0].fieldCount, messages[0].length, 0, 8) &&
+            messagesMatchLayout(messages + 1, count - 1, messages[0].msgId));
+}
+
+static_assert(messagesMatchLayout(MAVLINK_MESSAGES, sizeof(MAVLINK_MESSAGES) / sizeof(MAVLINK_MESSAGES[0]), -1),
+              "Descriptores MAVLink inconsistentes (offsets, largo u orden de ids)");
+
+const MavlinkMessageDescriptor* findMavlinkMessage(uint32_t msgId) {
+    size_t low = 0;
+    size_t high = MAVLINK_MESSAGE_COUNT;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (MAVLINK_MESSAGES[middle].msgId < msgId) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    bool found = low < MAVLINK_MESSAGE_COUNT && MAVLINK_MESSAGES[low].msgId == msgId;
+    return found ? &MAVLINK_MESSAGES[low] : nullptr;
+}
+
+const MavlinkMessageDescriptor* getMavlinkMessages(size_t& count) {
+    count = MAVLINK_MESSAGE_COUNT;
+    return MAVLINK_MESSAGES;
+}
+
+int mavlinkCrcExtra(uint32_t msgId) {
+    const MavlinkMessageDescriptor* descriptor = findMavlinkMessage(msgId);
+    return descriptor != nullptr ? descriptor->crcExtra : -1;
+}
+
+bool mavlinkDecode(const MavlinkFrame& frame, MavlinkMessage& message) {
+    const MavlinkMessageDescriptor* descriptor = findMavlinkMessage(frame.msgId);
+    if (descriptor == nullptr || descriptor->fieldCount == 0) {
+        return false;
+    }
+
+    // v2 recorta los ceros finales; lo que sigue al largo base son extensiones
+    size_t length = frame.payloadLength < descriptor->length ? frame.payloadLength : descriptor->length;
+    memcpy(message.payload, frame.payload, length);
+    memset(message.payload + length, 0, descriptor->length - length);
+    message.descriptor = descriptor;
+    return true;
+}
+
+// Bytes crudos del elemento (little-endian), o false si no existe
+static bool readElement(const MavlinkMessage& message, uint8_t field, uint8_t index,
+                        MavlinkFieldType& type, uint64_t& raw) {
+    if (field >= message.descriptor->fieldCount) {
+        return false;
+    }
+    const MavlinkFieldDescriptor& descriptor = message.descriptor->fields[field];
+    if (index >= descriptor.count) {
+        return false;
+    }
+    size_t size = mavlinkFieldSize(descriptor.type);
+    raw = 0;
+    memcpy(&raw, message.payload + descriptor.offset + index * size, size);
+    type = descriptor.type;
+    return true;
+}
+
+int64_t MavlinkMessage::getInt(uint8_t field, uint8_t index) const {
+    MavlinkFieldType type;
+    uint64_t raw;
+    if (!readElement(*this, field, index, type, raw)) {
+        return 0;
+    }
+    switch (type) {
+        case MAV_FIELD_I8:
+            return (int8_t)raw;
+        case MAV_FIELD_I16:
+            return (int16_t)raw;
+        case MAV_FIELD_I32:
+            return (int32_t)raw;
+        case MAV_FIELD_F32:
+        case MAV_FIELD_F64:
+            return (int64_t)getFloat(field, index);
+        default:
+            return (int64_t)raw;
+    }
+}
+
+uint64_t MavlinkMessage::getUInt(uint8_t field, uint8_t index) const {
+    return (uint64_t)getInt(field, index);
+}
+
+float MavlinkMessage::getFloat(uint8_t field, uint8_t index) const {
+    MavlinkFieldType type;
+    uint64_t raw;
+    if (!readElement(*this, field, index, type, raw)) {
+        return 0.0f;
+    }
+    if (type == MAV_FIELD_F32) {
+        float value;
+        uint32_t bits = (uint32_t)raw;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    if (type == MAV_FIELD_F64) {
+        double value;
+        memcpy(&value, &raw, sizeof(value));
+        return (float)value;
+    }
+    return (float)getInt(field, index);
+}
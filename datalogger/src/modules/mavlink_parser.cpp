@@ -0,0 +1,165 @@
+#include <string.h>
+#include "modules/mavlink_parser.h"
+#include "utils/crc.h"
+
+MavlinkParser::MavlinkParser() {
+    reset();
+    resetStats();
+}
+
+void MavlinkParser::reset() {
+    count = 0;
+    headerSize = 0;
+    checksumEnd = 0;
+    frameEnd = 0;
+    crcExtra = -1;
+    crc = 0xFFFF;
+    replayHead = 0;
+    replayLength = 0;
+}
+
+void MavlinkParser::resetStats() {
+    stats.reset();
+    linkCount = 0;
+}
+
+bool MavlinkParser::step(uint8_t byte) {
+    if (count == 0) {
+        if (byte != MAVLINK_STX_V1 && byte != MAVLINK_STX_V2) {
+            stats.skippedBytes++;
+            return false;
+        }
+        headerSize = byte == MAVLINK_STX_V2 ? MAVLINK_V2_HEADER_SIZE : MAVLINK_V1_HEADER_SIZE;
+        crc = 0xFFFF;
+        buffer[count++] = byte;
+        return false;
+    }
+
+    buffer[count++] = byte;
+    bool v2 = headerSize == MAVLINK_V2_HEADER_SIZE;
+
+    if (count <= headerSize) {
+        crc = crc16X25Update(crc, byte);
+        // Un incompat flag desconocido cambia el formato: no se puede seguir
+        if (v2 && count == 3 && (byte & ~MAVLINK_IFLAG_SIGNED) != 0) {
+            stats.badHeaders++;
+            resync();
+            return false;
+        }
+        if (count == headerSize) {
+            uint32_t msgId = v2 ? buffer[7] | ((uint32_t)buffer[8] << 8) | ((uint32_t)buffer[9] << 16)
+                                : buffer[5];
+            crcExtra = mavlinkCrcExtra(msgId);
+            if (crcExtra < 0) {
+                // Sin CRC_EXTRA no se puede confiar en el largo: saltear el
+                // frame supuesto podría llevarse los reales que siguen
+                stats.unknownFrames++;
+                noteUnknownFrame();
+                resync();
+                return false;
+            }
+            checksumEnd = headerSize + buffer[1] + MAVLINK_CHECKSUM_SIZE;
+            frameEnd = checksumEnd + (v2 && (buffer[2] & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_SIZE : 0);
+        }
+        return false;
+    }
+
+    if (count <= checksumEnd - MAVLINK_CHECKSUM_SIZE) {
+        crc = crc16X25Update(crc, byte);
+    } else if (count == checksumEnd) {
+        // Se valida antes de la firma: un frame malo se descarta cuanto antes
+        uint16_t expected = crc16X25Update(crc, (uint8_t)crcExtra);
+        uint16_t received = buffer[count - 2] | ((uint16_t)buffer[count - 1] << 8);
+        if (expected != received) {
+            stats.crcErrors++;
+            resync();
+            return false;
+        }
+    }
+
+    return count == frameEnd ? finishFrame() : false;
+}
+
+bool MavlinkParser::finishFrame() {
+    count = 0;
+    bool v2 = headerSize == MAVLINK_V2_HEADER_SIZE;
+    current.version = v2 ? 2 : 1;
+    current.payloadLength = buffer[1];
+    current.sequence = buffer[v2 ? 4 : 2];
+    current.systemId = buffer[v2 ? 5 : 3];
+    current.componentId = buffer[v2 ? 6 : 4];
+    current.msgId = v2 ? buffer[7] | ((uint32_t)buffer[8] << 8) | ((uint32_t)buffer[9] << 16) : buffer[5];
+    current.payload = buffer + headerSize;
+    current.frameSize = frameEnd;
+    current.isSigned = frameEnd > checksumEnd;
+
+    stats.frames++;
+    if (current.isSigned) {
+        stats.signedFrames++;
+    }
+    trackSequence();
+    return true;
+}
+
+// El STX no abría un frame: lo que vino detrás se vuelve a analizar antes
+// que los bytes nuevos. Cabe en replay: el frame descartado salió entero de
+// bytes nuevos (replay vacío) o de lo que ya estaba en replay
+void MavlinkParser::resync() {
+    stats.skippedBytes++;
+    size_t moved = count - 1;
+    size_t rest = replayLength - replayHead;
+    memmove(replay + moved, replay + replayHead, rest);
+    memcpy(replay, buffer + 1, moved);
+    replayHead = 0;
+    replayLength = moved + rest;
+    count = 0;
+}
+
+// Header completo con un id sin CRC_EXTRA: si continúa la secuencia de un
+// emisor conocido se toma como mensaje no soportado y no como pérdida
+void MavlinkParser::noteUnknownFrame() {
+    bool v2 = headerSize == MAVLINK_V2_HEADER_SIZE;
+    uint8_t sequence = buffer[v2 ? 4 : 2];
+    uint8_t systemId = buffer[v2 ? 5 : 3];
+    uint8_t componentId = buffer[v2 ? 6 : 4];
+
+    for (int i = 0; i < linkCount; i++) {
+        MavlinkLinkSequence& link = links[i];
+        if (link.systemId == systemId && link.componentId == componentId) {
+            if (sequence == (uint8_t)(link.lastSequence + 1 + link.pendingUnknown) && link.pendingUnknown < 255) {
+                link.pendingUnknown++;
+            }
+            return;
+        }
+    }
+}
+
+// Huecos en la secuencia de cada emisor: frames que no llegaron o no pasaron
+// el CRC. Los ids no soportados que ocuparon el hueco no cuentan
+void MavlinkParser::trackSequence() {
+    for (int i = 0; i < linkCount; i++) {
+        MavlinkLinkSequence& link = links[i];
+        if (link.systemId == current.systemId && link.componentId == current.componentId) {
+            uint8_t gap = (uint8_t)(current.sequence - link.lastSequence - 1);
+            gap = gap >= link.pendingUnknown ? gap - link.pendingUnknown : 0;
+            link.pendingUnknown = 0;
+            link.lostFrames += gap;
+            stats.lostFrames += gap;
+            link.lastSequence = current.sequence;
+            link.frames++;
+            return;
+        }
+    }
+
+    if (linkCount >= MAVLINK_MAX_LINKS) {
+        stats.untrackedFrames++;
+        return;
+    }
+    MavlinkLinkSequence& link = links[linkCount++];
+    link.systemId = current.systemId;
+    link.componentId = current.componentId;
+    link.lastSequence = current.sequence;
+    link.frames = 1;
+    link.lostFrames = 0;
+    link.pendingUnknown = 0;
+}
@@ -3,6 +3,8 @@
 
 // Constructor
 PixhawkInterface::PixhawkInterface()  {
+    portMUX_INITIALIZE(&stateLock);
+
     // Posición y navegación básicas (mantener nombres originales)
     latitude = 0.0;
     longitude = 0.0;
@@ -46,6 +48,8 @@ PixhawkInterface::PixhawkInterface()  {
     gpsMinute = 0;
     gpsSecond = 0;
     gpsTimeValid = false;
+    timeSync = nullptr;
+    frameStartUsec = 0;
     
     // Estado de conexión
     connected = false;
@@ -55,17 +59,44 @@ PixhawkInterface::PixhawkInterface()  {
 
     paused = false;         
     wasInitialized = false;  
+
+    rxStats.reset();
+    linkStatsStart = 0;
+    publishState();
 }
 
 void PixhawkInterface::begin() {
     // Configurar UART para comunicación con Pixhawk
-    Serial1.begin(PIXHAWK_BAUD_RATE, SERIAL_8N1, PIXHAWK_RX_PIN, PIXHAWK_TX_PIN);
-    Serial1.setTimeout(100);
+    configureUART();
     
     LOG_INFO("PIXHAWK", "Interfaz Pixhawk inicializada");
     LOG_INFO("PIXHAWK", "Puerto: UART1, Baudios: " + String(PIXHAWK_BAUD_RATE));
     LOG_INFO("PIXHAWK", "Pin RX: " + String(PIXHAWK_RX_PIN));
+    LOG_INFO("PIXHAWK", "Buffer RX: " + String(PIXHAWK_RX_BUFFER_SIZE) + " bytes" +
+             (UART_EVENT_DRAIN ? " (vaciado por eventos)" : ""));
     LOG_INFO("PIXHAWK", "Esperando datos MAVLink...");
+    linkStatsStart = millis();
+}
+
+void PixhawkInterface::configureUART() {
+    // El tamaño del buffer RX solo se aplica si se fija antes de begin()
+    Serial1.setRxBufferSize(PIXHAWK_RX_BUFFER_SIZE);
+    Serial1.begin(PIXHAWK_BAUD_RATE, SERIAL_8N1, PIXHAWK_RX_PIN, PIXHAWK_TX_PIN);
+    Serial1.setTimeout(100);
+
+    // Errores de la cola de eventos UART (overflow, framing, paridad)
+    Serial1.onReceiveError([this](hardwareSerial_error_t error) {
+        rxStats.recordError(error);
+    });
+
+#if UART_EVENT_DRAIN
+    // La tarea de eventos UART entrega los bytes al parser en cuanto llegan
+    Serial1.onReceive([this]() {
+        if (!paused) {
+            parseMAVLink();
+        }
+    });
+#endif
 }
 
 void PixhawkInterface::update() {
@@ -74,214 +105,234 @@ void PixhawkInterface::update() {
         return;
     }
 
-    unsigned long currentTime = millis();
-
+#if !UART_EVENT_DRAIN
     // Procesar mensajes MAVLink disponibles
     parseMAVLink();
-
+#endif
 }
 
 void PixhawkInterface::pauseForEmergency() {
     if (!paused && wasInitialized) {
         LOG_INFO("PIXHAWK", "Pausando comunicación - liberando UART1");
-        Serial1.end();
+        // Marcar antes de cerrar para que el callback de recepción no lea el UART
         paused = true;
+        Serial1.end();
     }
 }
 
 void PixhawkInterface::resumeAfterEmergency() {
     if (paused && wasInitialized) {
         LOG_INFO("PIXHAWK", "Reanudando comunicación - reactivando UART1");
-        Serial1.begin(PIXHAWK_BAUD_RATE, SERIAL_8N1, PIXHAWK_RX_PIN, PIXHAWK_TX_PIN);
-        Serial1.setTimeout(100);
+        // Lo que quedó a medias antes de la pausa no continúa en el UART nuevo
+        mavlink.reset();
+        configureUART();
         paused = false;
     }
 }
 
 void PixhawkInterface::parseMAVLink() {
-    static uint8_t buffer[300];
-    static int bufferIndex = 0;
-    static bool inMessage = false;
-    static bool isMAVLink2 = false;
-    static uint8_t expectedLength = 0;
+    rxStats.recordPending(Serial1.available());
     
     while (Serial1.available()) {
         uint8_t receivedByte = Serial1.read();
-        
-        // Detectar inicio de mensaje MAVLink
-        if (!inMessage && (receivedByte == 0xFD || receivedByte == 0xFE)) {
-            inMessage = true;
-            isMAVLink2 = (receivedByte == 0xFD);
-            bufferIndex = 0;
-            buffer[bufferIndex++] = receivedByte;
-            continue;
-        }
-        
-        if (inMessage) {
-            buffer[bufferIndex++] = receivedByte;
-            
-            // Obtener longitud del payload después del segundo byte
-            if (bufferIndex == 2) {
-                uint8_t payloadLength = receivedByte;
-                expectedLength = (isMAVLink2 ? 12 : 6) + payloadLength + 2;
-            }
-            
-            // Procesar mensaje completo
-            if (bufferIndex >= expectedLength && expectedLength > 0) {
-                processMAVLinkMessage(buffer, bufferIndex, isMAVLink2);
-                inMessage = false;
-                bufferIndex = 0;
-                expectedLength = 0;
-            }
-            
-            // Prevenir buffer overflow
-            if (bufferIndex >= 300) {
-                LOG_WARN("PIXHAWK", "Buffer overflow - reiniciando parser");
-                inMessage = false;
-                bufferIndex = 0;
-            }
-        }
+        rxStats.bytesReceived++;
+        mavlink.parse(receivedByte, [this](const MavlinkFrame& frame) {
+            processMAVLinkMessage(frame);
+        });
     }
 }
 
-void PixhawkInterface::processMAVLinkMessage(uint8_t* buffer, uint8_t length, bool isMAVLink2) {
-    uint8_t payloadOffset = isMAVLink2 ? 10 : 6;
-    uint32_t msgId;
-    
-    // Extraer message ID según la versión
-    if (isMAVLink2) {
-        if (length < 12) return;
-        msgId = buffer[7] | (buffer[8] << 8) | (buffer[9] << 16);
-    } else {
-        if (length < 8) return;
-        msgId = buffer[5];
-    }
-    
-    uint8_t* payload = &buffer[payloadOffset];
+void PixhawkInterface::processMAVLinkMessage(const MavlinkFrame& frame) {
     lastUpdateTime = millis();
-    connected = true;
+
+    // El mensaje terminó de llegar recién: restar su tiempo de transmisión
+    // (10 bits por byte) acerca el instante local al de su envío
+    frameStartUsec = esp_timer_get_time() - (int64_t)frame.frameSize * 10 * 1000000 / PIXHAWK_BAUD_RATE;
+    if (!connected) {
+        connected = true;
+        publishState();
+    }
+
+    // Solo se decodifican los mensajes con campos en mavlink_messages.cpp
+    MavlinkMessage message;
+    if (!mavlinkDecode(frame, message)) {
+        LOG_VERBOSE("PIXHAWK", "📦 Mensaje ID " + String(frame.msgId) + " recibido");
+        return;
+    }
     
     // LOG solo para mensajes importantes
-    switch (msgId) {
-        case 0:  // HEARTBEAT
+    switch (frame.msgId) {
+        case MAVLINK_MSG_HEARTBEAT:
             LOG_VERBOSE("PIXHAWK", " Heartbeat recibido");
-            parseHeartbeat(payload);
+            parseHeartbeat(message);
             break;
             
-        case 1:  // SYS_STATUS  
+        case MAVLINK_MSG_SYS_STATUS:
             LOG_VERBOSE("PIXHAWK", "⚙️ SYS_STATUS recibido");
-            parseSysStatus(payload);
+            parseSysStatus(message);
             break;
 
-        case 2:  // SYSTEM_TIME - DATOS DE TIEMPO
+        case MAVLINK_MSG_SYSTEM_TIME:
             LOG_DEBUG("PIXHAWK", "🕐 SYSTEM_TIME recibido");
-            parseSystemTime(payload);
+            parseSystemTime(message);
             break;
             
-        case 24: // GPS_RAW_INT
+        case MAVLINK_MSG_GPS_RAW_INT:
             LOG_DEBUG("PIXHAWK", "🛰️ GPS_RAW_INT recibido");
-            parseGPSRawInt(payload);
+            parseGPSRawInt(message);
             break;
             
-        case 30: // ATTITUDE
+        case MAVLINK_MSG_ATTITUDE:
             LOG_DEBUG("PIXHAWK", "🧭 ATTITUDE recibido");
-            parseAttitude(payload);
+            parseAttitude(message);
             break;
             
-        case 33: // GLOBAL_POSITION_INT
+        case MAVLINK_MSG_GLOBAL_POSITION_INT:
             LOG_DEBUG("PIXHAWK", "🌍 GLOBAL_POSITION_INT recibido");
-            parseGlobalPosition(payload);
+            parseGlobalPosition(message);
             break;
             
-        case 74: // VFR_HUD
+        case MAVLINK_MSG_VFR_HUD:
             LOG_VERBOSE("PIXHAWK", "📊 VFR_HUD recibido");
-            parseVFRHUD(payload);
+            parseVFRHUD(message);
             break;
             
-        case 147: // BATTERY_STATUS
+        case MAVLINK_MSG_BATTERY_STATUS:
             LOG_DEBUG("PIXHAWK", "🔋 BATTERY_STATUS recibido");
-            parseBatteryStatus(payload);
+            parseBatteryStatus(message);
             break;
             
-        case 163: // GPS_STATUS
+        case MAVLINK_MSG_GPS_STATUS:
             LOG_VERBOSE("PIXHAWK", "🛰️ GPS_STATUS recibido");
-            parseGPSStatus(payload);
+            parseGPSStatus(message);
             break;
             
         default:
-            LOG_VERBOSE("PIXHAWK", "📦 Mensaje ID " + String(msgId) + " recibido");
-            break;
+            return;
+    }
+    publishState();
+}
+
+void PixhawkInterface::publishState() {
+    PixhawkState state;
+    state.latitude = latitude;
+    state.longitude = longitude;
+    state.altitude = altitude;
+    state.heading = heading;
+    state.batteryVoltage = batteryVoltage;
+    state.batteryCurrent = batteryCurrent;
+    state.batteryRemaining = batteryRemaining;
+    state.batteryTemperature = batteryTemperature;
+    state.groundSpeed = groundSpeed;
+    state.airSpeed = airSpeed;
+    state.numSatellites = numSatellites;
+    state.gpsTimeUsec = gpsTimeUsec;
+    state.gpsYear = gpsYear;
+    state.gpsMonth = gpsMonth;
+    state.gpsDay = gpsDay;
+    state.gpsHour = gpsHour;
+    state.gpsMinute = gpsMinute;
+    state.gpsSecond = gpsSecond;
+    state.gpsTimeValid = gpsTimeValid;
+    state.connected = connected;
+    state.armed = armed;
+
+    portENTER_CRITICAL(&stateLock);
+    published = state;
+    portEXIT_CRITICAL(&stateLock);
+}
+
+PixhawkState PixhawkInterface::getState() const {
+    portENTER_CRITICAL(&stateLock);
+    PixhawkState state = published;
+    portEXIT_CRITICAL(&stateLock);
+    return state;
+}
+
+void PixhawkInterface::parseHeartbeat(const MavlinkMessage& message) {
+    // Los heartbeats de una estación de tierra o una computadora de a bordo
+    // (MAV_AUTOPILOT_INVALID) no describen el estado del vehículo
+    if (message.getInt(HEARTBEAT_AUTOPILOT) == 8) {
+        return;
     }
-}
 
-void PixhawkInterface::parseHeartbeat(uint8_t* payload) {
-    flightMode = payload[4];
-    systemStatus = payload[5];
-    armed = (payload[6] & 0x80) != 0;
+    flightMode = message.getUInt(HEARTBEAT_CUSTOM_MODE);
+    systemStatus = message.getInt(HEARTBEAT_SYSTEM_STATUS);
+    armed = (message.getInt(HEARTBEAT_BASE_MODE) & 0x80) != 0;  // MAV_MODE_FLAG_SAFETY_ARMED
     
     LOG_VERBOSE("PIXHAWK", "Heartbeat - Modo: " + String(flightMode) + 
                 ", Armado: " + String(armed ? "Sí" : "No"));
 }
 
-void PixhawkInterface::parseSysStatus(uint8_t* payload) {
-    // Extraer voltaje de batería (posición 12-13, en mV)
-    uint16_t voltage = (payload[13] << 8) | payload[12];
+void PixhawkInterface::parseSysStatus(const MavlinkMessage& message) {
+    // Voltaje de batería (mV)
+    uint16_t voltage = message.getInt(SYS_STATUS_VOLTAGE_BATTERY);
     if (voltage != UINT16_MAX) {
         batteryVoltage = voltage / 1000.0;
     }
     
-    // Extraer corriente (posición 14-15, en cA)
-    int16_t current = (payload[15] << 8) | payload[14];
+    // Corriente (cA)
+    int16_t current = message.getInt(SYS_STATUS_CURRENT_BATTERY);
     if (current != -1) {
         batteryCurrent = current / 100.0;
     }
     
-    // Porcentaje de batería (posición 16)
-    batteryRemaining = payload[16];
+    // Porcentaje de batería
+    int8_t remaining = message.getInt(SYS_STATUS_BATTERY_REMAINING);
+    if (remaining != -1) {
+        batteryRemaining = remaining;
+    }
     
     LOG_DEBUG("PIXHAWK", "SysStatus - Bat: " + String(batteryVoltage, 2) + "V, " + 
               String(batteryCurrent, 2) + "A, " + String(batteryRemaining) + "%");
 }
 
 // 🕐 NUEVO: Parsear mensaje SYSTEM_TIME
-void PixhawkInterface::parseSystemTime(uint8_t* payload) {
+void PixhawkInterface::parseSystemTime(const MavlinkMessage& message) {
     // SYSTEM_TIME contiene:
     // time_unix_usec (uint64_t): tiempo UTC en microsegundos
     // time_boot_ms (uint32_t): tiempo desde boot en ms
     
-    uint64_t timeUnixUsec = *((uint64_t*)&payload[0]);
+    uint64_t timeUnixUsec = message.getUInt(SYSTEM_TIME_TIME_UNIX_USEC);
     
     if (timeUnixUsec > 0) {
         gpsTimeUsec = timeUnixUsec;
         convertUnixTimeToDateTime(timeUnixUsec);
         gpsTimeValid = true;
+        publishState();     // getGPSTimeString() lee la copia publicada
+
+        if (timeSync != nullptr) {
+            timeSync->addReference(timeUnixUsec, frameStartUsec);
+        }
         
         LOG_INFO("PIXHAWK", "🕐 Tiempo del sistema actualizado: " + getGPSTimeString());
     }
 }
 
-void PixhawkInterface::parseGPSRawInt(uint8_t* payload) {
-    //   EXTRAER TIEMPO GPS (primeros 8 bytes del mensaje)
-    uint64_t timeUsec = *((uint64_t*)&payload[0]);
+void PixhawkInterface::parseGPSRawInt(const MavlinkMessage& message) {
+    // time_usec es UNIX o tiempo desde el arranque según el autopiloto: solo
+    // se toma como fecha si es posterior a 2020
+    uint64_t timeUsec = message.getUInt(GPS_RAW_INT_TIME_USEC);
     
-    if (timeUsec > 0) {
+    if (timeUsec > 1577836800ULL * 1000000ULL) {
         gpsTimeUsec = timeUsec;
         convertUnixTimeToDateTime(timeUsec);
         gpsTimeValid = true;
+        publishState();     // getGPSTimeString() lee la copia publicada
         
         LOG_DEBUG("PIXHAWK", "🕐 Tiempo GPS actualizado: " + getGPSTimeString());
     }
 
-    // Tipo de fix GPS y satélites (posiciones 36, 37)
-    gpsFixType = payload[36];
+    // Tipo de fix GPS y satélites
+    gpsFixType = message.getInt(GPS_RAW_INT_FIX_TYPE);
     tipoFixGPS = gpsFixType;  // Compatibilidad
-    satelites = payload[37];
+    satelites = message.getInt(GPS_RAW_INT_SATELLITES_VISIBLE);
     numSatellites = satelites;  // Compatibilidad
     
     // Coordenadas (int32 en grados * 1E7)
-    int32_t lat = *((int32_t*)&payload[8]);
-    int32_t lon = *((int32_t*)&payload[12]);
-    int32_t alt = *((int32_t*)&payload[16]);
+    int32_t lat = message.getInt(GPS_RAW_INT_LAT);
+    int32_t lon = message.getInt(GPS_RAW_INT_LON);
+    int32_t alt = message.getInt(GPS_RAW_INT_ALT);
     
     if (lat != 0 && lon != 0) {
         latitude = lat / 1e7;
@@ -294,11 +345,11 @@ void PixhawkInterface::parseGPSRawInt(uint8_t* payload) {
              "m Sat=" + String(satelites));
 }
 
-void PixhawkInterface::parseAttitude(uint8_t* payload) {
+void PixhawkInterface::parseAttitude(const MavlinkMessage& message) {
     // Ángulos en radianes (float)
-    float rollRad = *((float*)&payload[4]);
-    float pitchRad = *((float*)&payload[8]);
-    float yawRad = *((float*)&payload[12]);
+    float rollRad = message.getFloat(ATTITUDE_ROLL);
+    float pitchRad = message.getFloat(ATTITUDE_PITCH);
+    float yawRad = message.getFloat(ATTITUDE_YAW);
     
     // Convertir a grados
     roll = rollRad * 180.0 / M_PI;
@@ -313,26 +364,26 @@ void PixhawkInterface::parseAttitude(uint8_t* payload) {
               "° Pitch=" + String(pitch, 1) + "° Yaw=" + String(heading, 1) + "°");
 }
 
-void PixhawkInterface::parseGlobalPosition(uint8_t* payload) {
+void PixhawkInterface::parseGlobalPosition(const MavlinkMessage& message) {
     // Altitud absoluta y relativa (int32 en mm)
-    int32_t alt = *((int32_t*)&payload[16]);
-    int32_t relativeAlt = *((int32_t*)&payload[20]);
+    int32_t alt = message.getInt(GLOBAL_POSITION_INT_ALT);
+    int32_t relativeAlt = message.getInt(GLOBAL_POSITION_INT_RELATIVE_ALT);
     
     altitude = alt / 1000.0;
     altitudeRelative = relativeAlt / 1000.0;
     
     // Velocidad vertical (int16 en cm/s, coordenadas NED)
-    int16_t vz = *((int16_t*)&payload[26]);
+    int16_t vz = message.getInt(GLOBAL_POSITION_INT_VZ);
     velocidadVertical = -vz / 100.0;  // Negativo porque MAVLink usa NED
     
     LOG_DEBUG("PIXHAWK", "🌍 GlobalPos: Alt=" + String(altitude, 1) + 
               "m AltRel=" + String(altitudeRelative, 1) + "m Vz=" + String(velocidadVertical, 1) + "m/s");
 }
 
-void PixhawkInterface::parseVFRHUD(uint8_t* payload) {
+void PixhawkInterface::parseVFRHUD(const MavlinkMessage& message) {
     // Velocidades (float)
-    airSpeed = *((float*)&payload[0]);
-    groundSpeed = *((float*)&payload[4]);
+    airSpeed = message.getFloat(VFR_HUD_AIRSPEED);
+    groundSpeed = message.getFloat(VFR_HUD_GROUNDSPEED);
     
     // Compatibilidad con nombres antiguos
     velocidadAire = airSpeed;
@@ -342,36 +393,46 @@ void PixhawkInterface::parseVFRHUD(uint8_t* payload) {
               "m/s VelSuelo=" + String(groundSpeed, 1) + "m/s");
 }
 
-void PixhawkInterface::parseBatteryStatus(uint8_t* payload) {
+void PixhawkInterface::parseBatteryStatus(const MavlinkMessage& message) {
     // Temperatura (int16 en centígrados * 100)
-    int16_t temp = *((int16_t*)&payload[3]);
+    int16_t temp = message.getInt(BATTERY_STATUS_TEMPERATURE);
     if (temp != INT16_MAX) {
         batteryTemperature = temp / 100.0;
     }
     
-    // Voltaje de primera celda (uint16 en mV)
-    uint16_t cellVoltage = *((uint16_t*)&payload[8]);
-    if (cellVoltage != UINT16_MAX) {
-        batteryVoltage = cellVoltage / 1000.0;
+    // Voltaje del pack: suma de las celdas informadas (mV). Sin monitoreo
+    // por celda el autopiloto manda el total en la primera
+    uint32_t packVoltage = 0;
+    for (uint8_t cell = 0; cell < 10; cell++) {
+        uint16_t cellVoltage = message.getInt(BATTERY_STATUS_VOLTAGES, cell);
+        if (cellVoltage != UINT16_MAX) {
+            packVoltage += cellVoltage;
+        }
+    }
+    if (packVoltage > 0) {
+        batteryVoltage = packVoltage / 1000.0;
     }
     
     // Corriente (int16 en cA)
-    int16_t current = *((int16_t*)&payload[22]);
+    int16_t current = message.getInt(BATTERY_STATUS_CURRENT_BATTERY);
     if (current != -1) {
         batteryCurrent = current / 100.0;
     }
     
     // Porcentaje restante
-    batteryRemaining = payload[24];
+    int8_t remaining = message.getInt(BATTERY_STATUS_BATTERY_REMAINING);
+    if (remaining != -1) {
+        batteryRemaining = remaining;
+    }
     
     LOG_INFO("PIXHAWK", "🔋 Batería detallada: " + String(batteryVoltage, 2) + "V, " + 
              String(batteryCurrent, 2) + "A, " + String(batteryRemaining) + "%, " + 
              String(batteryTemperature, 1) + "°C");
 }
 
-void PixhawkInterface::parseGPSStatus(uint8_t* payload) {
+void PixhawkInterface::parseGPSStatus(const MavlinkMessage& message) {
     // Número de satélites visibles
-    numSatellites = payload[0];
+    numSatellites = message.getInt(GPS_STATUS_SATELLITES_VISIBLE);
     satelites = numSatellites;  // Compatibilidad
     
     LOG_DEBUG("PIXHAWK", "🛰️ GPS Status: " + String(numSatellites) + " satélites visibles");
@@ -443,135 +504,162 @@ bool PixhawkInterface::isLeapYear(uint16_t year) {
 // ====================== GETTERS (mantener interfaz original) ======================
 
 float PixhawkInterface::getLatitude() {
-    return latitude;
+    return getState().latitude;
 }
 
 float PixhawkInterface::getLongitude() {
-    return longitude;
+    return getState().longitude;
 }
 
 float PixhawkInterface::getAltitude() {
-    return altitude;
+    return getState().altitude;
 }
 
 float PixhawkInterface::getHeading() {
-    return heading;
+    return getState().heading;
 }
 
 float PixhawkInterface::getBatteryVoltage() {
-    return batteryVoltage;
+    return getState().batteryVoltage;
 }
 
 float PixhawkInterface::getBatteryCurrent() {
-    return batteryCurrent;
+    return getState().batteryCurrent;
 }
 
 int PixhawkInterface::getBatteryRemaining() {
-    return batteryRemaining;
+    return getState().batteryRemaining;
 }
 
 float PixhawkInterface::getBatteryTemperature() {
-    return batteryTemperature;
+    return getState().batteryTemperature;
 }
 
 float PixhawkInterface::getGroundSpeed() {
-    return groundSpeed;
+    return getState().groundSpeed;
 }
 
 float PixhawkInterface::getAirSpeed() {
-    return airSpeed;
+    return getState().airSpeed;
 }
 
 int PixhawkInterface::getNumSatellites() {
-    return numSatellites;
+    return getState().numSatellites;
 }
 
 // 🕐 NUEVOS GETTERS PARA DATOS DE TIEMPO
 uint64_t PixhawkInterface::getGPSTimeUsec() {
-    return gpsTimeUsec;
+    return getState().gpsTimeUsec;
 }
 
 uint16_t PixhawkInterface::getGPSYear() {
-    return gpsYear;
+    return getState().gpsYear;
 }
 
 uint8_t PixhawkInterface::getGPSMonth() {
-    return gpsMonth;
+    return getState().gpsMonth;
 }
 
 uint8_t PixhawkInterface::getGPSDay() {
-    return gpsDay;
+    return getState().gpsDay;
 }
 
 uint8_t PixhawkInterface::getGPSHour() {
-    return gpsHour;
+    return getState().gpsHour;
 }
 
 uint8_t PixhawkInterface::getGPSMinute() {
-    return gpsMinute;
+    return getState().gpsMinute;
 }
 
 uint8_t PixhawkInterface::getGPSSecond() {
-    return gpsSecond;
+    return getState().gpsSecond;
 }
 
 bool PixhawkInterface::hasValidGPSTime() {
-    return gpsTimeValid && gpsYear >= 2020;
+    return getState().hasValidTime();
 }
 
 String PixhawkInterface::getGPSTimeString() {
-    if (!hasValidGPSTime()) {
+    PixhawkState state = getState();
+    if (!state.hasValidTime()) {
         return "N/A";
     }
     
     char buffer[20];
     sprintf(buffer, "%04d-%02d-%02d %02d:%02d:%02d", 
-            gpsYear, gpsMonth, gpsDay, gpsHour, gpsMinute, gpsSecond);
+            state.gpsYear, state.gpsMonth, state.gpsDay, state.gpsHour, state.gpsMinute, state.gpsSecond);
     return String(buffer);
 }
 
 String PixhawkInterface::getGPSDateString() {
-    if (!hasValidGPSTime()) {
+    PixhawkState state = getState();
+    if (!state.hasValidTime()) {
         return "N/A";
     }
     
     char buffer[12];
-    sprintf(buffer, "%04d-%02d-%02d", gpsYear, gpsMonth, gpsDay);
+    sprintf(buffer, "%04d-%02d-%02d", state.gpsYear, state.gpsMonth, state.gpsDay);
     return String(buffer);
 }
 
 String PixhawkInterface::getGPSTimeOnlyString() {
-    if (!hasValidGPSTime()) {
+    PixhawkState state = getState();
+    if (!state.hasValidTime()) {
         return "N/A";
     }
     
     char buffer[10];
-    sprintf(buffer, "%02d:%02d:%02d", gpsHour, gpsMinute, gpsSecond);
+    sprintf(buffer, "%02d:%02d:%02d", state.gpsHour, state.gpsMinute, state.gpsSecond);
     return String(buffer);
 }
 
+// ====================== ENLACE MAVLINK ======================
+
+String PixhawkInterface::getLinkStatsString() const {
+    const MavlinkStats& stats = mavlink.getStats();
+    unsigned long elapsed = millis() - linkStatsStart;
+    uint32_t bytesPerSecond = elapsed > 0 ? (uint32_t)((uint64_t)stats.bytes * 1000 / elapsed) : 0;
+    float framesPerSecond = elapsed > 0 ? stats.frames * 1000.0f / elapsed : 0.0f;
+
+    return String(bytesPerSecond) + " B/s, " + String(framesPerSecond, 1) + " frames/s" +
+           ", CRC mal=" + String(stats.crcErrors) +
+           " desconocidos=" + String(stats.unknownFrames) +
+           " header mal=" + String(stats.badHeaders) +
+           " perdidos=" + String(stats.lostFrames) + " (" + String(stats.dropRate() * 100.0f, 2) + "%)" +
+           " bytes salteados=" + String(stats.skippedBytes);
+}
+
+void PixhawkInterface::resetLinkStats() {
+    mavlink.resetStats();
+    linkStatsStart = millis();
+}
+
 // ====================== FUNCIONES CSV Y DISPLAY ======================
 
 String PixhawkInterface::getCSVHeader() {
-    return "Latitude,Longitude,Altitude,GPSYear,GPSMonth,GPSDay,GPSHour,GPSMinute,GPSSecond";
+    return "Latitude,Longitude,Altitude";
 }
 
 String PixhawkInterface::save_CSVData() {
+    PixhawkState state = getState();
     String data = "";
-    data += String(latitude, 6) + ",";
-    data += String(longitude, 6) + ",";
-    data += String(altitude, 2) + ",";
-    data += String(gpsYear) + ",";
-    data += String(gpsMonth) + ",";
-    data += String(gpsDay) + ",";
-    data += String(gpsHour) + ",";
-    data += String(gpsMinute) + ",";
-    data += String(gpsSecond) + ",";
+    data += String(state.latitude, 6) + ",";
+    data += String(state.longitude, 6) + ",";
+    data += String(state.altitude, 2) + ",";
     return data;
 }
 
+void PixhawkInterface::fillRecord(SampleRecord& record) const {
+    PixhawkState state = getState();
+    record.latitude = state.latitude;
+    record.longitude = state.longitude;
+    record.altitude = state.altitude;
+}
+
 void PixhawkInterface::show_message() {
-    if (!connected) {
+    PixhawkState state = getState();
+    if (!state.connected) {
         LOG_WARN("PIXHAWK", "❌ PIXHAWK DESCONECTADO");
         return;
     }
@@ -580,34 +668,34 @@ void PixhawkInterface::show_message() {
 
     // 🕐 MOSTRAR DATOS DE TIEMPO PRIMERO
     LOG_INFO("PIXHAWK", " TIEMPO GPS:");
-    if (hasValidGPSTime()) {
+    if (state.hasValidTime()) {
         LOG_INFO("PIXHAWK", "  Fecha: " + getGPSDateString());
         LOG_INFO("PIXHAWK", "  Hora UTC: " + getGPSTimeOnlyString());
-        LOG_INFO("PIXHAWK", "  Timestamp: " + String(gpsTimeUsec) + " μs");
+        LOG_INFO("PIXHAWK", "  Timestamp: " + String(state.gpsTimeUsec) + " μs");
     } else {
         LOG_WARN("PIXHAWK", "  Sin datos válidos de tiempo GPS");
     }
 
     // 📍 Datos de posición
     LOG_INFO("PIXHAWK", "📍 POSICIÓN:");
-    LOG_INFO("PIXHAWK", "  Latitud: " + String(latitude, 6) + "°");
-    LOG_INFO("PIXHAWK", "  Longitud: " + String(longitude, 6) + "°");
-    LOG_INFO("PIXHAWK", "  Altitud: " + String(altitude, 2) + " m");
-    LOG_INFO("PIXHAWK", "  Heading: " + String(heading, 1) + "°");
+    LOG_INFO("PIXHAWK", "  Latitud: " + String(state.latitude, 6) + "°");
+    LOG_INFO("PIXHAWK", "  Longitud: " + String(state.longitude, 6) + "°");
+    LOG_INFO("PIXHAWK", "  Altitud: " + String(state.altitude, 2) + " m");
+    LOG_INFO("PIXHAWK", "  Heading: " + String(state.heading, 1) + "°");
     
     // 🔋 Datos de batería
     LOG_INFO("PIXHAWK", "🔋 BATERÍA:");
-    LOG_INFO("PIXHAWK", "  Voltaje: " + String(batteryVoltage, 2) + " V");
-    LOG_INFO("PIXHAWK", "  Corriente: " + String(batteryCurrent, 2) + " A");
-    LOG_INFO("PIXHAWK", "  Restante: " + String(batteryRemaining) + " %");
-    LOG_INFO("PIXHAWK", "  Temperatura: " + String(batteryTemperature, 1) + " °C");
+    LOG_INFO("PIXHAWK", "  Voltaje: " + String(state.batteryVoltage, 2) + " V");
+    LOG_INFO("PIXHAWK", "  Corriente: " + String(state.batteryCurrent, 2) + " A");
+    LOG_INFO("PIXHAWK", "  Restante: " + String(state.batteryRemaining) + " %");
+    LOG_INFO("PIXHAWK", "  Temperatura: " + String(state.batteryTemperature, 1) + " °C");
     
     // 📊 Datos adicionales
     LOG_INFO("PIXHAWK", "📊 NAVEGACIÓN:");
-    LOG_INFO("PIXHAWK", "  Vel. tierra: " + String(groundSpeed, 1) + " m/s");
-    LOG_INFO("PIXHAWK", "  Vel. aire: " + String(airSpeed, 1) + " m/s");
-    LOG_INFO("PIXHAWK", "  Satélites: " + String(numSatellites));
-    LOG_INFO("PIXHAWK", "  Estado: " + String(armed ? "ARMADO" : "DESARMADO"));
+    LOG_INFO("PIXHAWK", "  Vel. tierra: " + String(state.groundSpeed, 1) + " m/s");
+    LOG_INFO("PIXHAWK", "  Vel. aire: " + String(state.airSpeed, 1) + " m/s");
+    LOG_INFO("PIXHAWK", "  Satélites: " + String(state.numSatellites));
+    LOG_INFO("PIXHAWK", "  Estado: " + String(state.armed ? "ARMADO" : "DESARMADO"));
     
     LOG_INFO("PIXHAWK", "====================================================");
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "modules/record_schema.h"
+#include "utils/crc.h"
+
+#define FIELD(name, type, member, decimals) \
+    { name, type, (uint16_t)offsetof(SampleRecord, member), 1.0f, decimals }
+
+// Mismo orden que las columnas del CSV
+const FieldDescriptor RECORD_FIELDS[] = {
+    FIELD("Timestamp",        FIELD_U32, timestampMs,      0),
+    FIELD("UTC_us",           FIELD_U64, utcUsec,          0),
+    FIELD("SonarDepth",       FIELD_F32, sonarDepth,       3),
+    FIELD("WaterTemperature", FIELD_F32, waterTemperature, 1),
+    FIELD("SonarValid",       FIELD_U8,  sonarValid,       0),
+    FIELD("pH",               FIELD_F32, ph,               3),
+    FIELD("DO",               FIELD_F32, dissolvedOxygen,  3),
+    FIELD("EC",               FIELD_F32, conductivity,     1),
+    FIELD("pH_TC",            FIELD_F32, phCompensated,    3),
+    FIELD("EC25",             FIELD_F32, conductivity25,   1),
+    FIELD("Latitude",         FIELD_F32, latitude,         6),
+    FIELD("Longitude",        FIELD_F32, longitude,        6),
+    FIELD("Altitude",         FIELD_F32, altitude,         2),
+};
+
+const uint8_t RECORD_FIELD_COUNT = sizeof(RECORD_FIELDS) / sizeof(RECORD_FIELDS[0]);
+
+static_assert(sizeof(RECORD_FIELDS) / sizeof(RECORD_FIELDS[0]) == SAMPLE_CSV_FIELD_COUNT,
+              "RECORD_FIELDS y SAMPLE_CSV_FIELD_COUNT no coinciden");
+
+size_t fieldTypeSize(FieldType type) {
+    switch (type) {
+        case FIELD_U8:  return 1;
+        case FIELD_U16: return 2;
+        case FIELD_U32: return 4;
+        case FIELD_I32: return 4;
+        case FIELD_F32: return 4;
+        case FIELD_U64: return 8;
+        default:        return 0;
+    }
+}
+
+int formatSchemaCSVHeader(char* buffer, size_t size) {
+    size_t len = 0;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        int n = snprintf(buffer + len, size - len, i == 0 ? "%s" : ",%s", RECORD_FIELDS[i].name);
+        if (n < 0 || len + n >= size) {
+            return -1;
+        }
+        len += n;
+    }
+    return (int)len;
+}
+
+size_t binaryRecordPayloadSize() {
+    size_t size = 0;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        size += fieldTypeSize(RECORD_FIELDS[i].type);
+    }
+    return size;
+}
+
+size_t binaryHeaderSize() {
+    return sizeof(BinaryLogHeader) + RECORD_FIELD_COUNT * sizeof(BinaryFieldEntry) + sizeof(uint16_t);
+}
+
+size_t writeBinaryHeader(uint8_t* buffer, size_t size, uint8_t version) {
+    size_t total = binaryHeaderSize();
+    if (size < total) {
+        return 0;
+    }
+
+    BinaryLogHeader header;
+    memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+    header.version = version;
+    header.fieldCount = RECORD_FIELD_COUNT;
+    header.recordSize = (uint16_t)binaryRecordSize();
+    header.headerSize = (uint16_t)total;
+    memcpy(buffer, &header, sizeof(header));
+
+    size_t pos = sizeof(header);
+    uint16_t packedOffset = 0;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        BinaryFieldEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.type = RECORD_FIELDS[i].type;
+        entry.decimals = RECORD_FIELDS[i].decimals;
+        entry.packedOffset = packedOffset;
+        entry.scale = RECORD_FIELDS[i].scale;
+        strncpy(entry.name, RECORD_FIELDS[i].name, BINARY_FIELD_NAME_LENGTH - 1);
+
+        memcpy(buffer + pos, &entry, sizeof(entry));
+        pos += sizeof(entry);
+        packedOffset += fieldTypeSize(RECORD_FIELDS[i].type);
+    }
+
+    uint16_t crc = crc16Ccitt(buffer, pos);
+    memcpy(buffer + pos, &crc, sizeof(crc));
+    return total;
+}
+
+// ESP32 y PC son little-endian: los campos se copian tal cual
+size_t encodeBinaryRecord(const SampleRecord& record, uint8_t* buffer, size_t size) {
+    size_t total = binaryRecordSize();
+    if (size < total) {
+        return 0;
+    }
+
+    const uint8_t* source = (const uint8_t*)&record;
+    size_t pos = 0;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        size_t fieldSize = fieldTypeSize(RECORD_FIELDS[i].type);
+        memcpy(buffer + pos, source + RECORD_FIELDS[i].recordOffset, fieldSize);
+        pos += fieldSize;
+    }
+
+    uint16_t crc = crc16Ccitt(buffer, pos);
+    memcpy(buffer + pos, &crc, sizeof(crc));
+    return total;
+}
+
+bool decodeBinaryRecord(const uint8_t* buffer, SampleRecord& record) {
+    size_t payload = binaryRecordPayloadSize();
+
+    uint16_t stored;
+    memcpy(&stored, buffer + payload, sizeof(stored));
+    if (crc16Ccitt(buffer, payload) != stored) {
+        return false;
+    }
+
+    memset(&record, 0, sizeof(record));
+    uint8_t* target = (uint8_t*)&record;
+    size_t pos = 0;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        size_t fieldSize = fieldTypeSize(RECORD_FIELDS[i].type);
+        memcpy(target + RECORD_FIELDS[i].recordOffset, buffer + pos, fieldSize);
+        pos += fieldSize;
+    }
+    return true;
+}
+
+double decimalScale(uint8_t decimals) {
+    static const double POWERS[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    return POWERS[decimals < 10 ? decimals : 9];
+}
+
+void quantizeRecord(const SampleRecord& record, int64_t* values) {
+    const uint8_t* source = (const uint8_t*)&record;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        const FieldDescriptor& field = RECORD_FIELDS[i];
+        const uint8_t* member = source + field.recordOffset;
+        switch (field.type) {
+            case FIELD_U8:
+                values[i] = *member;
+                break;
+            case FIELD_U16: {
+                uint16_t value;
+                memcpy(&value, member, sizeof(value));
+                values[i] = value;
+                break;
+            }
+            case FIELD_U32: {
+                uint32_t value;
+                memcpy(&value, member, sizeof(value));
+                values[i] = value;
+                break;
+            }
+            case FIELD_I32: {
+                int32_t value;
+                memcpy(&value, member, sizeof(value));
+                values[i] = value;
+                break;
+            }
+            case FIELD_U64: {
+                // UTC en µs: cabe en int64 hasta el año 294247
+                uint64_t value;
+                memcpy(&value, member, sizeof(value));
+                values[i] = (int64_t)value;
+                break;
+            }
+            case FIELD_F32: {
+                float value;
+                memcpy(&value, member, sizeof(value));
+                // llrint redondea al par como printf en los empates exactos
+                values[i] = isfinite(value) ? llrint((double)value * decimalScale(field.decimals)) : QUANTIZED_NAN;
+                break;
+            }
+            default:
+                values[i] = 0;
+                break;
+        }
+    }
+}
+
+void dequantizeRecord(const int64_t* values, SampleRecord& record) {
+    memset(&record, 0, sizeof(record));
+    uint8_t* target = (uint8_t*)&record;
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        const FieldDescriptor& field = RECORD_FIELDS[i];
+        uint8_t* member = target + field.recordOffset;
+        switch (field.type) {
+            case FIELD_U8:
+                *member = (uint8_t)values[i];
+                break;
+            case FIELD_U16: {
+                uint16_t value = (uint16_t)values[i];
+                memcpy(member, &value, sizeof(value));
+                break;
+            }
+            case FIELD_U32: {
+                uint32_t value = (uint32_t)values[i];
+                memcpy(member, &value, sizeof(value));
+                break;
+            }
+            case FIELD_I32: {
+                int32_t value = (int32_t)values[i];
+                memcpy(member, &value, sizeof(value));
+                break;
+            }
+            case FIELD_U64: {
+                uint64_t value = (uint64_t)values[i];
+                memcpy(member, &value, sizeof(value));
+                break;
+            }
+            case FIELD_F32: {
+                float value = values[i] == QUANTIZED_NAN ? NAN : (float)(values[i] / decimalScale(field.decimals));
+                memcpy(member, &value, sizeof(value));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include <math.h>
+#include <stdio.h>
+#include "modules/sample_record.h"
+
+// Mismo layout que el header generado en main.cpp:
+// Timestamp, UTC (vacío sin referencia), sonar, analógicos (y compensados),
+// Pixhawk (con la coma final histórica)
+int formatRecordCSV(const SampleRecord& record, char* buffer, size_t size) {
+    int len;
+
+    // UTC en dos mitades: printf de newlib-nano no siempre trae %llu
+    char utc[24] = "";
+    if (record.utcUsec != 0) {
+        snprintf(utc, sizeof(utc), "%lu%06lu",
+                 (unsigned long)(record.utcUsec / 1000000ULL),
+                 (unsigned long)(record.utcUsec % 1000000ULL));
+    }
+
+    if (record.sonarValid) {
+        len = snprintf(buffer, size, "%lu,%s,%.3f,%.1f,1,",
+                       (unsigned long)record.timestampMs, utc,
+                       isnan(record.sonarDepth) ? 0.0 : (double)record.sonarDepth,
+                       isnan(record.waterTemperature) ? 0.0 : (double)record.waterTemperature);
+    } else {
+        len = snprintf(buffer, size, "%lu,%s,NaN,NaN,0,", (unsigned long)record.timestampMs, utc);
+    }
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+
+    int n = snprintf(buffer + len, size - len, "%.3f,%.3f,%.1f,",
+                     record.ph, record.dissolvedOxygen, record.conductivity);
+    if (n < 0 || (size_t)(len + n) >= size) {
+        return -1;
+    }
+    len += n;
+
+    // Compensados por temperatura
+    if (isnan(record.phCompensated) || isnan(record.conductivity25)) {
+        n = snprintf(buffer + len, size - len, "NaN,NaN,");
+    } else {
+        n = snprintf(buffer + len, size - len, "%.3f,%.1f,",
+                     record.phCompensated, record.conductivity25);
+    }
+    if (n < 0 || (size_t)(len + n) >= size) {
+        return -1;
+    }
+    len += n;
+
+    n = snprintf(buffer + len, size - len,
+                 "%.6f,%.6f,%.2f,",
+                 record.latitude, record.longitude, record.altitude);
+    if (n < 0 || (size_t)(len + n) >= size) {
+        return -1;
+    }
+
+    return len + n;
+}
+
+bool parseRecordCSVTimestamp(const char* line, size_t length, uint32_t& timestamp) {
+    if (length == 0 || length > SAMPLE_CSV_MAX_LENGTH) {
+        return false;
+    }
+
+    // Solo números, NaN/inf y separadores; una coma por campo (coma final incluida)
+    size_t commas = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = line[i];
+        if (c == ',') {
+            commas++;
+        } else if (!((c >= '0' && c <= '9') || c == '.' || c == '-' ||
+                     c == 'N' || c == 'a' || c == 'n' || c == 'i' || c == 'f')) {
+            return false;
+        }
+    }
+    if (commas != SAMPLE_CSV_FIELD_COUNT || line[length - 1] != ',') {
+        return false;
+    }
+
+    // Timestamp: entero sin signo
+    uint32_t value = 0;
+    size_t i = 0;
+    for (; i < length && line[i] != ','; i++) {
+        if (line[i] < '0' || line[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (line[i] - '0');
+    }
+    if (i == 0) {
+        return false;
+    }
+
+    timestamp = value;
+    return true;
+}
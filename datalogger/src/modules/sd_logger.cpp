@@ -1,46 +1,482 @@
+#include <time.h>
+#include <unistd.h>
 #include "logger.h"
 #include "modules/sd_logger.h"
+#include "modules/record_schema.h"
+#include "modules/log_journal.h"
+#include "modules/delta_codec.h"
+#include "utils/crc.h"
+
+// Sistema de archivos del bus elegido (ambos son fs::FS montados en SD_MOUNT_POINT)
+#if SD_BUS_MODE == SD_BUS_SPI
+static auto& sdCard = SD;
+#else
+#include <SD_MMC.h>
+static auto& sdCard = SD_MMC;
+#endif
+
+#if SD_FLASH_FALLBACK
+#include <LittleFS.h>
+#endif
+
+// Espacio para el header del frame delante de cada payload
+#if SD_LOG_JOURNAL
+static const size_t FRAME_HEADER_SIZE = sizeof(JournalFrameHeader);
+static_assert(BINARY_HEADER_MAX_SIZE <= JOURNAL_MAX_PAYLOAD, "El header binario no cabe en un frame");
+#else
+static const size_t FRAME_HEADER_SIZE = 0;
+#endif
+
+static String sequenceFilename(uint32_t sequence) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "/log_%0*lu" SD_LOG_EXTENSION, SD_SEQUENCE_DIGITS, (unsigned long)sequence);
+    return String(buffer);
+}
 
 SDLogger::SDLogger() {
     sdInitialized = false;
-    lastWriteTime = 0;
+    cardMounted = false;
+    cardRecovered = false;
+    fileCreated = false;
+    discardStream = false;
+    consecutiveErrors = 0;
+    flashMounted = false;
+    onFlash = false;
+    nextOnFlash = false;
+    cardLostTime = 0;
+    fileOpen = false;
+    fileOffset = 0;
+
+    for (int i = 0; i < SD_BUFFER_COUNT; i++) {
+        buffers[i].length = 0;
+        buffers[i].written = 0;
+        buffers[i].startsNewFile = false;
+    }
+    activeBuffer = 0;
+    writeIndex = 0;
+    fullCount = 0;
+    portMUX_INITIALIZE(&lock);
+    taskHandle = nullptr;
+
+    recordsSinceFlush = 0;
+    unflushedBytes = 0;
+    lastFlushTime = 0;
+    flushRequested = false;
+    powerWarning = false;
+
+    preallocateBytes = 0;
+    allocatedSize = 0;
+    lastCheckpointTime = 0;
+    closeRequested = false;
+    benchRequested = false;
+    benchBytes = 0;
+    benchResult = nullptr;
+
+    fileNumber = 0;
+    timeSync = nullptr;
+    fileStartUs = 0;
+    filenameStamped = false;
+    fileStartTime = 0;
+    rotationState = ROTATION_NONE;
+    nextFileNumber = 0;
+    streamStarted = false;
+    journalFileNumber = 0;
+    journalSequence = 0;
+    deltaSinceKeyFrame = 0;
+    spool = nullptr;
+    spoolCapacity = 0;
+    spoolHead = 0;
+    spoolCount = 0;
+
+    stats.reset();
+    statsStartTime = 0;
+}
+
+void SDLogger::setPreallocation(uint32_t bytes) {
+    // Sectores completos
+    preallocateBytes = ((bytes + SD_SECTOR_SIZE - 1) / SD_SECTOR_SIZE) * SD_SECTOR_SIZE;
 }
 
 bool SDLogger::begin() {
-    // Inicializar SPI para la tarjeta SD
-    SPI.begin(SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN);
-    
-    // Inicializar la tarjeta SD
-    if (!SD.begin(SD_CS_PIN)) {
-        LOG_ERROR("SD_LOGGER", "Error al inicializar la tarjeta SD");
+    nvs.begin("sdlog", false);
+
+    // Spool para los registros que no entran en los buffers
+    spool = (SampleRecord*)ps_malloc(SD_SPOOL_RECORDS * sizeof(SampleRecord));
+    if (spool != nullptr) {
+        spoolCapacity = SD_SPOOL_RECORDS;
+        LOG_INFO("SD_LOGGER", "Spool en PSRAM: " + String(spoolCapacity) + " registros");
+    } else {
+        // Sin PSRAM (o sin -DBOARD_HAS_PSRAM): un spool chico en la RAM
+        // interna cubre hasta el respaldo en la flash o el remontaje
+        spool = (SampleRecord*)malloc(SD_SPOOL_INTERNAL_RECORDS * sizeof(SampleRecord));
+        if (spool != nullptr) {
+            spoolCapacity = SD_SPOOL_INTERNAL_RECORDS;
+            LOG_WARN("SD_LOGGER", "Sin PSRAM: spool de " + String(spoolCapacity) + " registros en RAM interna");
+        } else {
+            LOG_WARN("SD_LOGGER", "Sin memoria para el spool: con los buffers llenos los registros se descartan");
+        }
+    }
+
+#if SD_FLASH_FALLBACK
+    // Se monta ya para que el respaldo no espere y dump_flash sirva sin
+    // tarjeta. Solo se formatea una partición sin LittleFS (primer uso)
+    if (LittleFS.begin(true, FLASH_LOG_MOUNT_POINT, 4, FLASH_LOG_PARTITION)) {
+        flashMounted = true;
+        LOG_INFO("SD_LOGGER", "Flash interna: " + String(LittleFS.usedBytes() / 1024) + "/" +
+                 String(LittleFS.totalBytes() / 1024) + " KB usados");
+    } else {
+        LOG_ERROR("SD_LOGGER", "No se pudo montar la partición '" FLASH_LOG_PARTITION "': sin respaldo en la flash");
+    }
+#endif
+
+    // El primer archivo se abre como una rotación en cuanto hay tarjeta: si
+    // no está ahora, los registros esperan en el spool
+    if (mountCard()) {
+        cardMounted = true;
+        prepareCard();
+    } else {
+        cardLostTime = millis();
+        LOG_WARN("SD_LOGGER", "Sin tarjeta SD (" + getBusDescription() + "): se reintenta cada " +
+                 String(SD_WRITER_RETRY_MS) + " ms");
+    }
+
+    // Desde aquí solo la tarea de escritura accede a la tarjeta
+    lastFlushTime = millis();
+    fileStartTime = lastFlushTime;
+    if (xTaskCreatePinnedToCore(writerTask, "sd_writer", SD_WRITER_TASK_STACK, this,
+                                SD_WRITER_TASK_PRIORITY, &taskHandle, SD_WRITER_TASK_CORE) != pdPASS) {
+        LOG_ERROR("SD_LOGGER", "No se pudo crear la tarea de escritura");
         return false;
     }
-        // Verificar información de la tarjeta
-    uint64_t cardSize = SD.cardSize() / (1024 * 1024);
-    LOG_INFO("SD_LOGGER", "Tarjeta SD detectada. Tamaño: " + String(cardSize) + " MB");
 
-    generateUniqueFilename();
     sdInitialized = true;
-    LOG_INFO("SD_LOGGER", "Tarjeta SD inicializada correctamente");
+    LOG_INFO("SD_LOGGER", "Logger iniciado (" + String(SD_BUFFER_COUNT) +
+             " buffers de " + String(SD_BATCH_BUFFER_SIZE) + " bytes)");
     return true;
 }
 
-void SDLogger::generateUniqueFilename() {
-    int lastNumber = -1;  
+// Tarjeta recién montada (al arrancar o tras perderla)
+void SDLogger::prepareCard() {
+    uint64_t cardSize = sdCard.cardSize() / (1024 * 1024);
+    LOG_INFO("SD_LOGGER", "Tarjeta SD detectada. Tamaño: " + String(cardSize) + " MB, bus " + getBusDescription());
+
+    // Archivo de la sesión anterior que quedó abierto por un corte de energía
+    if (!cardRecovered) {
+        recoverPreviousFile();
+        cardRecovered = true;
+    }
+
+    // Se estaba registrando (o por pasar) a la flash: el próximo archivo
+    // vuelve a la tarjeta
+    if (onFlash || nextOnFlash) {
+        nextOnFlash = false;
+        if (rotationState == ROTATION_NONE) {
+            nextFileNumber = reserveFileNumber();
+            rotationState = ROTATION_DUE;
+        }
+        LOG_INFO("SD_LOGGER", "Tarjeta de vuelta: el log deja la flash interna");
+        return;
+    }
+
+    if (fileNumber == 0) {
+        // Todavía sin archivo: el productor lo empieza con su header
+        if (rotationState == ROTATION_NONE) {
+            nextFileNumber = reserveFileNumber();
+            rotationState = ROTATION_DUE;
+        }
+        return;
+    }
+
+    // ¿Es la misma tarjeta? Si el archivo en curso no está (o su nombre
+    // está ocupado sin haberlo creado) lo que queda en los buffers es de un
+    // archivo que ya no se puede completar: se descarta hasta el próximo
+    // corte y se sigue en un archivo nuevo
+    if (fileCreated != sdCard.exists(currentFilename)) {
+        LOG_WARN("SD_LOGGER", "'" + currentFilename + "' no corresponde a esta tarjeta: se sigue en un archivo nuevo");
+        fileOpen = false;
+        fileOffset = 0;
+        allocatedSize = 0;
+        unflushedBytes = 0;
+        discardStream = true;
+        if (rotationState == ROTATION_NONE) {
+            nextFileNumber = reserveFileNumber();
+            rotationState = ROTATION_DUE;
+        }
+    }
+}
+
+bool SDLogger::remountCard() {
+    if (!mountCard()) {
+        return false;
+    }
+
+    cardMounted = true;
+    consecutiveErrors = 0;
+    stats.remounts++;
+    prepareCard();
+    return true;
+}
+
+// La tarjeta dejó de responder (retirada o dañada): soltarla para volver a
+// montarla. Lo que está en los buffers se conserva para el mismo archivo
+void SDLogger::unmountCard() {
+    if (fileOpen) {
+        dataFile.close();
+        fileOpen = false;
+    }
+    sdCard.end();
+    cardMounted = false;
+    cardLostTime = millis();
+    LOG_WARN("SD_LOGGER", "Tarjeta SD perdida tras " + String(consecutiveErrors) +
+             " errores: se reintenta montarla cada " + String(SD_WRITER_RETRY_MS) + " ms");
+}
+
+// Sin tarjeta por más de SD_FLASH_FALLBACK_AFTER_MS: el log sigue en un
+// archivo nuevo en la flash. Lo que quedaba en los buffers para el archivo
+// de la SD va a su .part; ese archivo queda abierto en NVS y se recupera
+// cuando vuelve la tarjeta
+void SDLogger::checkFlashFallback() {
+#if SD_FLASH_FALLBACK
+    if (!flashMounted || onFlash || nextOnFlash ||
+        millis() - cardLostTime < SD_FLASH_FALLBACK_AFTER_MS) {
+        return;
+    }
+
+    // Una rotación ya pendiente (o el primer archivo) solo cambia de destino
+    nextOnFlash = true;
+    if (rotationState == ROTATION_NONE) {
+        nextFileNumber = reserveFileNumber();
+        rotationState = ROTATION_DUE;
+    }
+    if (fileNumber != 0) {
+        // El archivo de la SD se da por terminado en lo que ya tiene
+        allocatedSize = 0;
+        unflushedBytes = 0;
+        discardStream = true;
+        cardRecovered = false;
+    }
+    stats.flashFallbacks++;
+    LOG_WARN("SD_LOGGER", "Sin tarjeta SD desde hace " + String((millis() - cardLostTime) / 1000) +
+             " s: el log sigue en la flash interna");
+#endif
+}
+
+// Bytes de un archivo que ya no se puede completar (tarjeta perdida o
+// cambiada). Con la flash montada van a "<archivo>.part": concatenado al
+// archivo de la SD lo completa. Si no, se descartan
+void SDLogger::spillBuffer(const uint8_t* data, size_t length) {
+#if SD_FLASH_FALLBACK
+    if (flashMounted && fileNumber != 0) {
+        if (!spillFile) {
+            spillFile = LittleFS.open(currentFilename + ".part", FILE_APPEND);
+        }
+        if (spillFile && spillFile.write(data, length) == length) {
+            stats.spilledBytes += length;
+            return;
+        }
+    }
+#endif
+    stats.discardedBytes += length;
+}
+
+fs::FS& SDLogger::logFs() {
+#if SD_FLASH_FALLBACK
+    if (onFlash) {
+        return LittleFS;
+    }
+#endif
+    return sdCard;
+}
+
+// Montar la tarjeta con el bus de SD_BUS_MODE
+bool SDLogger::mountCard() {
+#if SD_BUS_MODE == SD_BUS_SPI
+    SPI.begin(SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN);
+    return SD.begin(SD_CS_PIN, SPI, SD_SPI_FREQ_HZ, SD_MOUNT_POINT);
+#else
+    bool oneBit = SD_BUS_MODE == SD_BUS_SDMMC_1BIT;
+    if (oneBit) {
+        // DAT3 sin usar pero en alto: en bajo la tarjeta entraría en modo SPI
+        pinMode(SD_MMC_D3_PIN, INPUT_PULLUP);
+        if (!SD_MMC.setPins(SD_MMC_CLK_PIN, SD_MMC_CMD_PIN, SD_MMC_D0_PIN)) {
+            return false;
+        }
+    } else if (!SD_MMC.setPins(SD_MMC_CLK_PIN, SD_MMC_CMD_PIN, SD_MMC_D0_PIN,
+                               SD_MMC_D1_PIN, SD_MMC_D2_PIN, SD_MMC_D3_PIN)) {
+        return false;
+    }
+    return SD_MMC.begin(SD_MOUNT_POINT, oneBit, false, SD_MMC_FREQ_KHZ);
+#endif
+}
+
+String SDLogger::getBusDescription() const {
+#if SD_BUS_MODE == SD_BUS_SPI
+    return "SPI a " + String(SD_SPI_FREQ_HZ / 1000000) + " MHz";
+#elif SD_BUS_MODE == SD_BUS_SDMMC_1BIT
+    return "SDMMC 1-bit a " + String(SD_MMC_FREQ_KHZ / 1000) + " MHz";
+#else
+    return "SDMMC 4-bit a " + String(SD_MMC_FREQ_KHZ / 1000) + " MHz";
+#endif
+}
+
+// El próximo número es el mayor entre el de NVS (este equipo) y el de
+// SD_SEQUENCE_FILE (todos los equipos que usaron la tarjeta), y solo se
+// comprueba que el nombre esté libre: el arranque no depende de cuántos
+// archivos haya. Los nombres con hora UTC no se encuentran con exists(),
+// pero su número ya quedó en ese archivo al reservarlo. El directorio se
+// recorre solo con una tarjeta sin ese archivo (primer uso o formateada en
+// la PC) o si hay demasiados nombres ocupados seguidos.
+uint32_t SDLogger::reserveFileNumber() {
+    uint32_t sequence = nvs.getUInt("seq", 0);
+
+    if (cardMounted) {
+        uint32_t cardNext;
+        if (!readCardSequence(cardNext)) {
+            cardNext = scanLastSequence() + 1;
+        }
+        if (cardNext > sequence) {
+            sequence = cardNext;
+        }
+    }
+    if (sequence == 0) {
+        sequence = 1;
+    }
+
+    if (cardMounted) {
+        int probes = 0;
+        while (sdCard.exists(sequenceFilename(sequence))) {
+            if (++probes > SD_SEQUENCE_PROBE_LIMIT) {
+                sequence = scanLastSequence() + 1;
+                break;
+            }
+            sequence++;
+        }
+        writeCardSequence(sequence + 1);
+    }
+
+    // Reservar el número aunque el archivo no llegue a crearse
+    nvs.putUInt("seq", sequence + 1);
+
+    LOG_INFO("SD_LOGGER", "Nuevo nombre generado: " + sequenceFilename(sequence));
+    return sequence;
+}
+
+// Próximo número guardado en la tarjeta; false si no tiene el archivo
+bool SDLogger::readCardSequence(uint32_t& next) {
+    File file = sdCard.open(SD_SEQUENCE_FILE, FILE_READ);
+    if (!file) {
+        return false;
+    }
+    String text = file.readStringUntil('\n');
+    file.close();
+
+    text.trim();
+    next = strtoul(text.c_str(), nullptr, 10);
+    return next > 0;
+}
+
+void SDLogger::writeCardSequence(uint32_t next) {
+    unsigned long start = micros();
+    File file = sdCard.open(SD_SEQUENCE_FILE, FILE_WRITE);
+    bool ok = file && file.println(next) > 0;
+    if (file) {
+        file.close();
+    }
+    recordStall(micros() - start);
+    if (!ok) {
+        LOG_WARN("SD_LOGGER", "No se pudo guardar el número en '" SD_SEQUENCE_FILE "'");
+    }
+}
+
+// Nombre del archivo `number` con la hora UTC de su inicio si ya se conoce.
+// Se fija filenameStamped para saber si falta renombrarlo
+String SDLogger::logFilename(uint32_t number) {
+    uint64_t utc = timeSync != nullptr ? timeSync->toUtc(fileStartUs) : 0;
+    filenameStamped = utc != 0;
+    if (!filenameStamped) {
+        return sequenceFilename(number);
+    }
+
+    time_t seconds = (time_t)(utc / 1000000ULL);
+    struct tm parts;
+    gmtime_r(&seconds, &parts);
+
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "/log_%0*lu_%04d%02d%02dT%02d%02d%02dZ" SD_LOG_EXTENSION,
+             SD_SEQUENCE_DIGITS, (unsigned long)number,
+             parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday,
+             parts.tm_hour, parts.tm_min, parts.tm_sec);
+    return String(buffer);
+}
+
+// Archivo abierto sin hora UTC (arranque sin GPS): al llegar la primera
+// referencia se renombra con la hora de su inicio, estimada hacia atrás
+void SDLogger::stampFilename() {
+    if (filenameStamped || fileNumber == 0 || discardStream || timeSync == nullptr || !timeSync->isSynced()) {
+        return;
+    }
+
+    String oldName = currentFilename;
+    String newName = logFilename(fileNumber);
+    if (!fileCreated) {
+        currentFilename = newName;     // Todavía no existe: basta con el nombre
+        return;
+    }
+
+    // FatFs no renombra un archivo abierto; openFile() lo reabre en su posición
+    if (fileOpen) {
+        if (unflushedBytes > 0) {
+            flushFile();
+        }
+        dataFile.close();
+        fileOpen = false;
+    }
+
+    unsigned long start = micros();
+    bool renamed = logFs().rename(oldName.c_str(), newName.c_str());
+    recordStall(micros() - start);
+    if (!renamed) {
+        // No reintentar en cada ciclo: el archivo sigue con su número
+        LOG_WARN("SD_LOGGER", "No se pudo renombrar '" + oldName + "' a '" + newName + "'");
+        return;
+    }
+
+    currentFilename = newName;
+    if (!onFlash) {
+        nvs.putString("file", currentFilename);
+    }
+    LOG_INFO("SD_LOGGER", "Archivo renombrado con hora UTC: '" + currentFilename + "'");
+}
+
+// Mayor número de log en la raíz (log_XXX heredados o log_NNNNNN, con o
+// sin hora y de cualquier formato), o 0
+uint32_t SDLogger::scanLastSequence() {
+    uint32_t lastNumber = 0;
+    unsigned long start = millis();
     
-    // Buscar el último número usado en la SD
-    File root = SD.open("/");
+    File root = sdCard.open("/");
     if (root) {
         File file = root.openNextFile();
         while (file) {
             String filename = file.name();
             
-            // Verificar si el archivo sigue el patrón log_XXX.csv
-            if (filename.startsWith("log_") && filename.endsWith(".csv") && filename.length() == 11) {
-                // Extraer el número: "log_025.csv" -> "025" -> 25
-                String numberStr = filename.substring(4, 7);  // Posiciones 4, 5, 6
-                int number = numberStr.toInt();
-                
+            // Patrón log_<dígitos>[_<hora UTC>].<ext>: también cuentan los
+            // de otro formato (.csv/.bin/.jnl), salvage agrupa por número
+            if (filename.startsWith("log_")) {
+                int end = filename.indexOf('_', 4);
+                if (end < 0) {
+                    end = filename.indexOf('.', 4);
+                }
+                if (end < 0) {
+                    end = filename.length();
+                }
+                String numberStr = filename.substring(4, end);
+                bool digits = numberStr.length() > 0;
+                for (unsigned int i = 0; i < numberStr.length(); i++) {
+                    digits = digits && isDigit(numberStr[i]);
+                }
+
+                uint32_t number = digits ? strtoul(numberStr.c_str(), nullptr, 10) : 0;
                 if (number > lastNumber) {
                     lastNumber = number;
                 }
@@ -50,66 +486,1147 @@ void SDLogger::generateUniqueFilename() {
         root.close();
     }
     
-    // Generar el siguiente número
-    int nextNumber = lastNumber + 1;
-    char buffer[20];
-    sprintf(buffer, "/log_%03d.csv", nextNumber);
-    currentFilename = String(buffer);
-    
-    LOG_INFO("SD_LOGGER", "Último archivo encontrado: log_" + String(lastNumber, 3));
-    LOG_INFO("SD_LOGGER", "Nuevo nombre generado: " + currentFilename);
+    LOG_INFO("SD_LOGGER", "Directorio recorrido en " + String(millis() - start) + " ms, último log: " +
+             String(lastNumber));
+    return lastNumber;
+}
+
+// Crear el archivo y reservar todo su espacio. Mover el puntero al final y
+// escribir un byte hace que FatFs encadene los clusters en una sola
+// operación; en una tarjeta sin fragmentar quedan consecutivos. Después se
+// escribe desde el principio sobre el espacio ya asignado.
+bool SDLogger::createPreallocated() {
+    unsigned long start = millis();
+
+    unsigned long openStart = micros();
+    dataFile = sdCard.open(currentFilename, FILE_WRITE);
+    stats.openLatency.record(micros() - openStart);
+    if (!dataFile) {
+        stats.openFailures++;
+        LOG_ERROR("SD_LOGGER", "Error al crear el archivo preasignado");
+        return false;
+    }
+
+    bool reserved = dataFile.seek(preallocateBytes - 1) && dataFile.write((uint8_t)0) == 1;
+    dataFile.flush();
+    if (!reserved || !dataFile.seek(0)) {
+        LOG_ERROR("SD_LOGGER", "No se pudieron reservar " + String(preallocateBytes) + " bytes");
+        dataFile.close();
+        sdCard.remove(currentFilename);
+        return false;
+    }
+
+    fileOpen = true;
+    fileCreated = true;
+    fileOffset = 0;
+    allocatedSize = preallocateBytes;
+    startCheckpoint();
+
+    LOG_INFO("SD_LOGGER", "Archivo:  '" + currentFilename + "'  preasignado: " + String(allocatedSize) +
+             " bytes en " + String(millis() - start) + " ms");
+    return true;
 }
 
+// El header entra al flujo al empezar cada archivo (markNewFile)
 bool SDLogger::writeHeader(String header) {
     dataHeader += header;
-    headerIsWritten = false;
-
     LOG_INFO("SD_LOGGER", "Header configurado: '" + dataHeader + "'");
-    LOG_INFO("SD_LOGGER", "El archivo se creará cuando se escriban los primeros datos");
     return true;
 }
 
-bool SDLogger::writeData(String data) {
+bool SDLogger::appendHeader() {
+    static uint8_t frame[FRAME_HEADER_SIZE + BINARY_HEADER_MAX_SIZE];
+    uint8_t* payload = frame + FRAME_HEADER_SIZE;
+    size_t space = sizeof(frame) - FRAME_HEADER_SIZE;
+
+#if SD_LOG_BINARY
+    // Esquema autodescriptivo en lugar del header de texto
+#if SD_LOG_COMPRESSED
+    size_t length = writeBinaryHeader(payload, space, BINARY_LOG_VERSION_DELTA);
+#else
+    size_t length = writeBinaryHeader(payload, space);
+#endif
+    if (length == 0) {
+        LOG_ERROR("SD_LOGGER", "El esquema no cabe en el header binario");
+        return false;
+    }
+#else
+    size_t length = dataHeader.length() + 2;
+    if (length > space) {
+        LOG_ERROR("SD_LOGGER", "Header CSV demasiado largo");
+        return false;
+    }
+    memcpy(payload, dataHeader.c_str(), length - 2);
+    payload[length - 2] = '\r';
+    payload[length - 1] = '\n';
+#endif
+
+#if SD_LOG_JOURNAL
+    // El header del archivo es el frame 0
+    sealJournalFrame(frame, length, journalFileNumber, 0);
+    journalSequence = 1;
+#endif
+#if SD_LOG_COMPRESSED
+    // Cada archivo empieza con un key frame: se lee sin los anteriores
+    deltaSinceKeyFrame = 0;
+#endif
+    return append(frame, FRAME_HEADER_SIZE + length);
+}
+
+// Cortar el flujo para la rotación: el buffer activo se entrega aunque no
+// esté lleno y el siguiente empieza el archivo nuevo con su header, así el
+// archivo nuevo también empieza alineado a sector. Si no hay buffer libre se
+// intenta en el próximo registro.
+void SDLogger::markNewFile() {
+    portENTER_CRITICAL(&lock);
+
+    WriteBuffer* active = &buffers[activeBuffer];
+    if (active->length > 0) {
+        if (fullCount >= SD_BUFFER_COUNT - 1) {
+            portEXIT_CRITICAL(&lock);
+            return;
+        }
+        fullCount++;
+        activeBuffer = (activeBuffer + 1) % SD_BUFFER_COUNT;
+        active = &buffers[activeBuffer];
+    }
+    active->startsNewFile = true;
+    rotationState = ROTATION_QUEUED;
+
+    portEXIT_CRITICAL(&lock);
+
+    journalFileNumber = nextFileNumber;
+    appendHeader();
+    streamStarted = true;
+}
+
+bool SDLogger::writeRecord(const SampleRecord& record) {
     if (!sdInitialized) {
         return false;
     }
-    
-    // Agregar datos al buffer
-    unsigned long timestamp = millis();
-    dataBuffer += data;
-    LOG_INFO("SD_LOGGER", "Buffer configurado a: "+ dataBuffer);
+
+    if (rotationState == ROTATION_DUE) {
+        markNewFile();
+    }
+
+    // Lo que espera en el spool va antes, para no desordenar el archivo
+    drainSpool();
+    if (spoolCount == 0 && streamStarted) {
+        AppendResult result = appendRecord(record);
+        if (result != APPEND_FULL) {
+            return result == APPEND_OK;
+        }
+    }
+    return spoolRecord(record);
+}
+
+// Formatear un registro y copiarlo a los buffers
+SDLogger::AppendResult SDLogger::appendRecord(const SampleRecord& record) {
+    // Formatear fuera de la sección crítica; solo la copia va protegida
+    uint8_t frame[FRAME_HEADER_SIZE + SAMPLE_CSV_MAX_LENGTH + 2];
+    uint8_t* payload = frame + FRAME_HEADER_SIZE;
+    unsigned long encodeStart = micros();
+#if SD_LOG_COMPRESSED
+    // Delta contra el último registro que entró al archivo, absoluto cada
+    // SD_DELTA_KEYFRAME_INTERVAL registros
+    int64_t values[SAMPLE_CSV_FIELD_COUNT];
+    quantizeRecord(record, values);
+    int len = (int)encodeDeltaRecord(values, deltaSinceKeyFrame == 0 ? nullptr : deltaPrevious,
+                                     SAMPLE_CSV_FIELD_COUNT, payload, SAMPLE_CSV_MAX_LENGTH);
+#elif SD_LOG_BINARY
+    // Registro empaquetado de tamaño fijo con CRC (mucho menor que una fila CSV)
+    int len = (int)encodeBinaryRecord(record, payload, SAMPLE_CSV_MAX_LENGTH);
+#else
+    // Fila CSV + "\r\n"
+    int len = formatRecordCSV(record, (char*)payload, SAMPLE_CSV_MAX_LENGTH);
+    if (len >= 0) {
+        payload[len++] = '\r';
+        payload[len++] = '\n';
+    }
+#endif
+    uint32_t encodeUs = micros() - encodeStart;
+    if (len <= 0) {
+        stats.droppedRecords++;
+        LOG_WARN("SD_LOGGER", "Registro no serializable - descartado");
+        return APPEND_INVALID;
+    }
+
+#if SD_LOG_JOURNAL
+    sealJournalFrame(frame, len, journalFileNumber, journalSequence);
+#endif
+    if (!append(frame, FRAME_HEADER_SIZE + len)) {
+        return APPEND_FULL;
+    }
+
+#if SD_LOG_JOURNAL
+    // Solo los frames que entraron consumen secuencia: sin huecos en el archivo
+    journalSequence++;
+#endif
+#if SD_LOG_COMPRESSED
+    // Igual con el estado delta: un registro descartado no puede ser la base del siguiente
+    memcpy(deltaPrevious, values, sizeof(values));
+    deltaSinceKeyFrame = (deltaSinceKeyFrame + 1) % SD_DELTA_KEYFRAME_INTERVAL;
+#endif
+    stats.encodedRecords++;
+    stats.encodedBytes += len;
+    stats.totalEncodeUs += encodeUs;
+    if (encodeUs > stats.maxEncodeUs) {
+        stats.maxEncodeUs = encodeUs;
+    }
+    recordsSinceFlush++;
+    return APPEND_OK;
+}
+
+// Guardar el registro sin formatear hasta que haya lugar en los buffers
+bool SDLogger::spoolRecord(const SampleRecord& record) {
+    if (spoolCount >= spoolCapacity) {
+        stats.droppedRecords++;
+        LOG_WARN("SD_LOGGER", spoolCapacity > 0 ? "Spool lleno - registro descartado"
+                                                : "Buffers de la SD llenos - registro descartado");
+        return false;
+    }
+
+    spool[(spoolHead + spoolCount) % spoolCapacity] = record;
+    spoolCount++;
+    stats.spooledRecords++;
+    if (spoolCount > stats.spoolHighWater) {
+        stats.spoolHighWater = spoolCount;
+    }
     return true;
 }
 
-void SDLogger::update() {
-    unsigned long currentTime = millis();
-    LOG_INFO("SD_LOGGER", "en update");
-    // Escribir en la SD a la frecuencia configurada
-    if (dataBuffer.length() > 0) {
-        // Abrir archivo en modo append
-        dataFile = SD.open(currentFilename, FILE_APPEND);
-        ;
-        if (!headerIsWritten){
-            // Escribir header
-            LOG_INFO("SD_LOGGER", "Archivo:  '" + currentFilename + "'  generado automcaticamente");
-            dataFile.println(dataHeader);
-            headerIsWritten = true;
-        }
-        if (dataFile) {
-            LOG_INFO("SD_LOGGER", "Escribiendo datos");
-            // Escribir todos los datos acumulados
-            dataFile.println(dataBuffer);
-            dataFile.flush();
+// Pasar registros del spool a los buffers mientras haya lugar. Como mucho
+// SD_SPOOL_DRAIN_BATCH por llamada: el productor no se demora con un spool
+// grande y la tarea tiene tiempo de escribir entre tanda y tanda
+void SDLogger::drainSpool() {
+    if (!streamStarted) {
+        return;
+    }
+
+    for (int i = 0; i < SD_SPOOL_DRAIN_BATCH && spoolCount > 0; i++) {
+        if (appendRecord(spool[spoolHead]) == APPEND_FULL) {
+            break;
+        }
+        // Uno no serializable también sale: reintentarlo no cambia nada
+        spoolHead = (spoolHead + 1) % spoolCapacity;
+        spoolCount--;
+    }
+}
+
+void SDLogger::requestFlush() {
+    flushRequested = true;
+    if (taskHandle != nullptr) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+void SDLogger::close() {
+    if (!sdInitialized) {
+        return;
+    }
+
+    // Lo que ya está en los buffers se escribe; lo que llegue después se rechaza
+    sdInitialized = false;
+    closeRequested = true;
+    xTaskNotifyGive(taskHandle);
+
+    unsigned long start = millis();
+    while (closeRequested && millis() - start < SD_CLOSE_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (closeRequested) {
+        LOG_ERROR("SD_LOGGER", "La tarea de escritura no cerró el archivo a tiempo");
+    }
+}
+
+bool SDLogger::startBenchmark(uint32_t bytes, SdBenchResult& result) {
+    if (!sdInitialized || !cardMounted || taskHandle == nullptr || benchRequested) {
+        return false;
+    }
+
+    // La tarea escribe en `result` hasta terminar y recién entonces baja
+    // benchRequested; quien pidió la prueba lo consulta sin esperar
+    result.reset();
+    benchResult = &result;
+    benchBytes = bytes;
+    benchRequested = true;
+    xTaskNotifyGive(taskHandle);
+    return true;
+}
+
+// Copiar al buffer activo. Si se llena pasa a la cola de la tarea y el resto
+// sigue en el siguiente buffer; si no hay buffer libre no se copia nada.
+bool SDLogger::append(const uint8_t* data, size_t length) {
+    if (length > SD_BATCH_BUFFER_SIZE) {
+        return false;
+    }
+
+    bool handedOff = false;
+
+    portENTER_CRITICAL(&lock);
+
+    WriteBuffer* active = &buffers[activeBuffer];
+    size_t space = SD_BATCH_BUFFER_SIZE - active->length;
+    if (length >= space && fullCount >= SD_BUFFER_COUNT - 1) {
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+
+    size_t first = length < space ? length : space;
+    memcpy(active->data + active->length, data, first);
+    active->length += first;
+
+    if (active->length == SD_BATCH_BUFFER_SIZE) {
+        // El siguiente en orden circular ya fue escrito y vaciado por la tarea
+        fullCount++;
+        activeBuffer = (activeBuffer + 1) % SD_BUFFER_COUNT;
+        active = &buffers[activeBuffer];
+        memcpy(active->data, data + first, length - first);
+        active->length = length - first;
+        handedOff = true;
+    }
+
+    uint32_t inUse = fullCount + (active->length > 0 ? 1 : 0);
+    if (inUse > stats.buffersHighWater) {
+        stats.buffersHighWater = inUse;
+    }
+    uint32_t pending = pendingBytesLocked();
+    if (pending > stats.pendingHighWater) {
+        stats.pendingHighWater = pending;
+    }
+
+    portEXIT_CRITICAL(&lock);
+
+    if (handedOff && taskHandle != nullptr) {
+        xTaskNotifyGive(taskHandle);
+    }
+    return true;
+}
+
+size_t SDLogger::pendingBytesLocked() const {
+    size_t pending = buffers[activeBuffer].length - buffers[activeBuffer].written;
+    for (int i = 0; i < fullCount; i++) {
+        const WriteBuffer& full = buffers[(writeIndex + i) % SD_BUFFER_COUNT];
+        pending += full.length - full.written;
+    }
+    return pending;
+}
+
+int SDLogger::getBuffersInUse() const {
+    portENTER_CRITICAL(&lock);
+    int inUse = fullCount + (buffers[activeBuffer].length > 0 ? 1 : 0);
+    portEXIT_CRITICAL(&lock);
+    return inUse;
+}
+
+size_t SDLogger::getPendingBytes() const {
+    portENTER_CRITICAL(&lock);
+    size_t pending = pendingBytesLocked();
+    portEXIT_CRITICAL(&lock);
+    return pending;
+}
+
+void SDLogger::writerTask(void* parameter) {
+    SDLogger* self = (SDLogger*)parameter;
+
+    for (;;) {
+        // Despierta al llenarse un buffer, al pedir flush o por tiempo
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SD_WRITER_POLL_MS));
+
+        bool cardReady = self->cardMounted || self->remountCard();
+        if (!cardReady) {
+            self->checkFlashFallback();
+        }
+
+        // Sin tarjeta el ciclo corre solo para la flash: el archivo en ella o
+        // el resto de uno de la SD que va a su .part
+        bool ok = cardReady;
+        if (cardReady || self->onFlash || self->nextOnFlash || self->discardStream) {
+            bool sdFile = !self->onFlash;
+            ok = self->writerCycle();
+            // Errores seguidos en la SD: tarjeta retirada o dañada, volver a montarla
+            if (ok || !sdFile) {
+                self->consecutiveErrors = 0;
+            } else if (self->cardMounted && ++self->consecutiveErrors >= SD_REMOUNT_AFTER_ERRORS) {
+                self->unmountCard();
+            }
+        } else if (self->closeRequested) {
+            // Sin tarjeta no hay archivo que cerrar
+            LOG_WARN("SD_LOGGER", "Cierre sin tarjeta: " + String(self->spoolCount) +
+                     " registros del spool sin escribir");
+            self->closeRequested = false;
+        }
+
+        // La prueba corre con los buffers ya escritos; lo que llegue mientras
+        // tanto espera en ellos
+        if (self->benchRequested) {
+            self->benchmarkCard(self->benchBytes, *self->benchResult);
+            self->benchRequested = false;
+        }
+
+        if (!ok || !cardReady) {
+            // Tarjeta ausente o con error: no reintentar en cada aviso. En la
+            // flash alcanza con los buffers para esperar el próximo intento
+            vTaskDelay(pdMS_TO_TICKS(SD_WRITER_RETRY_MS));
+        }
+    }
+}
+
+bool SDLogger::writerCycle() {
+    for (;;) {
+        // 1. Buffers llenos, del más antiguo al más nuevo
+        while (fullCount > 0) {
+            WriteBuffer& full = buffers[writeIndex];
+            if (full.startsNewFile && !rotateFile(full)) {
+                return false;
+            }
+            if (discardStream) {
+                spillBuffer(full.data + full.written, full.length - full.written);
+            } else if (!writeBuffer(full, full.length)) {
+                return false;   // Se reintenta en el próximo ciclo
+            }
+
+            full.length = 0;
+            full.written = 0;
+            full.startsNewFile = false;
+            portENTER_CRITICAL(&lock);
+            writeIndex = (writeIndex + 1) % SD_BUFFER_COUNT;
+            fullCount--;
+            portEXIT_CRITICAL(&lock);
+        }
+
+        // 2. Política de flush sobre el buffer activo
+        portENTER_CRITICAL(&lock);
+        bool caughtUp = fullCount == 0;
+        int index = activeBuffer;
+        size_t length = buffers[index].length;
+        portEXIT_CRITICAL(&lock);
+
+        if (!caughtUp) {
+            continue;           // Se llenó otro buffer: escribirlo antes para no desordenar
+        }
+
+        // ¿Toca flush? Solo si hay algo sin confirmar en la tarjeta
+        WriteBuffer& active = buffers[index];
+        bool dirty = length > active.written || unflushedBytes > 0;
+        // En la flash cada flush reescribe el bloque final y los metadatos de
+        // LittleFS: solo por tiempo, el resto va en buffers completos
+        bool periodic = onFlash ? millis() - lastFlushTime >= FLASH_LOG_FLUSH_INTERVAL_MS
+                                : recordsSinceFlush >= SD_FLUSH_RECORDS ||
+                                  millis() - lastFlushTime >= SD_FLUSH_INTERVAL_MS;
+        bool flushDue = dirty && (flushRequested || powerWarning || closeRequested || periodic);
+
+        if (flushDue && !(discardStream && !active.startsNewFile)) {
+            // Escribir lo cargado hasta ahora sin soltar el buffer: el productor
+            // sigue agregando detrás de `length` y al llenarse solo se escribe
+            // el resto, con lo que el flujo sigue alineado a sector
+            if (active.startsNewFile && !rotateFile(active)) {
+                return false;
+            }
+            if (length > active.written && !writeBuffer(active, length)) {
+                return false;
+            }
+            flushFile();
+        }
+
+        if (closeRequested) {
+            finalizeFile();
+            closeRequested = false;
+        } else {
+            checkRotation();
+            stampFilename();
+        }
+        return true;
+    }
+}
+
+bool SDLogger::writeBuffer(WriteBuffer& buffer, size_t length) {
+    if (!openFile()) {
+        return false;
+    }
+
+    size_t chunk = length - buffer.written;
+    unsigned long start = micros();
+    size_t written = dataFile.write(buffer.data + buffer.written, chunk);
+    uint32_t elapsed = micros() - start;
+
+    stats.writes++;
+    stats.bytesWritten += written;
+    stats.totalWriteUs += elapsed;
+    if (elapsed > stats.maxWriteUs) {
+        stats.maxWriteUs = elapsed;
+    }
+    stats.writeLatency.record(elapsed);
+    recordStall(elapsed);
+
+    fileOffset += written;
+    unflushedBytes += written;
+    buffer.written += written;
+
+    if (written != chunk) {
+        // Tarjeta retirada o llena: reabrir y seguir desde `written` en el próximo intento
+        stats.writeErrors++;
+        LOG_ERROR("SD_LOGGER", "Escritura incompleta: " + String(written) + "/" + String(chunk) + " bytes");
+        dataFile.close();
+        fileOpen = false;
+        return false;
+    }
+
+    LOG_DEBUG("SD_LOGGER", "Datos escritos: " + String(written) + " bytes");
+    return true;
+}
+
+bool SDLogger::openFile() {
+    if (fileOpen) {
+        return true;
+    }
+
+    // El archivo queda abierto: sin recorrer la FAT ni reescribir la
+    // entrada de directorio en cada registro
+    unsigned long start = micros();
+    if (allocatedSize > 0) {
+        // Preasignado: FILE_APPEND escribiría después del espacio reservado
+        dataFile = sdCard.open(currentFilename, "r+");
+        if (dataFile && !dataFile.seek(fileOffset)) {
             dataFile.close();
+        }
+    } else {
+        dataFile = logFs().open(currentFilename, FILE_APPEND);
+    }
+    uint32_t elapsed = micros() - start;
+    stats.openLatency.record(elapsed);
+    recordStall(elapsed);
+    if (!dataFile) {
+        stats.openFailures++;
+        LOG_ERROR("SD_LOGGER", "Error al abrir el archivo para escribir datos");
+        return false;
+    }
 
-            LOG_DEBUG("SD_LOGGER", "Datos escritos: " + String(dataBuffer.length()) + " caracteres");
-            
-            // Limpiar buffer
-            dataBuffer = "";
+    fileOpen = true;
+    if (allocatedSize == 0) {
+        if (fileOffset == 0) {
+            fileCreated = true;
+            LOG_INFO("SD_LOGGER", "Archivo:  '" + currentFilename + "'  generado automcaticamente");
+            startCheckpoint();
+        }
+        fileOffset = dataFile.size();
+    }
+    return true;
+}
+
+void SDLogger::flushFile() {
+    unsigned long start = micros();
+    dataFile.flush();
+    uint32_t elapsed = micros() - start;
+
+    stats.flushes++;
+    stats.totalFlushUs += elapsed;
+    if (elapsed > stats.maxFlushUs) {
+        stats.maxFlushUs = elapsed;
+    }
+    stats.flushLatency.record(elapsed);
+    recordStall(elapsed);
+
+    recordsSinceFlush = 0;
+    unflushedBytes = 0;
+    lastFlushTime = millis();
+    flushRequested = false;
+
+    // Tras el flush fileOffset cae en un límite de registro. En un archivo
+    // preasignado el tamaño ya no dice dónde terminan los datos, y en uno
+    // normal la última escritura puede quedar a medias: se guarda en NVS
+    // (espaciado para no desgastar la flash)
+    if (!onFlash && lastFlushTime - lastCheckpointTime >= SD_CHECKPOINT_INTERVAL_MS) {
+        nvs.putUInt("len", fileOffset);
+        lastCheckpointTime = lastFlushTime;
+    }
+}
+
+// Punto de control: si se corta la energía, el próximo arranque sabe qué
+// archivo recuperar y desde dónde buscar el final de los datos. Un
+// archivo en la flash no lo necesita (LittleFS no pierde lo confirmado) y
+// así NVS sigue apuntando al de la SD que haya quedado abierto
+void SDLogger::startCheckpoint() {
+    if (onFlash) {
+        return;
+    }
+    nvs.putString("file", currentFilename);
+    nvs.putUInt("len", 0);
+    nvs.putBool("open", true);
+    lastCheckpointTime = millis();
+}
+
+void SDLogger::finalizeFile() {
+    if (fileNumber == 0) {
+        return;         // Nunca hubo tarjeta: no hay archivo
+    }
+    if (fileOpen) {
+        dataFile.close();
+        fileOpen = false;
+    }
+
+    if (onFlash || !cardMounted) {
+        // Sin preasignación ni punto de control que cerrar; uno de la SD
+        // perdida se recupera al volver la tarjeta
+        LOG_INFO("SD_LOGGER", "Archivo '" + currentFilename + "' cerrado con " + String(fileOffset) + " bytes" +
+                 (onFlash ? " en la flash" : " (sin tarjeta)"));
+        return;
+    }
+
+    if (allocatedSize > fileOffset && !truncateFile(currentFilename, fileOffset)) {
+        LOG_ERROR("SD_LOGGER", "No se pudo truncar '" + currentFilename + "'");
+    } else {
+        nvs.putBool("open", false);
+    }
+    allocatedSize = 0;
+
+    LOG_INFO("SD_LOGGER", "Archivo '" + currentFilename + "' cerrado con " + String(fileOffset) + " bytes");
+}
+
+// ¿Superó el archivo actual el tamaño o la duración máxima? El corte lo
+// marca el productor en el próximo registro (en un límite de registro)
+void SDLogger::checkRotation() {
+    if (rotationState != ROTATION_NONE) {
+        return;
+    }
+
+    bool sizeLimit = SD_ROTATE_MAX_BYTES > 0 && fileOffset >= SD_ROTATE_MAX_BYTES;
+    bool timeLimit = SD_ROTATE_INTERVAL_MIN > 0 &&
+                     millis() - fileStartTime >= SD_ROTATE_INTERVAL_MIN * 60000UL;
+    if (sizeLimit || timeLimit) {
+        // El número se reserva ya: el productor lo necesita para los frames
+        nextFileNumber = reserveFileNumber();
+        nextOnFlash = onFlash;
+        rotationState = ROTATION_DUE;
+    }
+}
+
+// Cerrar el archivo actual y abrir el siguiente antes de escribir `first`
+bool SDLogger::rotateFile(WriteBuffer& first) {
+    bool firstFile = fileNumber == 0;
+    if (!firstFile) {
+        if (fileOpen && unflushedBytes > 0) {
+            flushFile();
+        }
+        finalizeFile();
+        stats.rotations++;
+    }
+    if (spillFile) {
+        spillFile.close();
+    }
+
+    fileNumber = nextFileNumber;
+    onFlash = nextOnFlash;
+    fileCreated = false;
+    discardStream = false;
+    fileStartUs = esp_timer_get_time();
+    currentFilename = logFilename(fileNumber);
+    fileOffset = 0;
+    unflushedBytes = 0;
+    fileStartTime = millis();
+    if (!onFlash && preallocateBytes > 0 && !createPreallocated()) {
+        LOG_WARN("SD_LOGGER", "Sin preasignación: el archivo crecerá cluster a cluster");
+    }
+
+    first.startsNewFile = false;
+    rotationState = ROTATION_NONE;
+    LOG_INFO("SD_LOGGER", (firstFile ? "Archivo inicial '" : "Rotación a '") + currentFilename +
+             (onFlash ? "' en la flash interna" : "'"));
+    return true;
+}
+
+// Escrituras de un buffer completo seguidas de flush en un archivo nuevo:
+// incluye la asignación de clusters de FatFs, como un log sin preasignar
+void SDLogger::benchmarkCard(uint32_t bytes, SdBenchResult& result) {
+    // Memoria interna para que el bus haga DMA igual que con los buffers del log
+    uint8_t* block = (uint8_t*)malloc(SD_BATCH_BUFFER_SIZE);
+    if (block == nullptr) {
+        LOG_ERROR("SD_LOGGER", "Sin memoria para la prueba de la SD");
+        return;
+    }
+    for (size_t i = 0; i < SD_BATCH_BUFFER_SIZE; i++) {
+        block[i] = (uint8_t)i;
+    }
+
+    unsigned long start = micros();
+    unsigned long opStart = start;
+    File file = sdCard.open(SD_BENCH_FILENAME, FILE_WRITE);
+    result.openLatency.record(micros() - opStart);
+
+    if (file) {
+        result.ok = true;
+        while (result.bytes < bytes) {
+            size_t chunk = bytes - result.bytes < SD_BATCH_BUFFER_SIZE ? bytes - result.bytes : SD_BATCH_BUFFER_SIZE;
+
+            opStart = micros();
+            size_t written = file.write(block, chunk);
+            result.writeLatency.record(micros() - opStart);
+            result.bytes += written;
+            if (written != chunk) {
+                result.ok = false;
+                break;
+            }
+
+            opStart = micros();
+            file.flush();
+            result.flushLatency.record(micros() - opStart);
+        }
+        file.close();
+    }
+    result.elapsedUs = micros() - start;
+
+    sdCard.remove(SD_BENCH_FILENAME);
+    free(block);
+    LOG_INFO("SD_LOGGER", "Prueba de la SD: " + String(result.bytes) + " bytes a " +
+             String(result.kbPerSecond()) + " KB/s" + (result.ok ? "" : " (con errores)"));
+}
+
+void SDLogger::recordStall(uint32_t elapsed) {
+    if (elapsed > stats.maxStallUs) {
+        stats.maxStallUs = elapsed;
+    }
+}
+
+void SDLogger::resetStats() {
+    stats.reset();
+    statsStartTime = millis();
+}
+
+uint32_t SDLogger::getLogBytesPerSecond() const {
+    unsigned long elapsed = millis() - statsStartTime;
+    return elapsed > 0 ? (uint32_t)((uint64_t)stats.encodedBytes * 1000 / elapsed) : 0;
+}
+
+void SDLogger::showStats() const {
+    uint32_t avgWrite = stats.writes > 0 ? stats.totalWriteUs / stats.writes : 0;
+    uint32_t avgFlush = stats.flushes > 0 ? stats.totalFlushUs / stats.flushes : 0;
+
+    LOG_INFO("SD_LOGGER", "Escrituras: " + String(stats.writes) + " (" + String(stats.bytesWritten) +
+             " bytes), prom " + String(avgWrite) + " µs, máx " + String(stats.maxWriteUs) + " µs");
+    LOG_INFO("SD_LOGGER", "Flush: " + String(stats.flushes) + ", prom " + String(avgFlush) +
+             " µs, máx " + String(stats.maxFlushUs) + " µs" + (powerWarning ? " [aviso de energía]" : ""));
+    LOG_INFO("SD_LOGGER", "Buffers: " + String(getBuffersInUse()) + "/" + String(SD_BUFFER_COUNT) +
+             " (máx " + String(stats.buffersHighWater) + "), pendiente: " + String(getPendingBytes()) +
+             " bytes (máx " + String(stats.pendingHighWater) + "), sin flush: " + String(unflushedBytes) + " bytes");
+    uint32_t avgEncode = stats.encodedRecords > 0 ? stats.totalEncodeUs / stats.encodedRecords : 0;
+    uint32_t avgRecord = stats.encodedRecords > 0 ? stats.encodedBytes / stats.encodedRecords : 0;
+    LOG_INFO("SD_LOGGER", "Registros: " + String(stats.encodedRecords) + ", prom " + String(avgRecord) +
+             " bytes, codificación prom " + String(avgEncode) + " µs, máx " + String(stats.maxEncodeUs) + " µs");
+    LOG_INFO("SD_LOGGER", "Latencia apertura: " + stats.openLatency.toString());
+    LOG_INFO("SD_LOGGER", "Latencia escritura: " + stats.writeLatency.toString());
+    LOG_INFO("SD_LOGGER", "Latencia flush: " + stats.flushLatency.toString());
+    LOG_INFO("SD_LOGGER", "Archivo: " + currentFilename + ", rotaciones: " + String(stats.rotations));
+    if (allocatedSize > 0) {
+        LOG_INFO("SD_LOGGER", "Archivo preasignado: " + String(fileOffset) + "/" + String(allocatedSize) + " bytes usados");
+    }
+    LOG_INFO("SD_LOGGER", "Tarjeta " + String(cardMounted ? "montada" : "AUSENTE") + ", montajes: " +
+             String(stats.remounts) + ", spool: " + String(spoolCount) + "/" + String(spoolCapacity) +
+             " (máx " + String(stats.spoolHighWater) + ")");
+    if (flashMounted) {
+        LOG_INFO("SD_LOGGER", "Flash: " + String(onFlash ? "registrando" : "en espera") + ", " +
+                 String(getFlashUsedBytes() / 1024) + "/" + String(getFlashTotalBytes() / 1024) + " KB, pasos: " +
+                 String(stats.flashFallbacks) + ", .part: " + String(stats.spilledBytes) + " bytes");
+    }
+    LOG_INFO("SD_LOGGER", "Bloqueo máx de la SD: " + String(stats.maxStallUs) + " µs, errores apertura/escritura: " +
+             String(stats.openFailures) + "/" + String(stats.writeErrors) +
+             ", descartados: " + String(stats.droppedRecords));
+}
+
+// ====================== FLASH INTERNA ======================
+size_t SDLogger::getFlashUsedBytes() const {
+#if SD_FLASH_FALLBACK
+    if (flashMounted) {
+        return LittleFS.usedBytes();
+    }
+#endif
+    return 0;
+}
+
+size_t SDLogger::getFlashTotalBytes() const {
+#if SD_FLASH_FALLBACK
+    if (flashMounted) {
+        return LittleFS.totalBytes();
+    }
+#endif
+    return 0;
+}
+
+void SDLogger::listFlashFiles(Print& out) const {
+#if SD_FLASH_FALLBACK
+    if (!flashMounted) {
+        out.println("Flash interna no montada");
+        return;
+    }
+
+    File root = LittleFS.open("/");
+    File file = root ? root.openNextFile() : File();
+    int count = 0;
+    while (file) {
+        String name = String("/") + file.name();
+        bool active = onFlash && name == currentFilename;
+        out.println("  " + name + "  " + String((uint32_t)file.size()) + " bytes" + (active ? "  [activo]" : ""));
+        count++;
+        file = root.openNextFile();
+    }
+    root.close();
+    out.println(String(count) + " archivos, " + String(getFlashUsedBytes() / 1024) + "/" +
+                String(getFlashTotalBytes() / 1024) + " KB usados");
+#else
+    out.println("Respaldo en la flash deshabilitado (SD_FLASH_FALLBACK=0)");
+#endif
+}
+
+// Contenido crudo entre una línea de inicio y una de fin con el largo y el
+// CRC-32, para separarlo del resto de la consola y validarlo en la PC
+bool SDLogger::dumpFlashFile(const String& name, Print& out) const {
+#if SD_FLASH_FALLBACK
+    String path = name.startsWith("/") ? name : "/" + name;
+    File file = flashMounted ? LittleFS.open(path, FILE_READ) : File();
+    if (!file || file.isDirectory()) {
+        return false;
+    }
+
+    uint8_t chunk[FLASH_DUMP_CHUNK];
+    uint32_t sent = 0;
+    uint32_t crc = 0;
+    out.println("=== INICIO " + path + " " + String((uint32_t)file.size()) + " bytes ===");
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+        out.write(chunk, n);
+        crc = crc32Update(crc, chunk, n);
+        sent += n;
+    }
+    file.close();
+
+    char trailer[64];
+    snprintf(trailer, sizeof(trailer), "\r\n=== FIN %lu bytes CRC32 %08lx ===",
+             (unsigned long)sent, (unsigned long)crc);
+    out.println(trailer);
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t SDLogger::dumpFlashFiles(Print& out) const {
+    uint32_t sent = 0;
+#if SD_FLASH_FALLBACK
+    if (!flashMounted) {
+        return 0;
+    }
+
+    File root = LittleFS.open("/");
+    File file = root ? root.openNextFile() : File();
+    while (file) {
+        String name = String("/") + file.name();
+        file.close();
+        if (dumpFlashFile(name, out)) {
+            sent++;
+        }
+        file = root.openNextFile();
+    }
+    root.close();
+#endif
+    return sent;
+}
+
+uint32_t SDLogger::removeFlashFiles() {
+    uint32_t removed = 0;
+#if SD_FLASH_FALLBACK
+    if (!flashMounted) {
+        return 0;
+    }
+
+    // Primero los nombres, de a tandas: borrar mientras se recorre el
+    // directorio salta entradas. Se conservan el activo y su .part
+    String names[16];
+    int count;
+    uint32_t batch;
+    do {
+        count = 0;
+        batch = 0;
+        File root = LittleFS.open("/");
+        File file = root ? root.openNextFile() : File();
+        while (file && count < 16) {
+            String name = String("/") + file.name();
+            if (!(name == currentFilename || name == currentFilename + ".part")) {
+                names[count++] = name;
+            }
+            file = root.openNextFile();
+        }
+        root.close();
+
+        for (int i = 0; i < count; i++) {
+            if (LittleFS.remove(names[i])) {
+                batch++;
+            }
+        }
+        removed += batch;
+    } while (count == 16 && batch == 16);
+#endif
+    return removed;
+}
+
+// ====================== RECUPERACIÓN ======================
+// Un archivo preasignado que no se cerró mide lo reservado y después de los
+// datos tiene lo que hubiera antes en esos clusters; uno sin preasignar puede
+// terminar en un registro escrito a medias. Los datos se buscan desde el
+// último punto de control: siguen registros válidos (formato o CRC) con
+// timestamps crecientes y sin saltos grandes (o frames consecutivos del
+// journal); el primero que no cumple marca el final real.
+void SDLogger::recoverPreviousFile() {
+    if (!nvs.getBool("open", false)) {
+        return;
+    }
+
+    String name = nvs.getString("file", "");
+    uint32_t committed = nvs.getUInt("len", 0);
+
+    File file = sdCard.open(name, FILE_READ);
+    if (!file) {
+        LOG_WARN("SD_LOGGER", "No se encontró '" + name + "' para recuperar");
+        nvs.putBool("open", false);
+        return;
+    }
+
+    // "/log_NNNNNN.ext"
+    uint32_t number = strtoul(name.c_str() + 5, nullptr, 10);
+    uint32_t size = file.size();
+    uint32_t end = findDataEnd(file, committed, number);
+    file.close();
+
+    if (end < size && !truncateFile(name, end)) {
+        LOG_ERROR("SD_LOGGER", "No se pudo truncar '" + name + "' a " + String(end) + " bytes");
+        return;
+    }
+
+    LOG_WARN("SD_LOGGER", "Recuperado '" + name + "' tras corte de energía: " + String(end) + " bytes de datos (" +
+             String(end - committed) + " después del último punto de control), " + String(size - end) + " liberados");
+    nvs.putBool("open", false);
+}
+
+#if SD_LOG_JOURNAL
+// Frame íntegro del archivo `number` en offset; devuelve su tamaño o 0
+static size_t readFrameAt(File& file, uint32_t offset, uint32_t number, JournalFrameHeader& header) {
+    // Estático: no cabe cómodo en la pila de la tarea que arranca
+    static uint8_t frame[sizeof(JournalFrameHeader) + JOURNAL_MAX_PAYLOAD];
+
+    if (!file.seek(offset) || file.read(frame, sizeof(JournalFrameHeader)) != sizeof(JournalFrameHeader)) {
+        return 0;
+    }
+    memcpy(&header, frame, sizeof(header));
+    if (header.length > JOURNAL_MAX_PAYLOAD ||
+        file.read(frame + sizeof(header), header.length) != header.length) {
+        return 0;
+    }
+
+    size_t size = checkJournalFrame(frame, journalFrameSize(header.length), header);
+    return header.fileNumber == number ? size : 0;
+}
+#elif SD_LOG_BINARY
+// Fin del header binario, o 0 si está incompleto
+static uint32_t skipLogHeader(File& file) {
+    BinaryLogHeader header;
+    file.seek(0);
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0) {
+        return 0;
+    }
+    return header.headerSize;
+}
+
+#if SD_LOG_COMPRESSED
+// Registro comprimido íntegro en offset. En un key frame timestamp es el
+// absoluto; en un registro delta, la diferencia con el anterior
+static bool readDeltaAt(File& file, uint32_t offset, int64_t& timestamp, bool& keyFrame, size_t& recordSize) {
+    uint8_t raw[DELTA_RECORD_MAX_SIZE(SAMPLE_CSV_FIELD_COUNT)];
+    int64_t values[SAMPLE_CSV_FIELD_COUNT];
+
+    if (!file.seek(offset)) {
+        return false;
+    }
+    size_t n = file.read(raw, sizeof(raw));
+    recordSize = decodeDeltaRecord(raw, n, SAMPLE_CSV_FIELD_COUNT, nullptr, values, keyFrame);
+    timestamp = values[0];
+    return recordSize > 0;
+}
+#else
+// Registro con CRC válido en offset
+static bool readRecordAt(File& file, uint32_t offset, uint32_t& timestamp, size_t& recordSize) {
+    uint8_t raw[SAMPLE_CSV_MAX_LENGTH];
+    SampleRecord record;
+
+    recordSize = binaryRecordSize();
+    if (recordSize > sizeof(raw) || !file.seek(offset) ||
+        file.read(raw, recordSize) != recordSize || !decodeBinaryRecord(raw, record)) {
+        return false;
+    }
+    timestamp = record.timestampMs;
+    return true;
+}
+
+// Timestamp del registro que termina en offset
+static bool readTimestampBefore(File& file, uint32_t offset, uint32_t& timestamp) {
+    size_t recordSize;
+    if (offset < binaryHeaderSize() + binaryRecordSize()) {
+        return false;
+    }
+    return readRecordAt(file, offset - binaryRecordSize(), timestamp, recordSize);
+}
+#endif
+#else
+// Largo de la línea en buffer (sin "\r\n"), o -1 si no termina dentro de n
+static int lineLength(const char* buffer, size_t n) {
+    for (size_t i = 0; i + 1 < n; i++) {
+        if (buffer[i] == '\r' && buffer[i + 1] == '\n') {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Fin de la línea de header, o 0 si está incompleta
+static uint32_t skipLogHeader(File& file) {
+    char line[SAMPLE_CSV_MAX_LENGTH + 2];
+    file.seek(0);
+    size_t n = file.read((uint8_t*)line, sizeof(line));
+    int length = lineLength(line, n);
+    if (length < 0 || strncmp(line, "Timestamp,", 10) != 0) {
+        return 0;
+    }
+    return length + 2;
+}
+
+// Fila CSV válida en offset
+static bool readRecordAt(File& file, uint32_t offset, uint32_t& timestamp, size_t& recordSize) {
+    char line[SAMPLE_CSV_MAX_LENGTH + 2];
+    if (!file.seek(offset)) {
+        return false;
+    }
+    size_t n = file.read((uint8_t*)line, sizeof(line));
+    int length = lineLength(line, n);
+    if (length < 0 || !parseRecordCSVTimestamp(line, length, timestamp)) {
+        return false;
+    }
+    recordSize = length + 2;
+    return true;
+}
+
+// Timestamp de la fila que termina en offset
+static bool readTimestampBefore(File& file, uint32_t offset, uint32_t& timestamp) {
+    char line[SAMPLE_CSV_MAX_LENGTH + 2];
+    size_t back = offset < sizeof(line) ? offset : sizeof(line);
+    if (back < 2 || !file.seek(offset - back) || file.read((uint8_t*)line, back) != back ||
+        line[back - 1] != '\n') {
+        return false;
+    }
+
+    size_t lineStart = back - 2;
+    while (lineStart > 0 && line[lineStart - 1] != '\n') {
+        lineStart--;
+    }
+    return parseRecordCSVTimestamp(line + lineStart, back - 2 - lineStart, timestamp);
+}
+#endif
+
+#if SD_LOG_JOURNAL
+// Con journal el final es el último frame íntegro del mismo archivo con
+// secuencia consecutiva: un frame cortado falla el CRC y los datos viejos de
+// los clusters preasignados llevan otro número de archivo
+uint32_t SDLogger::findDataEnd(File& file, uint32_t start, uint32_t number) {
+    JournalFrameHeader header;
+    uint32_t end = start;
+    uint32_t expected = 0;
+    bool haveExpected = false;
+
+    if (start == 0) {
+        // Sin punto de control: el frame 0 es el header del archivo
+        size_t size = readFrameAt(file, 0, number, header);
+        if (size == 0 || header.sequence != 0) {
+            return 0;
+        }
+        end = size;
+        expected = 1;
+        haveExpected = true;
+    }
+
+    size_t size;
+    while ((size = readFrameAt(file, end, number, header)) > 0) {
+        // El punto de control cae en un límite de frame: su secuencia es la referencia
+        if (haveExpected && header.sequence != expected) {
+            break;
+        }
+        expected = header.sequence + 1;
+        haveExpected = true;
+        end += size;
+    }
+
+    return end;
+}
+#elif SD_LOG_COMPRESSED
+// Los registros comprimidos no se pueden leer hacia atrás: desde el punto de
+// control se valida el CRC y que el timestamp avance (el delta del primer
+// campo, o el absoluto de cada key frame)
+uint32_t SDLogger::findDataEnd(File& file, uint32_t start, uint32_t number) {
+    uint32_t end = start > 0 ? start : skipLogHeader(file);
+    if (end == 0) {
+        return 0;
+    }
+
+    int64_t previous = 0;
+    bool havePrevious = false;
+    int64_t timestamp;
+    bool keyFrame;
+    size_t recordSize;
+    while (readDeltaAt(file, end, timestamp, keyFrame, recordSize)) {
+        int64_t step = keyFrame ? timestamp - previous : timestamp;
+        if ((!keyFrame || havePrevious) && (step < 0 || step > SD_RECOVERY_MAX_GAP_MS)) {
+            break;
+        }
+        if (keyFrame) {
+            previous = timestamp;
+            havePrevious = true;
         } else {
-            LOG_ERROR("SD_LOGGER", "Error al abrir el archivo para escribir datos");
+            previous += timestamp;
         }
-        
-        lastWriteTime = currentTime;
+        end += recordSize;
     }
-}
\ No newline at end of file
+
+    return end;
+}
+#else
+uint32_t SDLogger::findDataEnd(File& file, uint32_t start, uint32_t number) {
+    uint32_t end = start;
+    uint32_t previous = 0;
+    bool havePrevious = false;
+
+    if (start == 0) {
+        // Sin punto de control: empezar después del header
+        end = skipLogHeader(file);
+        if (end == 0) {
+            return 0;
+        }
+    } else {
+        havePrevious = readTimestampBefore(file, start, previous);
+    }
+
+    uint32_t timestamp;
+    size_t recordSize;
+    while (readRecordAt(file, end, timestamp, recordSize)) {
+        if (havePrevious && (timestamp < previous || timestamp - previous > SD_RECOVERY_MAX_GAP_MS)) {
+            break;
+        }
+        previous = timestamp;
+        havePrevious = true;
+        end += recordSize;
+    }
+
+    return end;
+}
+#endif
+
+bool SDLogger::truncateFile(const String& name, uint32_t length) {
+    // Ni File ni SDFS exponen truncate: se usa la ruta VFS de FatFs
+    String path = String(SD_MOUNT_POINT) + name;
+    return truncate(path.c_str(), length) == 0;
+}
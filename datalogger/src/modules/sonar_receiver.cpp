@@ -2,6 +2,7 @@
 #include "logger.h"
 
 SonarReceiver::SonarReceiver() {
+    portMUX_INITIALIZE(&dataLock_);
     wroomSerial = nullptr;
     connected_ = false;
     lastDataTime_ = 0;
@@ -10,6 +11,7 @@ SonarReceiver::SonarReceiver() {
     totalPacketsReceived_ = 0;
     validPacketsReceived_ = 0;
     errorPacketsReceived_ = 0;
+    rxStats_.reset();
     
     inputBuffer_ = "";
     
@@ -19,13 +21,27 @@ SonarReceiver::SonarReceiver() {
 bool SonarReceiver::begin() {
     // Configurar UART para recibir datos del ESP-WROOM
     wroomSerial = &Serial2;  // Usar UART1 del ESP32-S3
+    wroomSerial->setRxBufferSize(WROOM_RX_BUFFER_SIZE);  // Antes de begin()
     wroomSerial->begin(WROOM_BAUD_RATE, SERIAL_8N1, WROOM_UART_RX_PIN, WROOM_UART_TX_PIN);
     wroomSerial->setTimeout(100);
+
+    // Errores de la cola de eventos UART (overflow, framing, paridad)
+    wroomSerial->onReceiveError([this](hardwareSerial_error_t error) {
+        rxStats_.recordError(error);
+    });
+
+#if UART_EVENT_DRAIN
+    // La tarea de eventos UART entrega los bytes al parser en cuanto llegan
+    wroomSerial->onReceive([this]() {
+        processIncomingData();
+    });
+#endif
     
     LOG_INFO("SONAR_RX", "Receptor inicializado:");
     LOG_INFO("SONAR_RX", "  Puerto: UART1");
     LOG_INFO("SONAR_RX", "  RX Pin: GPIO" + String(WROOM_UART_RX_PIN));
     LOG_INFO("SONAR_RX", "  Baudios: " + String(WROOM_BAUD_RATE));
+    LOG_INFO("SONAR_RX", "  Buffer RX: " + String(WROOM_RX_BUFFER_SIZE) + " bytes");
     LOG_INFO("SONAR_RX", "  Timeout conexión: " + String(connectionTimeout_) + "ms");
     
     LOG_INFO("SONAR_RX", "Esperando datos del ESP-WROOM...");
@@ -34,7 +50,9 @@ bool SonarReceiver::begin() {
 }
 
 void SonarReceiver::update() {
+#if !UART_EVENT_DRAIN
     processIncomingData();
+#endif
     updateConnectionStatus();
 }
 
@@ -43,9 +61,12 @@ void SonarReceiver::processIncomingData() {
         return;
     }
     
+    rxStats_.recordPending(wroomSerial->available());
+
     // Leer datos disponibles
     while (wroomSerial->available()) {
         char c = wroomSerial->read();
+        rxStats_.bytesReceived++;
         
         if (c == '\n' || c == '\r') {
             // Fin de línea - procesar packet
@@ -56,8 +77,10 @@ void SonarReceiver::processIncomingData() {
                 
                 if (parsePacket(inputBuffer_)) {
                     validPacketsReceived_++;
+                    portENTER_CRITICAL(&dataLock_);
                     lastDataTime_ = millis();
                     connected_ = true;
+                    portEXIT_CRITICAL(&dataLock_);
                     LOG_DEBUG("SONAR_RX", "Packet válido procesado");
                 } else {
                     errorPacketsReceived_++;
@@ -119,23 +142,29 @@ bool SonarReceiver::parsePacket(const String& packet) {
         return false;
     }
     
-    // Parsear campos
+    // Parsear campos en una copia y publicarla entera: los lectores nunca
+    // ven la profundidad de un packet con la temperatura del anterior
     try {
-        currentData_.timestamp = strtoul(fields[0].c_str(), nullptr, 10);
-        currentData_.depth = parseDoubleValue(fields[1]);
-        currentData_.offset = parseDoubleValue(fields[2]);
-        currentData_.range = parseDoubleValue(fields[3]);
-        currentData_.totalLog = parseUInt32Value(fields[4]);
-        currentData_.tripLog = parseUInt32Value(fields[5]);
-        currentData_.temperature = parseFloatValue(fields[6]);
-        currentData_.valid = (fields[7].toInt() == 1);
-        currentData_.sampleCount = fields[8].toInt();
-        currentData_.receivedTime = millis();
+        SonarData parsed;
+        parsed.timestamp = strtoul(fields[0].c_str(), nullptr, 10);
+        parsed.depth = parseDoubleValue(fields[1]);
+        parsed.offset = parseDoubleValue(fields[2]);
+        parsed.range = parseDoubleValue(fields[3]);
+        parsed.totalLog = parseUInt32Value(fields[4]);
+        parsed.tripLog = parseUInt32Value(fields[5]);
+        parsed.temperature = parseFloatValue(fields[6]);
+        parsed.valid = (fields[7].toInt() == 1);
+        parsed.sampleCount = fields[8].toInt();
+        parsed.receivedTime = millis();
+
+        portENTER_CRITICAL(&dataLock_);
+        currentData_ = parsed;
+        portEXIT_CRITICAL(&dataLock_);
         
         LOG_INFO("SONAR_RX", "Datos actualizados - Depth: " + 
-                 String(isnan(currentData_.depth) ? 0 : currentData_.depth, 2) + 
-                 "m, Temp_agua: " + String(isnan(currentData_.temperature) ? 0 : currentData_.temperature, 1) + 
-                 "°C, Samples: " + String(currentData_.sampleCount)); 
+                 String(isnan(parsed.depth) ? 0 : parsed.depth, 2) + 
+                 "m, Temp_agua: " + String(isnan(parsed.temperature) ? 0 : parsed.temperature, 1) + 
+                 "°C, Samples: " + String(parsed.sampleCount)); 
         
         return true;
         
@@ -149,13 +178,17 @@ void SonarReceiver::updateConnectionStatus() {
     unsigned long currentTime = millis();
     
     // Verificar timeout de conexión
-    if (lastDataTime_ > 0 && (currentTime - lastDataTime_ > connectionTimeout_)) {
-        if (connected_) {
-            connected_ = false;
-            LOG_WARN("SONAR_RX", "Conexión perdida - timeout de " + 
-                     String(connectionTimeout_) + "ms");
-            resetData();
-        }
+    portENTER_CRITICAL(&dataLock_);
+    bool timedOut = connected_ && lastDataTime_ > 0 && (currentTime - lastDataTime_ > connectionTimeout_);
+    if (timedOut) {
+        connected_ = false;
+        resetData();
+    }
+    portEXIT_CRITICAL(&dataLock_);
+
+    if (timedOut) {
+        LOG_WARN("SONAR_RX", "Conexión perdida - timeout de " + 
+                 String(connectionTimeout_) + "ms");
     }
     
     // Log estadísticas periódicamente
@@ -203,6 +236,7 @@ float SonarReceiver::parseFloatValue(const String& value) {
     return value.toFloat();
 }
 
+// Con dataLock_ tomado (o antes de begin())
 void SonarReceiver::resetData() {
     currentData_.depth = NAN;
     currentData_.offset = NAN;
@@ -216,17 +250,31 @@ void SonarReceiver::resetData() {
     currentData_.receivedTime = 0;
 }
 
+bool SonarReceiver::snapshot(SonarData& data) const {
+    portENTER_CRITICAL(&dataLock_);
+    data = currentData_;
+    bool valid = connected_ && currentData_.valid;
+    portEXIT_CRITICAL(&dataLock_);
+    return valid;
+}
+
 // Getters
 double SonarReceiver::getDepth() const {
-    return currentData_.depth;
+    SonarData data;
+    snapshot(data);
+    return data.depth;
 }
 
 double SonarReceiver::getOffset() const {
-    return currentData_.offset;
+    SonarData data;
+    snapshot(data);
+    return data.offset;
 }
 
 double SonarReceiver::getRange() const {
-    return currentData_.range;
+    SonarData data;
+    snapshot(data);
+    return data.range;
 }
 
 uint32_t SonarReceiver::getTotalLog() const {
@@ -242,7 +290,8 @@ float SonarReceiver::getTemperature() const {
 }
 
 bool SonarReceiver::hasValidData() const {
-    return connected_ && currentData_.valid;
+    SonarData data;
+    return snapshot(data);
 }
 
 bool SonarReceiver::isConnected() const {
@@ -278,17 +327,19 @@ String SonarReceiver::getCSVHeader() const {
 }
 
 String SonarReceiver::getCSVData() const {
+    SonarData sample;
+    bool valid = snapshot(sample);
     String data = "";
     
-    if (hasValidData()) {
-        data += String(isnan(currentData_.depth) ? 0 : currentData_.depth, 3) + ",";
-        // data += String(isnan(currentData_.offset) ? 0 : currentData_.offset, 3) + ",";
-        // data += String(isnan(currentData_.range) ? 0 : currentData_.range, 3) + ",";
-        // data += String(currentData_.totalLog) + ",";
-        // data += String(currentData_.tripLog) + ",";
-        // data += String(currentData_.sampleCount) + ",";
-        data += String(isnan(currentData_.temperature) ? 0 : currentData_.temperature, 1) + ",";
-        data += String(currentData_.valid ? 1 : 0);
+    if (valid) {
+        data += String(isnan(sample.depth) ? 0 : sample.depth, 3) + ",";
+        // data += String(isnan(sample.offset) ? 0 : sample.offset, 3) + ",";
+        // data += String(isnan(sample.range) ? 0 : sample.range, 3) + ",";
+        // data += String(sample.totalLog) + ",";
+        // data += String(sample.tripLog) + ",";
+        // data += String(sample.sampleCount) + ",";
+        data += String(isnan(sample.temperature) ? 0 : sample.temperature, 1) + ",";
+        data += String(sample.valid ? 1 : 0);
     } else {
         data += "NaN,NaN,0";
     }
@@ -296,28 +347,38 @@ String SonarReceiver::getCSVData() const {
     return data;
 }
 
+void SonarReceiver::fillRecord(SampleRecord& record) const {
+    SonarData sample;
+    record.sonarValid = snapshot(sample) ? 1 : 0;
+    record.sonarDepth = sample.depth;
+    record.waterTemperature = sample.temperature;
+}
+
 void SonarReceiver::showStatus() const {
+    SonarData sample;
+    bool valid = snapshot(sample);
+
     LOG_INFO("SONAR_RX", "============ ESTADO DEL SONAR ============");
     LOG_INFO("SONAR_RX", "Conectado: " + String(connected_ ? "Sí" : "No"));
     
-    if (hasValidData()) {
+    if (valid) {
         LOG_INFO("SONAR_RX", "  DATOS VÁLIDOS:"
         );
-        if (!isnan(currentData_.depth)) {
-            LOG_INFO("SONAR_RX", "  Profundidad: " + String(currentData_.depth, 2) + " m");
+        if (!isnan(sample.depth)) {
+            LOG_INFO("SONAR_RX", "  Profundidad: " + String(sample.depth, 2) + " m");
         }
-        if (!isnan(currentData_.offset)) {
-            LOG_INFO("SONAR_RX", "  Offset: " + String(currentData_.offset, 2) + " m");
+        if (!isnan(sample.offset)) {
+            LOG_INFO("SONAR_RX", "  Offset: " + String(sample.offset, 2) + " m");
         }
-        if (!isnan(currentData_.range)) {
-            LOG_INFO("SONAR_RX", "  Rango: " + String(currentData_.range, 2) + " m");
+        if (!isnan(sample.range)) {
+            LOG_INFO("SONAR_RX", "  Rango: " + String(sample.range, 2) + " m");
         }
-        if (!isnan(currentData_.temperature)) {
-            LOG_INFO("SONAR_RX", "  Temperatura agua: " + String(currentData_.temperature, 1) + " °C");
+        if (!isnan(sample.temperature)) {
+            LOG_INFO("SONAR_RX", "  Temperatura agua: " + String(sample.temperature, 1) + " °C");
         }
-        LOG_INFO("SONAR_RX", "  Muestras promediadas: " + String(currentData_.sampleCount));
+        LOG_INFO("SONAR_RX", "  Muestras promediadas: " + String(sample.sampleCount));
         
-        unsigned long dataAge = millis() - currentData_.receivedTime;
+        unsigned long dataAge = millis() - sample.receivedTime;
         LOG_INFO("SONAR_RX", "  Edad del dato: " + String(dataAge) + " ms");
     } else {
         LOG_WARN("SONAR_RX", "  Sin datos válidos");
@@ -0,0 +1,164 @@
+#include "modules/time_sync.h"
+#include "logger.h"
+
+TimeSync::TimeSync() {
+    synced = false;
+    next = 0;
+    count = 0;
+    slot.localUsec = 0;
+    slot.offsetUsec = 0;
+    slotStartUsec = 0;
+    baseOffset = 0;
+    outliers = 0;
+    anchorUsec = 0;
+    intercept = 0.0;
+    slope = 0.0;
+    references = 0;
+    resets = 0;
+    lastErrorUs = 0;
+    lastReferenceUsec = 0;
+    portMUX_INITIALIZE(&lock);
+}
+
+void TimeSync::addReference(uint64_t utcUsec, int64_t localUsec) {
+    portENTER_CRITICAL(&lock);
+
+    references++;
+    lastReferenceUsec = localUsec;
+
+    if (!synced) {
+        restart(utcUsec, localUsec);
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+
+    int64_t offset = (int64_t)utcUsec - localUsec;
+    int64_t error = offset - offsetAt(localUsec);
+    lastErrorUs = error > INT32_MAX ? INT32_MAX : (error < INT32_MIN ? INT32_MIN : (int32_t)error);
+
+    if (error > TIME_SYNC_STEP_US || error < -TIME_SYNC_STEP_US) {
+        if (++outliers < TIME_SYNC_MAX_OUTLIERS) {
+            portEXIT_CRITICAL(&lock);
+            return;     // Referencia demorada o corrupta: se ignora
+        }
+        resets++;
+        restart(utcUsec, localUsec);
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+    outliers = 0;
+
+    // Quedarse con la referencia de menor demora del intervalo
+    int64_t relative = offset - baseOffset;
+    if (relative > slot.offsetUsec) {
+        slot.localUsec = localUsec;
+        slot.offsetUsec = relative;
+    }
+    if (localUsec - slotStartUsec >= (int64_t)TIME_SYNC_SLOT_MS * 1000) {
+        push(slot);
+        slot.localUsec = localUsec;
+        slot.offsetUsec = INT64_MIN;
+        slotStartUsec = localUsec;
+    }
+
+    portEXIT_CRITICAL(&lock);
+}
+
+void TimeSync::push(const Reference& point) {
+    window[next] = point;
+    next = (next + 1) % TIME_SYNC_WINDOW;
+    if (count < TIME_SYNC_WINDOW) {
+        count++;
+    }
+    fit();
+}
+
+// Primera referencia (o tras un salto). Hasta cerrar el primer intervalo la
+// hora sale de la mejor referencia del intervalo, sin deriva
+void TimeSync::restart(uint64_t utcUsec, int64_t localUsec) {
+    synced = true;
+    baseOffset = (int64_t)utcUsec - localUsec;
+    next = 0;
+    count = 0;
+    outliers = 0;
+    slot.localUsec = localUsec;
+    slot.offsetUsec = 0;
+    slotStartUsec = localUsec;
+}
+
+void TimeSync::fit() {
+    // Referencias relativas a la más reciente: en double no se pierde precisión
+    int newest = (next + TIME_SYNC_WINDOW - 1) % TIME_SYNC_WINDOW;
+    int oldest = (next + TIME_SYNC_WINDOW - count) % TIME_SYNC_WINDOW;
+    int64_t anchor = window[newest].localUsec;
+
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (int i = 0; i < count; i++) {
+        const Reference& ref = window[(oldest + i) % TIME_SYNC_WINDOW];
+        double x = (double)(ref.localUsec - anchor);
+        double y = (double)ref.offsetUsec;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+
+    // Deriva solo con un intervalo suficiente y un valor creíble
+    double b = 0.0;
+    double span = (double)(anchor - window[oldest].localUsec);
+    double denominator = count * sumXX - sumX * sumX;
+    if (span >= TIME_SYNC_MIN_SPAN_MS * 1000.0 && denominator > 0) {
+        b = (count * sumXY - sumX * sumY) / denominator;
+        if (b > TIME_SYNC_MAX_DRIFT_PPM * 1e-6 || b < -TIME_SYNC_MAX_DRIFT_PPM * 1e-6) {
+            b = 0.0;
+        }
+    }
+    double a = (sumY - b * sumX) / count;
+
+    // Las demoras solo restan: subir la recta hasta la referencia más adelantada
+    double highest = -1e18;
+    for (int i = 0; i < count; i++) {
+        const Reference& ref = window[(oldest + i) % TIME_SYNC_WINDOW];
+        double residual = (double)ref.offsetUsec - (a + b * (double)(ref.localUsec - anchor));
+        if (residual > highest) {
+            highest = residual;
+        }
+    }
+
+    anchorUsec = anchor;
+    intercept = a + highest;
+    slope = b;
+}
+
+int64_t TimeSync::offsetAt(int64_t localUsec) const {
+    if (count == 0) {
+        return baseOffset + slot.offsetUsec;
+    }
+    return baseOffset + (int64_t)llround(intercept + slope * (double)(localUsec - anchorUsec));
+}
+
+uint64_t TimeSync::toUtc(int64_t localUsec) const {
+    portENTER_CRITICAL(&lock);
+    uint64_t utc = synced ? (uint64_t)(localUsec + offsetAt(localUsec)) : 0;
+    portEXIT_CRITICAL(&lock);
+    return utc;
+}
+
+float TimeSync::getDriftPpm() const {
+    return (float)(slope * 1e6);
+}
+
+uint32_t TimeSync::getReferenceAgeMs() const {
+    return synced ? (uint32_t)((esp_timer_get_time() - lastReferenceUsec) / 1000) : 0;
+}
+
+String TimeSync::toString() const {
+    if (!isSynced()) {
+        return "sin referencia UTC";
+    }
+    return "refs=" + String(references) +
+           " deriva=" + String(getDriftPpm(), 2) + " ppm" +
+           " error=" + String(lastErrorUs) + " µs" +
+           " edad=" + String(getReferenceAgeMs()) + " ms" +
+           " saltos=" + String(resets);
+}
@@ -0,0 +1,37 @@
+#include "utils/adc_calibration.h"
+#include "logger.h"
+#include <esp_adc_cal.h>
+
+uint16_t AdcCalibration::lut[AdcCalibration::ADC_LUT_SIZE];
+bool AdcCalibration::ready = false;
+int AdcCalibration::source = -1;
+
+void AdcCalibration::begin() {
+    esp_adc_cal_characteristics_t characteristics;
+    esp_adc_cal_value_t value = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                                                         ADC_DEFAULT_VREF, &characteristics);
+    source = value;
+
+    // Precalcular la curva completa: el driver evalúa el polinomio de
+    // corrección en cada llamada, la tabla lo reduce a una lectura
+    for (int counts = 0; counts < ADC_LUT_SIZE; counts++) {
+        lut[counts] = esp_adc_cal_raw_to_voltage(counts, &characteristics);
+    }
+    ready = true;
+
+    LOG_INFO("ANALOG", String("Caracterización ADC: ") + getSource() +
+             " (0 → " + String(lut[0]) + " mV, 4095 → " + String(lut[ADC_LUT_SIZE - 1]) + " mV)");
+    if (value == ESP_ADC_CAL_VAL_DEFAULT_VREF) {
+        LOG_WARN("ANALOG", "Chip sin calibración en eFuse - usando Vref por defecto");
+    }
+}
+
+const char* AdcCalibration::getSource() {
+    switch (source) {
+        case ESP_ADC_CAL_VAL_EFUSE_VREF:   return "eFuse Vref";
+        case ESP_ADC_CAL_VAL_EFUSE_TP:     return "eFuse Two Point";
+        case ESP_ADC_CAL_VAL_DEFAULT_VREF: return "Vref por defecto";
+        case ESP_ADC_CAL_VAL_EFUSE_TP_FIT: return "eFuse Two Point (ajuste)";
+        default:                           return "ideal (sin caracterizar)";
+    }
+}
@@ -0,0 +1,35 @@
+#include "utils/alloc_counter.h"
+
+#if ALLOC_STATS
+
+#include <stddef.h>
+
+// Implementaciones reales (resueltas por -Wl,--wrap=...)
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+static volatile uint32_t allocations = 0;
+
+extern "C" void* __wrap_malloc(size_t size) {
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+uint32_t allocCount() {
+    return __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
+
+#endif // ALLOC_STATS
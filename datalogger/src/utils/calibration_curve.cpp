@@ -0,0 +1,122 @@
+#include "utils/calibration_curve.h"
+#include <math.h>
+
+void CalPointSet::add(float millivolts, float value, float sameValue) {
+    // Reemplazar un punto con la misma referencia (repetir cal_ph 7.0)
+    for (int i = 0; i < count; i++) {
+        if (fabsf(points[i].value - value) <= sameValue) {
+            points[i].millivolts = millivolts;
+            points[i].value = value;
+            return;
+        }
+    }
+
+    if (count == CAL_MAX_POINTS) {
+        for (int i = 1; i < CAL_MAX_POINTS; i++) {
+            points[i - 1] = points[i];
+        }
+        count--;
+    }
+
+    points[count].millivolts = millivolts;
+    points[count].value = value;
+    count++;
+}
+
+bool fitLeastSquares(const CalPointSet& set, float& gain, float& offset, float* maxResidual) {
+    if (set.count < 2) {
+        return false;
+    }
+
+    // Centrar en la media para no perder precisión en float
+    float meanX = 0.0f;
+    float meanY = 0.0f;
+    for (int i = 0; i < set.count; i++) {
+        meanX += set.points[i].millivolts;
+        meanY += set.points[i].value;
+    }
+    meanX /= set.count;
+    meanY /= set.count;
+
+    float sxx = 0.0f;
+    float sxy = 0.0f;
+    for (int i = 0; i < set.count; i++) {
+        float dx = set.points[i].millivolts - meanX;
+        sxx += dx * dx;
+        sxy += dx * (set.points[i].value - meanY);
+    }
+
+    // Lecturas idénticas (menos de 0.1 mV de dispersión): no hay pendiente
+    if (sxx < 0.01f) {
+        return false;
+    }
+
+    gain = sxy / sxx;
+    offset = meanY - gain * meanX;
+
+    if (maxResidual != nullptr) {
+        float worst = 0.0f;
+        for (int i = 0; i < set.count; i++) {
+            float residual = fabsf(set.points[i].millivolts * gain + offset - set.points[i].value);
+            if (residual > worst) {
+                worst = residual;
+            }
+        }
+        *maxResidual = worst;
+    }
+    return true;
+}
+
+bool PiecewiseLinearTable::build(const CalPointSet& set) {
+    segmentCount = 0;
+
+    // Ordenar por mV (a lo sumo CAL_MAX_POINTS, inserción)
+    CalPoint sorted[CAL_MAX_POINTS];
+    int n = 0;
+    for (int i = 0; i < set.count; i++) {
+        int j = n;
+        while (j > 0 && sorted[j - 1].millivolts > set.points[i].millivolts) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = set.points[i];
+        n++;
+    }
+
+    // Descartar lecturas repetidas (tramo de pendiente infinita)
+    int unique = 0;
+    for (int i = 0; i < n; i++) {
+        if (unique > 0 && sorted[i].millivolts - sorted[unique - 1].millivolts < 0.1f) {
+            continue;
+        }
+        sorted[unique++] = sorted[i];
+    }
+    if (unique < 2) {
+        return false;
+    }
+
+    // Un tramo entre cada par de puntos consecutivos; el primero y el último
+    // se extienden hacia los extremos
+    int count = unique - 1;
+    for (int k = 0; k < count; k++) {
+        const CalPoint& a = sorted[k];
+        const CalPoint& b = sorted[k + 1];
+        float gain = (b.value - a.value) / (b.millivolts - a.millivolts);
+        segments[k].set(gain, a.value - gain * a.millivolts);
+        segmentEnd[k] = b.millivolts;
+    }
+
+    // Tramo al inicio de cada celda uniforme
+    const float step = CAL_TABLE_MAX_MV / CAL_TABLE_SEGMENTS;
+    int segment = 0;
+    for (int cell = 0; cell < CAL_TABLE_SEGMENTS; cell++) {
+        float mv = cell * step;
+        while (segment < count - 1 && mv > segmentEnd[segment]) {
+            segment++;
+        }
+        cellSegment[cell] = segment;
+    }
+
+    segmentCount = count;
+    return true;
+}
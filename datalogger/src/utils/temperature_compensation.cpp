@@ -0,0 +1,48 @@
+#include "utils/temperature_compensation.h"
+#include <math.h>
+
+TemperatureCompensation::TemperatureCompensation() {
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        float celsius = TEMP_COMP_MIN_C + i;
+        ecTable[i] = 1.0f / (1.0f + TEMP_COMP_EC_ALPHA * (celsius - 25.0f));
+        phTable[i] = 298.15f / (celsius + 273.15f);
+    }
+
+    temperature = 25.0f;
+    timestamp = 0;
+    hasTemperature = false;
+    ecFactor = 1.0f;
+    phFactor = 1.0f;
+}
+
+void TemperatureCompensation::setTemperature(float celsius, uint32_t timestampMs) {
+    if (isnan(celsius)) {
+        return;
+    }
+
+    temperature = celsius;
+    timestamp = timestampMs;
+    hasTemperature = true;
+
+    ecFactor = interpolate(ecTable, celsius);
+    phFactor = interpolate(phTable, celsius);
+}
+
+bool TemperatureCompensation::isValid(uint32_t nowMs) const {
+    return hasTemperature && (nowMs - timestamp) <= TEMP_COMP_MAX_AGE_MS;
+}
+
+// Fuera del rango de la tabla se usa el extremo más cercano
+float TemperatureCompensation::interpolate(const float* table, float celsius) const {
+    float position = celsius - TEMP_COMP_MIN_C;
+    if (position <= 0.0f) {
+        return table[0];
+    }
+    if (position >= TABLE_SIZE - 1) {
+        return table[TABLE_SIZE - 1];
+    }
+
+    int index = (int)position;
+    float fraction = position - index;
+    return table[index] + (table[index + 1] - table[index]) * fraction;
+}
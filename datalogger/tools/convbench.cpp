@@ -0,0 +1,154 @@
+// Banco de pruebas de la conversión analógica en la PC: compara los
+// coeficientes float de LinearConversion con las fórmulas double anteriores
+// (cuentas * 3.3 / 4095 y calibración por muestra) en las 4096 cuentas del
+// ADC, y mide el costo por muestra de cada una.
+//
+// Compilar en el PC desde datalogger/tools:
+//   g++ -std=c++11 -O2 -I../include -o convbench convbench.cpp
+//
+// Uso:
+//   convbench
+//
+// Los coeficientes se calculan igual que AnalogSensors::updateConversions()
+// (entrada en mV). Para comparar con la fórmula anterior cada cuenta se pasa
+// a mV con la escala lineal de antes; la curva eFuse de AdcCalibration no
+// interviene. El error se informa en unidades y relativo al rango del canal
+// en las 4096 cuentas. En la PC el double tiene FPU propia: la diferencia de
+// tiempo en el ESP32-S3, donde el double se emula, es mucho mayor.
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "utils/linear_conversion.h"
+
+#define ADC_COUNTS 4096
+
+// Error relativo al rango aceptado (float de 24 bits de mantisa)
+#define MAX_RELATIVE_ERROR 1e-4
+
+enum Sensor { SENSOR_PH, SENSOR_DO, SENSOR_EC };
+
+struct Calibration {
+    const char* name;
+    Sensor sensor;
+    float offset;
+    float slope;
+    float k;                        // Solo EC
+};
+
+// Valores por defecto del firmware y calibraciones típicas de campo
+static const Calibration CALIBRATIONS[] = {
+    {"pH por defecto", SENSOR_PH, 0.0f, 3.3f / 4095.0f * 3.5f, 0.0f},
+    {"pH típico", SENSOR_PH, 0.12f, -0.177f, 0.0f},
+    {"DO por defecto", SENSOR_DO, 0.0f, 1.0f, 0.0f},
+    {"DO típico", SENSOR_DO, -0.35f, 4.8f, 0.0f},
+    {"EC por defecto", SENSOR_EC, 0.0f, 1.0f, 10.0f},
+    {"EC típico", SENSOR_EC, 12.5f, 1.07f, 1.0f},
+};
+
+static double elapsedSeconds(const struct timespec& start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Costo medio por iteración: se repite la pasada hasta medir al menos 0.2 s
+template <typename Pass>
+static double nsPerItem(size_t items, Pass pass) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long passes = 0;
+    double seconds;
+    do {
+        pass();
+        passes++;
+        seconds = elapsedSeconds(start);
+    } while (seconds < 0.2);
+    return seconds * 1e9 / ((double)passes * items);
+}
+
+// Fórmulas anteriores de AnalogSensors::update(), con literales double
+static float legacyConvert(const Calibration& cal, int raw) {
+    float voltage = (raw * 3.3) / 4095.0;
+    switch (cal.sensor) {
+        case SENSOR_PH: return 7.0 + ((voltage - 2.5) / cal.slope) + cal.offset;
+        case SENSOR_DO: return voltage * cal.slope + cal.offset;
+        case SENSOR_EC: return voltage * cal.k * cal.slope + cal.offset;
+    }
+    return 0.0f;
+}
+
+// Coeficientes de AnalogSensors::updateConversions()
+static LinearConversion makeConversion(const Calibration& cal) {
+    const float voltsPerMv = 0.001f;
+    LinearConversion conversion;
+    switch (cal.sensor) {
+        case SENSOR_PH:
+            conversion.set(voltsPerMv / cal.slope, 7.0f - 2.5f / cal.slope + cal.offset);
+            break;
+        case SENSOR_DO:
+            conversion.set(voltsPerMv * cal.slope, cal.offset);
+            break;
+        case SENSOR_EC:
+            conversion.set(voltsPerMv * cal.k * cal.slope, cal.offset);
+            break;
+    }
+    return conversion;
+}
+
+int main() {
+    // mV de cada cuenta con la escala lineal anterior
+    float millivolts[ADC_COUNTS];
+    for (int raw = 0; raw < ADC_COUNTS; raw++) {
+        millivolts[raw] = raw * (3300.0f / 4095.0f);
+    }
+
+    volatile float sink = 0;
+    bool allOk = true;
+
+    printf("%-16s %12s %12s %12s %10s %10s\n",
+           "calibración", "rango", "error máx", "relativo", "antes ns", "ahora ns");
+
+    for (size_t c = 0; c < sizeof(CALIBRATIONS) / sizeof(CALIBRATIONS[0]); c++) {
+        const Calibration& cal = CALIBRATIONS[c];
+        LinearConversion conversion = makeConversion(cal);
+
+        double low = legacyConvert(cal, 0);
+        double high = legacyConvert(cal, ADC_COUNTS - 1);
+        double range = fabs(high - low);
+        double maxError = 0;        // Diferencia en double entre las dos salidas float
+        for (int raw = 0; raw < ADC_COUNTS; raw++) {
+            double error = fabs((double)conversion.apply(millivolts[raw]) - legacyConvert(cal, raw));
+            if (error > maxError) {
+                maxError = error;
+            }
+        }
+        double relative = range > 0 ? maxError / range : maxError;
+        if (relative > MAX_RELATIVE_ERROR) {
+            allOk = false;
+        }
+
+        double legacyNs = nsPerItem(ADC_COUNTS, [&]() {
+            float sum = 0;
+            for (int raw = 0; raw < ADC_COUNTS; raw++) {
+                sum += legacyConvert(cal, raw);
+            }
+            sink = sink + sum;
+        });
+        double currentNs = nsPerItem(ADC_COUNTS, [&]() {
+            float sum = 0;
+            for (int raw = 0; raw < ADC_COUNTS; raw++) {
+                sum += conversion.apply(millivolts[raw]);
+            }
+            sink = sink + sum;
+        });
+
+        printf("%-16s %12.4g %12.3g %12.3g %10.2f %10.2f%s\n", cal.name, range, maxError, relative,
+               legacyNs, currentNs, relative > MAX_RELATIVE_ERROR ? "  FUERA DE TOLERANCIA" : "");
+    }
+
+    printf("error: máximo |ahora - antes| en las %d cuentas; relativo: sobre el rango del canal.\n", ADC_COUNTS);
+    printf("%s\n", allOk ? "Todas las calibraciones dentro de la tolerancia."
+                         : "HAY CALIBRACIONES FUERA DE TOLERANCIA.");
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+// Banco de pruebas del enlace MAVLink en la PC: genera frames de cada
+// mensaje con campos descritos en mavlink_messages.cpp y mide el costo por
+// mensaje del framing (mavlink_parser) y del decodificador por descriptores.
+//
+// Compilar en el PC desde datalogger/tools:
+//   g++ -std=c++11 -O2 -I../include -o mavbench mavbench.cpp
+//       ../src/modules/mavlink_parser.cpp ../src/modules/mavlink_messages.cpp
+//
+// Uso:
+//   mavbench [frames por mensaje]
+//
+// Los campos llevan valores al azar, con un tercio en cero para que MAVLink 2
+// recorte la cola del payload. Los frames alternan v1 (payload completo) y
+// v2 (recortado), así se mide también el completado con ceros. Cada campo
+// decodificado se compara con el escrito leyéndolo con su tipo nativo.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "modules/mavlink_parser.h"
+#include "modules/mavlink_messages.h"
+#include "utils/crc.h"
+
+#define DEFAULT_FRAMES 2000
+
+// Payload generado y su frame en el enlace
+struct TestFrame {
+    uint8_t payload[MAVLINK_MAX_DECODED_PAYLOAD];
+    uint8_t wireLength;             // Largo enviado (recortado en v2)
+    uint8_t version;
+};
+
+static double elapsedSeconds(const struct timespec& start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Costo medio por iteración: se repite la pasada hasta medir al menos 0.2 s
+template <typename Pass>
+static double nsPerItem(size_t items, Pass pass) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long passes = 0;
+    double seconds;
+    do {
+        pass();
+        passes++;
+        seconds = elapsedSeconds(start);
+    } while (seconds < 0.2);
+    return seconds * 1e9 / ((double)passes * items);
+}
+
+static void fillPayload(const MavlinkMessageDescriptor& message, uint8_t* payload) {
+    memset(payload, 0, message.length);
+    for (uint8_t field = 0; field < message.fieldCount; field++) {
+        const MavlinkFieldDescriptor& descriptor = message.fields[field];
+        size_t size = mavlinkFieldSize(descriptor.type);
+        for (uint8_t index = 0; index < descriptor.count; index++) {
+            if (rand() % 3 == 0) {
+                continue;
+            }
+            uint8_t* element = payload + descriptor.offset + index * size;
+            for (size_t i = 0; i < size; i++) {
+                element[i] = rand();
+            }
+            if (descriptor.type == MAV_FIELD_F32) {
+                float value = (rand() - RAND_MAX / 2) / 1000.0f;
+                memcpy(element, &value, sizeof(value));
+            } else if (descriptor.type == MAV_FIELD_F64) {
+                double value = (rand() - RAND_MAX / 2) / 1000.0;
+                memcpy(element, &value, sizeof(value));
+            }
+        }
+    }
+}
+
+static void appendFrame(const MavlinkMessageDescriptor& message, const TestFrame& frame, uint8_t sequence,
+                        std::vector<uint8_t>& stream) {
+    size_t start = stream.size();
+    if (frame.version == 1) {
+        const uint8_t header[MAVLINK_V1_HEADER_SIZE] = {
+            MAVLINK_STX_V1, frame.wireLength, sequence, 1, 1, (uint8_t)message.msgId};
+        stream.insert(stream.end(), header, header + sizeof(header));
+    } else {
+        const uint8_t header[MAVLINK_V2_HEADER_SIZE] = {
+            MAVLINK_STX_V2, frame.wireLength, 0, 0, sequence, 1, 1,
+            (uint8_t)message.msgId, (uint8_t)(message.msgId >> 8), (uint8_t)(message.msgId >> 16)};
+        stream.insert(stream.end(), header, header + sizeof(header));
+    }
+    stream.insert(stream.end(), frame.payload, frame.payload + frame.wireLength);
+
+    uint16_t crc = 0xFFFF;
+    for (size_t i = start + 1; i < stream.size(); i++) {
+        crc = crc16X25Update(crc, stream[i]);
+    }
+    crc = crc16X25Update(crc, message.crcExtra);
+    stream.push_back(crc & 0xFF);
+    stream.push_back(crc >> 8);
+}
+
+// Valor esperado leyendo el campo con su tipo nativo
+static bool elementMatches(const MavlinkMessage& decoded, const uint8_t* payload,
+                           const MavlinkFieldDescriptor& descriptor, uint8_t field, uint8_t index) {
+    const uint8_t* element = payload + descriptor.offset + index * mavlinkFieldSize(descriptor.type);
+    switch (descriptor.type) {
+        case MAV_FIELD_U8: { uint8_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_I8: { int8_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_U16: { uint16_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_I16: { int16_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_U32: { uint32_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_I32: { int32_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_U64: { uint64_t v; memcpy(&v, element, sizeof(v)); return decoded.getUInt(field, index) == v; }
+        case MAV_FIELD_I64: { int64_t v; memcpy(&v, element, sizeof(v)); return decoded.getInt(field, index) == v; }
+        case MAV_FIELD_F32: { float v; memcpy(&v, element, sizeof(v)); return decoded.getFloat(field, index) == v; }
+        case MAV_FIELD_F64: { double v; memcpy(&v, element, sizeof(v)); return decoded.getFloat(field, index) == (float)v; }
+    }
+    return false;
+}
+
+// Leer todos los elementos como lo haría un handler
+static double readAllFields(const MavlinkMessage& decoded) {
+    double sum = 0;
+    for (uint8_t field = 0; field < decoded.descriptor->fieldCount; field++) {
+        const MavlinkFieldDescriptor& descriptor = decoded.descriptor->fields[field];
+        for (uint8_t index = 0; index < descriptor.count; index++) {
+            if (descriptor.type == MAV_FIELD_F32 || descriptor.type == MAV_FIELD_F64) {
+                sum += decoded.getFloat(field, index);
+            } else {
+                sum += decoded.getInt(field, index);
+            }
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    unsigned long frameCount = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_FRAMES;
+    if (frameCount == 0) {
+        fprintf(stderr, "Uso:\n  mavbench [frames por mensaje, %d por defecto]\n", DEFAULT_FRAMES);
+        return 1;
+    }
+    srand(1);
+
+    size_t messageCount;
+    const MavlinkMessageDescriptor* messages = getMavlinkMessages(messageCount);
+    unsigned long totalMismatches = 0;
+    volatile double sink = 0;
+
+    printf("%-20s %5s %6s %9s %10s %11s %11s %8s\n",
+           "mensaje", "largo", "campos", "v2 medio", "framing ns", "decode ns", "+campos ns", "errores");
+
+    for (size_t m = 0; m < messageCount; m++) {
+        const MavlinkMessageDescriptor& message = messages[m];
+        if (message.fieldCount == 0) {
+            continue;
+        }
+
+        std::vector<TestFrame> frames(frameCount);
+        std::vector<uint8_t> stream;
+        unsigned long v2Bytes = 0;
+        unsigned long v2Frames = 0;
+        unsigned long elements = 0;
+        for (uint8_t field = 0; field < message.fieldCount; field++) {
+            elements += message.fields[field].count;
+        }
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            TestFrame& frame = frames[i];
+            fillPayload(message, frame.payload);
+            frame.version = (i % 2 == 0 && message.msgId <= 0xFF) ? 1 : 2;
+            frame.wireLength = message.length;
+            if (frame.version == 2) {
+                // MAVLink 2 manda al menos un byte de payload
+                while (frame.wireLength > 1 && frame.payload[frame.wireLength - 1] == 0) {
+                    frame.wireLength--;
+                }
+                v2Bytes += frame.wireLength;
+                v2Frames++;
+            }
+            appendFrame(message, frame, (uint8_t)i, stream);
+        }
+
+        // Framing: parser completo sobre el stream, con CRC
+        MavlinkParser parser;
+        std::vector<MavlinkFrame> received;
+        std::vector<std::vector<uint8_t> > payloads;
+        for (size_t i = 0; i < stream.size(); i++) {
+            parser.parse(stream[i], [&](const MavlinkFrame& frame) {
+                received.push_back(frame);
+                payloads.push_back(std::vector<uint8_t>(frame.payload, frame.payload + frame.payloadLength));
+            });
+        }
+        for (size_t i = 0; i < received.size(); i++) {
+            received[i].payload = payloads[i].data();
+        }
+
+        // Ida y vuelta: cada elemento decodificado igual al generado
+        unsigned long mismatches = received.size() == frames.size() ? 0 : frames.size();
+        MavlinkMessage decoded;
+        for (size_t i = 0; i < received.size() && i < frames.size(); i++) {
+            if (!mavlinkDecode(received[i], decoded)) {
+                mismatches++;
+                continue;
+            }
+            for (uint8_t field = 0; field < message.fieldCount; field++) {
+                for (uint8_t index = 0; index < message.fields[field].count; index++) {
+                    if (!elementMatches(decoded, frames[i].payload, message.fields[field], field, index)) {
+                        mismatches++;
+                    }
+                }
+            }
+        }
+        totalMismatches += mismatches;
+
+        double framingNs = nsPerItem(frames.size(), [&]() {
+            MavlinkParser pass;
+            unsigned long count = 0;
+            for (size_t i = 0; i < stream.size(); i++) {
+                pass.parse(stream[i], [&](const MavlinkFrame&) { count++; });
+            }
+            sink = sink + count;
+        });
+        double decodeNs = nsPerItem(received.size(), [&]() {
+            for (size_t i = 0; i < received.size(); i++) {
+                mavlinkDecode(received[i], decoded);
+                sink = sink + decoded.payload[0];
+            }
+        });
+        double fieldsNs = nsPerItem(received.size(), [&]() {
+            for (size_t i = 0; i < received.size(); i++) {
+                mavlinkDecode(received[i], decoded);
+                sink = sink + readAllFields(decoded);
+            }
+        });
+
+        printf("%-20s %5u %3u/%-3lu %9.1f %10.1f %11.1f %11.1f %8lu\n",
+               message.name, message.length, message.fieldCount, elements,
+               v2Frames > 0 ? (double)v2Bytes / v2Frames : 0.0, framingNs, decodeNs, fieldsNs, mismatches);
+    }
+
+    printf("campos: descritos/elementos (arreglos incluidos). v2 medio: largo del payload recortado.\n");
+    printf("framing: parser con CRC por frame; decode: copia y completado con ceros; +campos: además\n");
+    printf("leer todos los elementos. %s\n", totalMismatches == 0 ? "Todos los campos coinciden."
+                                                                    : "HAY CAMPOS DISTINTOS.");
+    return totalMismatches == 0 ? 0 : 1;
+}
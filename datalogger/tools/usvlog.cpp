@@ -0,0 +1,914 @@
+// Conversor de logs binarios del SDLogger (SD_LOG_BINARY=1) a CSV y
+// rescate de journals (SD_LOG_JOURNAL=1) desde una imagen de la tarjeta.
+//
+// Compilar en el PC desde datalogger/tools:
+//   g++ -std=c++11 -O2 -I../include -o usvlog usvlog.cpp
+//       ../src/modules/record_schema.cpp ../src/modules/sample_record.cpp
+//       ../src/modules/log_journal.cpp ../src/modules/delta_codec.cpp ../src/utils/crc.cpp
+//
+// Uso:
+//   usvlog info <log.bin>
+//   usvlog csv <log.bin> [salida.csv]
+//   usvlog salvage <imagen> <directorio>
+//   usvlog bench <log.csv|log.bin> [intervalo]
+//
+// Si el esquema del archivo coincide con el compilado la salida es idéntica
+// byte a byte al CSV que habría escrito el firmware. Si no coincide (archivo
+// de otra versión) se decodifica con las entradas del propio header.
+//
+// salvage no usa el sistema de archivos: recorre la imagen (dd de la tarjeta
+// o un .jnl suelto) buscando frames del journal con CRC válido, los ordena
+// por archivo y secuencia y escribe un log_NNNNNN.csv por archivo.
+//
+// bench codifica los registros de un log (CSV o binario) en los tres
+// formatos y compara tamaño y costo por registro de cada uno, verificando
+// que la compresión delta reproduzca el mismo CSV.
+
+#define _FILE_OFFSET_BITS 64
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "modules/record_schema.h"
+#include "modules/sample_record.h"
+#include "modules/log_journal.h"
+#include "modules/delta_codec.h"
+#include "utils/crc.h"
+#include "config.h"
+
+struct LogFile {
+    BinaryLogHeader header;
+    std::vector<BinaryFieldEntry> fields;
+    std::vector<uint8_t> data;      // Archivo completo
+};
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", path);
+        return false;
+    }
+
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return true;
+}
+
+// Esquema del header binario al comienzo de data
+static bool parseHeader(const uint8_t* data, size_t size, LogFile& log) {
+    if (size < sizeof(BinaryLogHeader)) {
+        fprintf(stderr, "Archivo demasiado corto\n");
+        return false;
+    }
+
+    memcpy(&log.header, data, sizeof(BinaryLogHeader));
+    if (memcmp(log.header.magic, BINARY_LOG_MAGIC, sizeof(log.header.magic)) != 0) {
+        fprintf(stderr, "No es un log binario (magic incorrecto)\n");
+        return false;
+    }
+    if (log.header.version != BINARY_LOG_VERSION && log.header.version != BINARY_LOG_VERSION_DELTA) {
+        fprintf(stderr, "Versión %u no soportada\n", log.header.version);
+        return false;
+    }
+
+    size_t expected = sizeof(BinaryLogHeader) + log.header.fieldCount * sizeof(BinaryFieldEntry) +
+                      sizeof(uint16_t);
+    if (log.header.headerSize != expected || size < expected) {
+        fprintf(stderr, "Header truncado o inconsistente\n");
+        return false;
+    }
+
+    uint16_t stored;
+    memcpy(&stored, data + expected - sizeof(uint16_t), sizeof(stored));
+    if (crc16Ccitt(data, expected - sizeof(uint16_t)) != stored) {
+        fprintf(stderr, "CRC del header incorrecto\n");
+        return false;
+    }
+
+    size_t payload = 0;
+    for (uint8_t i = 0; i < log.header.fieldCount; i++) {
+        BinaryFieldEntry entry;
+        memcpy(&entry, data + sizeof(BinaryLogHeader) + i * sizeof(BinaryFieldEntry),
+               sizeof(entry));
+        entry.name[BINARY_FIELD_NAME_LENGTH - 1] = '\0';
+        payload += fieldTypeSize((FieldType)entry.type);
+        log.fields.push_back(entry);
+    }
+
+    if (payload + sizeof(uint16_t) != log.header.recordSize) {
+        fprintf(stderr, "El tamaño de registro no coincide con los campos\n");
+        return false;
+    }
+    return true;
+}
+
+// ¿El archivo usa exactamente el esquema compilado?
+static bool matchesCompiledSchema(const LogFile& log) {
+    if (log.header.fieldCount != RECORD_FIELD_COUNT ||
+        log.header.recordSize != binaryRecordSize()) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        const BinaryFieldEntry& entry = log.fields[i];
+        if (entry.type != RECORD_FIELDS[i].type ||
+            entry.decimals != RECORD_FIELDS[i].decimals ||
+            entry.scale != RECORD_FIELDS[i].scale ||
+            strcmp(entry.name, RECORD_FIELDS[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Valor de un campo según las entradas del archivo (esquema ajeno)
+static void printGenericField(FILE* out, const BinaryFieldEntry& entry, const uint8_t* source) {
+    switch (entry.type) {
+        case FIELD_U8:
+            fprintf(out, "%u", source[0]);
+            break;
+        case FIELD_U16: {
+            uint16_t value;
+            memcpy(&value, source, sizeof(value));
+            fprintf(out, "%u", value);
+            break;
+        }
+        case FIELD_U32: {
+            uint32_t value;
+            memcpy(&value, source, sizeof(value));
+            fprintf(out, "%lu", (unsigned long)value);
+            break;
+        }
+        case FIELD_I32: {
+            int32_t value;
+            memcpy(&value, source, sizeof(value));
+            fprintf(out, "%ld", (long)value);
+            break;
+        }
+        case FIELD_U64: {
+            uint64_t value;
+            memcpy(&value, source, sizeof(value));
+            fprintf(out, "%llu", (unsigned long long)value);
+            break;
+        }
+        case FIELD_F32: {
+            float value;
+            memcpy(&value, source, sizeof(value));
+            if (isnan(value)) {
+                fprintf(out, "NaN");
+            } else {
+                fprintf(out, "%.*f", entry.decimals, value * entry.scale);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Valor de un campo en punto fijo (registros comprimidos, esquema ajeno)
+static void printQuantizedField(FILE* out, const BinaryFieldEntry& entry, int64_t value) {
+    if (entry.type != FIELD_F32) {
+        fprintf(out, "%lld", (long long)value);
+    } else if (value == QUANTIZED_NAN) {
+        fprintf(out, "NaN");
+    } else {
+        fprintf(out, "%.*f", entry.decimals, value / decimalScale(entry.decimals) * entry.scale);
+    }
+}
+
+static bool isDeltaLog(const LogFile& log) {
+    return log.header.version == BINARY_LOG_VERSION_DELTA;
+}
+
+// Estado del lector de registros comprimidos: los valores del último
+// registro leído y si son confiables (key frame sin huecos desde entonces)
+struct DeltaReader {
+    int64_t values[BINARY_LOG_MAX_FIELDS];
+    bool synced;
+    unsigned long records;
+    unsigned long keyFrames;
+    unsigned long unsynced;         // Registros delta sin key frame previo
+};
+
+// Leer un registro comprimido y escribir su fila si out != NULL. Devuelve
+// su tamaño, o 0 si está dañado (el lector espera el próximo key frame)
+static size_t readDeltaRecord(FILE* out, const LogFile& log, bool native, const uint8_t* raw,
+                              size_t available, DeltaReader& reader) {
+    int64_t values[BINARY_LOG_MAX_FIELDS];
+    bool keyFrame;
+    size_t size = decodeDeltaRecord(raw, available, log.header.fieldCount,
+                                    reader.synced ? reader.values : NULL, values, keyFrame);
+    if (size == 0) {
+        reader.synced = false;
+        return 0;
+    }
+    if (!keyFrame && !reader.synced) {
+        reader.unsynced++;
+        return size;
+    }
+
+    memcpy(reader.values, values, log.header.fieldCount * sizeof(int64_t));
+    reader.synced = true;
+    reader.records++;
+    if (keyFrame) {
+        reader.keyFrames++;
+    }
+    if (out == NULL) {
+        return size;
+    }
+
+    if (native) {
+        SampleRecord record;
+        char line[SAMPLE_CSV_MAX_LENGTH];
+        dequantizeRecord(values, record);
+        if (formatRecordCSV(record, line, sizeof(line)) >= 0) {
+            fprintf(out, "%s\r\n", line);
+        }
+    } else {
+        for (uint8_t i = 0; i < log.header.fieldCount; i++) {
+            if (i > 0) {
+                fputc(',', out);
+            }
+            printQuantizedField(out, log.fields[i], values[i]);
+        }
+        fprintf(out, "\r\n");
+    }
+    return size;
+}
+
+// Recorrer los registros comprimidos del archivo. Tras un registro dañado se
+// avanza byte a byte hasta el próximo que decodifique. Devuelve los bytes salteados
+static size_t readDeltaLog(FILE* out, const LogFile& log, bool native, DeltaReader& reader) {
+    size_t skipped = 0;
+    size_t pos = log.header.headerSize;
+    while (pos < log.data.size()) {
+        size_t size = readDeltaRecord(out, log, native, log.data.data() + pos, log.data.size() - pos, reader);
+        if (size == 0) {
+            skipped++;
+            pos++;
+        } else {
+            pos += size;
+        }
+    }
+    return skipped;
+}
+
+static int commandInfo(const LogFile& log) {
+    size_t body = log.data.size() - log.header.headerSize;
+    printf("Versión: %u%s\n", log.header.version, isDeltaLog(log) ? " (comprimido)" : "");
+    printf("Campos: %u\n", log.header.fieldCount);
+    printf("Registro: %u bytes%s\n", log.header.recordSize, isDeltaLog(log) ? " sin comprimir" : "");
+    if (isDeltaLog(log)) {
+        DeltaReader reader = {};
+        size_t skipped = readDeltaLog(NULL, log, false, reader);
+        printf("Registros: %lu (%lu key frames), prom %.1f bytes", reader.records, reader.keyFrames,
+               reader.records > 0 ? (double)(body - skipped) / reader.records : 0.0);
+        if (skipped > 0 || reader.unsynced > 0) {
+            printf(" (%lu bytes dañados, %lu registros sin key frame)", (unsigned long)skipped, reader.unsynced);
+        }
+    } else {
+        printf("Registros: %lu", (unsigned long)(body / log.header.recordSize));
+        if (body % log.header.recordSize != 0) {
+            printf(" (+%lu bytes sueltos al final)", (unsigned long)(body % log.header.recordSize));
+        }
+    }
+    printf("\n");
+    printf("Esquema compilado: %s\n", matchesCompiledSchema(log) ? "coincide" : "distinto");
+
+    for (uint8_t i = 0; i < log.header.fieldCount; i++) {
+        const BinaryFieldEntry& entry = log.fields[i];
+        printf("  %-24s tipo=%u offset=%u escala=%g decimales=%u\n", entry.name, entry.type,
+               entry.packedOffset, entry.scale, entry.decimals);
+    }
+    return 0;
+}
+
+// Fila CSV de un registro binario; false si el CRC no coincide
+static bool printRecordCSV(FILE* out, const LogFile& log, bool native, const uint8_t* raw) {
+    if (native) {
+        SampleRecord record;
+        char line[SAMPLE_CSV_MAX_LENGTH];
+        if (!decodeBinaryRecord(raw, record)) {
+            return false;
+        }
+        if (formatRecordCSV(record, line, sizeof(line)) >= 0) {
+            fprintf(out, "%s\r\n", line);
+        }
+        return true;
+    }
+
+    size_t payload = log.header.recordSize - sizeof(uint16_t);
+    uint16_t stored;
+    memcpy(&stored, raw + payload, sizeof(stored));
+    if (crc16Ccitt(raw, payload) != stored) {
+        return false;
+    }
+    for (uint8_t i = 0; i < log.header.fieldCount; i++) {
+        if (i > 0) {
+            fputc(',', out);
+        }
+        printGenericField(out, log.fields[i], raw + log.fields[i].packedOffset);
+    }
+    fprintf(out, "\r\n");
+    return true;
+}
+
+static void printSchemaHeader(FILE* out, const LogFile& log) {
+    for (uint8_t i = 0; i < log.header.fieldCount; i++) {
+        fprintf(out, i == 0 ? "%s" : ",%s", log.fields[i].name);
+    }
+    fprintf(out, "\r\n");
+}
+
+static int commandCSV(const LogFile& log, FILE* out) {
+    bool native = matchesCompiledSchema(log);
+    if (!native) {
+        fprintf(stderr, "Esquema distinto al compilado: decodificación genérica\n");
+    }
+
+    printSchemaHeader(out, log);
+
+    if (isDeltaLog(log)) {
+        DeltaReader reader = {};
+        size_t skipped = readDeltaLog(out, log, native, reader);
+        fprintf(stderr, "%lu registros convertidos (%lu key frames), %lu bytes dañados, "
+                "%lu registros sin key frame\n", reader.records, reader.keyFrames,
+                (unsigned long)skipped, reader.unsynced);
+        return 0;
+    }
+
+    size_t recordSize = log.header.recordSize;
+    unsigned long written = 0;
+    unsigned long crcErrors = 0;
+
+    for (size_t pos = log.header.headerSize; pos + recordSize <= log.data.size(); pos += recordSize) {
+        if (printRecordCSV(out, log, native, log.data.data() + pos)) {
+            written++;
+        } else {
+            crcErrors++;
+        }
+    }
+
+    fprintf(stderr, "%lu registros convertidos, %lu descartados por CRC\n", written, crcErrors);
+    return 0;
+}
+
+// ====================== RESCATE DEL JOURNAL ======================
+#define SALVAGE_CHUNK_SIZE (4UL * 1024 * 1024)
+#define SALVAGE_MAX_FRAME (sizeof(JournalFrameHeader) + JOURNAL_MAX_PAYLOAD)
+
+// Frame íntegro encontrado en la imagen
+struct FrameRef {
+    uint32_t fileNumber;
+    uint32_t sequence;
+    uint64_t offset;            // Del payload en la imagen
+    uint16_t length;
+};
+
+static bool frameOrder(const FrameRef& a, const FrameRef& b) {
+    if (a.fileNumber != b.fileNumber) {
+        return a.fileNumber < b.fileNumber;
+    }
+    if (a.sequence != b.sequence) {
+        return a.sequence < b.sequence;
+    }
+    return a.offset < b.offset;
+}
+
+static double elapsedSeconds(const struct timespec& start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Primera pasada: índice de todos los frames íntegros. Se lee en bloques
+// grandes y memchr salta hasta el próximo magic; la cola de cada bloque que
+// podría tener un frame partido pasa al siguiente
+static bool scanImage(FILE* image, std::vector<FrameRef>& frames, uint64_t& scanned,
+                      unsigned long& rejected) {
+    std::vector<uint8_t> buffer(SALVAGE_CHUNK_SIZE + SALVAGE_MAX_FRAME);
+    uint8_t* data = buffer.data();
+    size_t carry = 0;
+    uint64_t base = 0;          // Offset en la imagen de data[0]
+    bool eof = false;
+
+    while (!eof) {
+        size_t n = fread(data + carry, 1, SALVAGE_CHUNK_SIZE, image);
+        eof = n < SALVAGE_CHUNK_SIZE;
+        size_t available = carry + n;
+
+        // Sin fin de archivo solo se revisan posiciones con un frame máximo por delante
+        size_t limit = eof ? available : available - (SALVAGE_MAX_FRAME - 1);
+        size_t pos = 0;
+        while (pos < limit) {
+            const uint8_t* hit = (const uint8_t*)memchr(data + pos, JOURNAL_MAGIC_0, limit - pos);
+            if (hit == NULL) {
+                pos = limit;
+                break;
+            }
+            pos = hit - data;
+
+            JournalFrameHeader header;
+            size_t size = checkJournalFrame(hit, available - pos, header);
+            if (size == 0) {
+                if (available - pos >= 2 && hit[1] == JOURNAL_MAGIC_1) {
+                    rejected++;
+                }
+                pos++;
+                continue;
+            }
+
+            FrameRef ref = {header.fileNumber, header.sequence, base + pos + sizeof(JournalFrameHeader),
+                            header.length};
+            frames.push_back(ref);
+            pos += size;
+        }
+
+        carry = available - pos;
+        memmove(data, data + pos, carry);
+        base += pos;
+    }
+
+    scanned = base + carry;
+    return ferror(image) == 0;
+}
+
+// Leer un payload ya indexado. Solo se reposiciona si no es contiguo al
+// anterior, así los frames de un archivo sin fragmentar se leen en secuencia
+static bool readPayload(FILE* image, const FrameRef& frame, uint8_t* out, uint64_t& position) {
+    if (position != frame.offset && fseeko(image, (off_t)frame.offset, SEEK_SET) != 0) {
+        return false;
+    }
+    if (fread(out, 1, frame.length, image) != frame.length) {
+        position = UINT64_MAX;
+        return false;
+    }
+    position = frame.offset + frame.length;
+    return true;
+}
+
+// Segunda pasada: un CSV por número de archivo con sus frames [first, last)
+static bool salvageFile(FILE* image, const std::vector<FrameRef>& frames, size_t first, size_t last,
+                        const char* dir, uint64_t& position) {
+    uint32_t number = frames[first].fileNumber;
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/log_%06lu.csv", dir, (unsigned long)number);
+    FILE* out = fopen(path, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "No se pudo crear %s\n", path);
+        return false;
+    }
+
+    static uint8_t payload[JOURNAL_MAX_PAYLOAD];
+    LogFile log;
+    bool binary = false;
+    bool native = false;
+    size_t index = first;
+
+    // Frame 0: header de texto o esquema binario
+    if (frames[index].sequence == 0 && readPayload(image, frames[index], payload, position)) {
+        if (frames[index].length >= sizeof(BINARY_LOG_MAGIC) - 1 &&
+            memcmp(payload, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC) - 1) == 0) {
+            binary = parseHeader(payload, frames[index].length, log);
+            if (!binary) {
+                fprintf(stderr, "log_%06lu: esquema ilegible\n", (unsigned long)number);
+            }
+        } else {
+            fwrite(payload, 1, frames[index].length, out);
+        }
+        index++;
+    } else if (frames[index].sequence != 0 && frames[index].length == binaryRecordSize() &&
+               readPayload(image, frames[index], payload, position)) {
+        // Sin header: registros del tamaño binario se leen con el esquema compilado
+        SampleRecord record;
+        if (decodeBinaryRecord(payload, record)) {
+            uint8_t header[BINARY_HEADER_MAX_SIZE];
+            size_t length = writeBinaryHeader(header, sizeof(header));
+            binary = parseHeader(header, length, log);
+            fprintf(stderr, "log_%06lu: sin header, se usa el esquema compilado\n", (unsigned long)number);
+        }
+    } else if (frames[index].sequence != 0 && readPayload(image, frames[index], payload, position)) {
+        // Sin header: lo mismo con registros comprimidos
+        int64_t values[SAMPLE_CSV_FIELD_COUNT];
+        bool keyFrame;
+        if (decodeDeltaRecord(payload, frames[index].length, RECORD_FIELD_COUNT, NULL, values, keyFrame) ==
+            frames[index].length) {
+            uint8_t header[BINARY_HEADER_MAX_SIZE];
+            size_t length = writeBinaryHeader(header, sizeof(header), BINARY_LOG_VERSION_DELTA);
+            binary = parseHeader(header, length, log);
+            fprintf(stderr, "log_%06lu: sin header, se usa el esquema compilado (comprimido)\n",
+                    (unsigned long)number);
+        }
+    }
+    if (binary) {
+        native = matchesCompiledSchema(log);
+        printSchemaHeader(out, log);
+    }
+
+    unsigned long records = 0;
+    unsigned long missing = 0;
+    unsigned long gaps = 0;
+    unsigned long duplicates = 0;
+    unsigned long outOfOrder = 0;
+    unsigned long bad = 0;
+    DeltaReader reader = {};
+    uint32_t expected = frames[first].sequence == 0 ? 1 : frames[first].sequence;
+
+    for (; index < last; index++) {
+        const FrameRef& frame = frames[index];
+        if (frame.sequence == 0 || (index > first && frame.sequence == frames[index - 1].sequence)) {
+            duplicates++;
+            continue;
+        }
+        if (index > first && frame.offset < frames[index - 1].offset) {
+            outOfOrder++;
+        }
+        if (frame.sequence != expected) {
+            gaps++;
+            missing += frame.sequence - expected;
+            // Los deltas siguientes dependen de lo perdido
+            reader.synced = false;
+        }
+        expected = frame.sequence + 1;
+
+        if (!readPayload(image, frame, payload, position)) {
+            bad++;
+            continue;
+        }
+        if (!binary) {
+            fwrite(payload, 1, frame.length, out);
+        } else if (isDeltaLog(log)) {
+            unsigned long before = reader.records;
+            if (readDeltaRecord(out, log, native, payload, frame.length, reader) != frame.length) {
+                bad++;
+            }
+            records += reader.records - before;
+            continue;
+        } else if (frame.length != log.header.recordSize || !printRecordCSV(out, log, native, payload)) {
+            bad++;
+            continue;
+        }
+        records++;
+    }
+    if (reader.unsynced > 0) {
+        fprintf(stderr, "log_%06lu: %lu registros delta sin key frame previo\n", (unsigned long)number,
+                reader.unsynced);
+    }
+
+    fclose(out);
+    printf("log_%06lu.csv: %lu registros, %lu huecos (%lu faltantes), %lu duplicados, "
+           "%lu fuera de orden en disco, %lu ilegibles\n",
+           (unsigned long)number, records, gaps, missing, duplicates, outOfOrder, bad);
+    return true;
+}
+
+static int commandSalvage(const char* imagePath, const char* dir) {
+    FILE* image = fopen(imagePath, "rb");
+    if (image == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", imagePath);
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    std::vector<FrameRef> frames;
+    uint64_t scanned = 0;
+    unsigned long rejected = 0;
+    if (!scanImage(image, frames, scanned, rejected)) {
+        fprintf(stderr, "Error de lectura en %s\n", imagePath);
+        fclose(image);
+        return 1;
+    }
+
+    double seconds = elapsedSeconds(start);
+    printf("%llu MB recorridos en %.1f s (%.0f MB/s): %lu frames válidos, %lu candidatos descartados\n",
+           (unsigned long long)(scanned >> 20), seconds, seconds > 0 ? (scanned / 1048576.0) / seconds : 0.0,
+           (unsigned long)frames.size(), rejected);
+
+    std::sort(frames.begin(), frames.end(), frameOrder);
+
+    uint64_t position = UINT64_MAX;
+    size_t first = 0;
+    int result = 0;
+    while (first < frames.size()) {
+        size_t last = first;
+        while (last < frames.size() && frames[last].fileNumber == frames[first].fileNumber) {
+            last++;
+        }
+        if (!salvageFile(image, frames, first, last, dir, position)) {
+            result = 1;
+        }
+        first = last;
+    }
+
+    fclose(image);
+    return result;
+}
+
+// ====================== BENCHMARK ======================
+// Fila CSV del firmware a registro (columnas en el orden del esquema)
+static bool parseCSVRow(const char* line, SampleRecord& record) {
+    memset(&record, 0, sizeof(record));
+    uint8_t* target = (uint8_t*)&record;
+    const char* cursor = line;
+
+    for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++) {
+        uint8_t* member = target + RECORD_FIELDS[i].recordOffset;
+        char* end;
+
+        // UTC: entero de 64 bits, vacío sin referencia (un double no lo representa exacto)
+        if (RECORD_FIELDS[i].type == FIELD_U64) {
+            uint64_t field = strtoull(cursor, &end, 10);
+            if (*end != ',') {
+                return false;
+            }
+            memcpy(member, &field, sizeof(field));
+            cursor = end + 1;
+            continue;
+        }
+
+        double value = strtod(cursor, &end);
+        if (end == cursor || *end != ',') {
+            return false;
+        }
+        cursor = end + 1;
+
+        switch (RECORD_FIELDS[i].type) {
+            case FIELD_U8:
+                *member = (uint8_t)value;
+                break;
+            case FIELD_U16: {
+                uint16_t field = (uint16_t)value;
+                memcpy(member, &field, sizeof(field));
+                break;
+            }
+            case FIELD_U32: {
+                uint32_t field = (uint32_t)value;
+                memcpy(member, &field, sizeof(field));
+                break;
+            }
+            case FIELD_I32: {
+                int32_t field = (int32_t)value;
+                memcpy(member, &field, sizeof(field));
+                break;
+            }
+            case FIELD_F32: {
+                float field = (float)value;
+                memcpy(member, &field, sizeof(field));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// Registros de un log CSV, binario o comprimido con el esquema compilado
+static bool loadRecords(const char* path, std::vector<SampleRecord>& records) {
+    LogFile log;
+    if (!readFile(path, log.data)) {
+        return false;
+    }
+
+    if (log.data.size() >= 4 && memcmp(log.data.data(), BINARY_LOG_MAGIC, 4) == 0) {
+        if (!parseHeader(log.data.data(), log.data.size(), log)) {
+            return false;
+        }
+        if (!matchesCompiledSchema(log)) {
+            fprintf(stderr, "El esquema del archivo no es el compilado\n");
+            return false;
+        }
+
+        SampleRecord record;
+        size_t pos = log.header.headerSize;
+        if (!isDeltaLog(log)) {
+            for (; pos + log.header.recordSize <= log.data.size(); pos += log.header.recordSize) {
+                if (decodeBinaryRecord(log.data.data() + pos, record)) {
+                    records.push_back(record);
+                }
+            }
+            return true;
+        }
+
+        int64_t previous[SAMPLE_CSV_FIELD_COUNT];
+        int64_t values[SAMPLE_CSV_FIELD_COUNT];
+        bool synced = false;
+        while (pos < log.data.size()) {
+            bool keyFrame;
+            size_t size = decodeDeltaRecord(log.data.data() + pos, log.data.size() - pos, RECORD_FIELD_COUNT,
+                                            synced ? previous : NULL, values, keyFrame);
+            if (size == 0) {
+                synced = false;
+                pos++;
+                continue;
+            }
+            pos += size;
+            if (keyFrame || synced) {
+                memcpy(previous, values, sizeof(values));
+                synced = true;
+                dequantizeRecord(values, record);
+                records.push_back(record);
+            }
+        }
+        return true;
+    }
+
+    // CSV: las líneas que no son filas de datos (header) se saltan
+    log.data.push_back('\0');
+    char* line = (char*)log.data.data();
+    while (line != NULL && *line != '\0') {
+        char* next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        SampleRecord record;
+        if (parseCSVRow(line, record)) {
+            records.push_back(record);
+        }
+        line = next;
+    }
+    return true;
+}
+
+// Costo medio por registro: se repite la pasada hasta medir al menos 0.2 s
+template <typename Encode>
+static double nsPerRecord(const std::vector<SampleRecord>& records, Encode encode) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long passes = 0;
+    double seconds;
+    do {
+        for (size_t i = 0; i < records.size(); i++) {
+            encode(records[i], i);
+        }
+        passes++;
+        seconds = elapsedSeconds(start);
+    } while (seconds < 0.2);
+    return seconds * 1e9 / ((double)passes * records.size());
+}
+
+static int commandBench(const char* path, unsigned long interval) {
+    std::vector<SampleRecord> records;
+    if (!loadRecords(path, records)) {
+        return 1;
+    }
+    if (records.empty()) {
+        fprintf(stderr, "No hay registros en %s\n", path);
+        return 1;
+    }
+    if (interval == 0) {
+        interval = 1;
+    }
+
+    // Tamaños, con header de archivo incluido
+    char line[SAMPLE_CSV_MAX_LENGTH];
+    uint8_t buffer[SAMPLE_CSV_MAX_LENGTH];
+    int64_t values[SAMPLE_CSV_FIELD_COUNT];
+    int64_t previous[SAMPLE_CSV_FIELD_COUNT];
+
+    uint64_t csvBytes = formatSchemaCSVHeader(line, sizeof(line)) + 2;
+    uint64_t binaryBytes = binaryHeaderSize();
+    uint64_t deltaBytes = binaryHeaderSize();
+    unsigned long mismatches = 0;
+    std::vector<uint8_t> stream;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        int length = formatRecordCSV(records[i], line, sizeof(line));
+        csvBytes += length + 2;
+        binaryBytes += binaryRecordSize();
+
+        quantizeRecord(records[i], values);
+        size_t size = encodeDeltaRecord(values, i % interval == 0 ? NULL : previous, RECORD_FIELD_COUNT,
+                                        buffer, sizeof(buffer));
+        memcpy(previous, values, sizeof(values));
+        deltaBytes += size;
+        stream.insert(stream.end(), buffer, buffer + size);
+    }
+
+    // Ida y vuelta: la fila decodificada debe ser la misma que la original
+    size_t pos = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        bool keyFrame;
+        size_t size = decodeDeltaRecord(stream.data() + pos, stream.size() - pos, RECORD_FIELD_COUNT,
+                                        previous, values, keyFrame);
+        pos += size;
+        memcpy(previous, values, sizeof(values));
+
+        SampleRecord decoded;
+        char expected[SAMPLE_CSV_MAX_LENGTH];
+        dequantizeRecord(values, decoded);
+        formatRecordCSV(records[i], expected, sizeof(expected));
+        formatRecordCSV(decoded, line, sizeof(line));
+        if (size == 0 || strcmp(expected, line) != 0) {
+            mismatches++;
+        }
+    }
+
+    volatile size_t sink = 0;
+    double csvNs = nsPerRecord(records, [&](const SampleRecord& record, size_t) {
+        sink += formatRecordCSV(record, line, sizeof(line));
+    });
+    double binaryNs = nsPerRecord(records, [&](const SampleRecord& record, size_t) {
+        sink += encodeBinaryRecord(record, buffer, sizeof(buffer));
+    });
+    double deltaNs = nsPerRecord(records, [&](const SampleRecord& record, size_t i) {
+        quantizeRecord(record, values);
+        sink += encodeDeltaRecord(values, i % interval == 0 ? NULL : previous, RECORD_FIELD_COUNT,
+                                  buffer, sizeof(buffer));
+        memcpy(previous, values, sizeof(values));
+    });
+    size_t offset = 0;
+    double decodeNs = nsPerRecord(records, [&](const SampleRecord&, size_t i) {
+        if (i == 0) {
+            offset = 0;
+        }
+        bool keyFrame;
+        SampleRecord decoded;
+        offset += decodeDeltaRecord(stream.data() + offset, stream.size() - offset, RECORD_FIELD_COUNT,
+                                    previous, values, keyFrame);
+        memcpy(previous, values, sizeof(values));
+        dequantizeRecord(values, decoded);
+        sink += decoded.timestampMs;
+    });
+
+    double n = (double)records.size();
+    printf("%lu registros, key frame cada %lu\n", (unsigned long)records.size(), interval);
+    printf("%-10s %12s %10s %10s %14s\n", "Formato", "Bytes", "Bytes/reg", "vs CSV", "ns/reg (PC)");
+    printf("%-10s %12llu %10.1f %9.2fx %14.0f\n", "CSV", (unsigned long long)csvBytes, csvBytes / n, 1.0, csvNs);
+    printf("%-10s %12llu %10.1f %9.2fx %14.0f\n", "Binario", (unsigned long long)binaryBytes, binaryBytes / n,
+           (double)csvBytes / binaryBytes, binaryNs);
+    printf("%-10s %12llu %10.1f %9.2fx %14.0f\n", "Delta", (unsigned long long)deltaBytes, deltaBytes / n,
+           (double)csvBytes / deltaBytes, deltaNs);
+    printf("Decodificación delta: %.0f ns/registro\n", decodeNs);
+    printf("Ida y vuelta: %lu filas idénticas al CSV, %lu distintas\n",
+           (unsigned long)records.size() - mismatches, mismatches);
+    printf("(El costo en el equipo lo informa sd_stats: codificación prom/máx por registro)\n");
+    return mismatches == 0 ? 0 : 1;
+}
+
+static void usage() {
+    fprintf(stderr, "Uso:\n");
+    fprintf(stderr, "  usvlog info <log.bin>\n");
+    fprintf(stderr, "  usvlog csv <log.bin> [salida.csv]\n");
+    fprintf(stderr, "  usvlog salvage <imagen> <directorio>\n");
+    fprintf(stderr, "  usvlog bench <log.csv|log.bin> [intervalo de key frame, %d por defecto]\n",
+            SD_DELTA_KEYFRAME_INTERVAL);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    if (strcmp(argv[1], "salvage") == 0) {
+        if (argc < 4) {
+            usage();
+            return 1;
+        }
+        return commandSalvage(argv[2], argv[3]);
+    }
+
+    if (strcmp(argv[1], "bench") == 0) {
+        return commandBench(argv[2], argc >= 4 ? strtoul(argv[3], NULL, 10) : SD_DELTA_KEYFRAME_INTERVAL);
+    }
+
+    LogFile log;
+    if (!readFile(argv[2], log.data) || !parseHeader(log.data.data(), log.data.size(), log)) {
+        return 1;
+    }
+
+    if (strcmp(argv[1], "info") == 0) {
+        return commandInfo(log);
+    }
+
+    if (strcmp(argv[1], "csv") == 0) {
+        FILE* out = stdout;
+        if (argc >= 4) {
+            out = fopen(argv[3], "wb");
+            if (out == NULL) {
+                fprintf(stderr, "No se pudo crear %s\n", argv[3]);
+                return 1;
+            }
+        }
+        int result = commandCSV(log, out);
+        if (out != stdout) {
+            fclose(out);
+        }
+        return result;
+    }
+
+    usage();
+    return 1;
+}